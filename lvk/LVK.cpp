@@ -83,6 +83,14 @@ uint32_t lvk::getTextureBytesPerLayer(uint32_t width,
   return widthInBlocks * heightInBlocks * props.bytesPerBlock;
 }
 
+uint32_t lvk::getTextureBlockWidth(lvk::Format format) {
+  return std::max((uint32_t)properties[format].blockWidth, 1u);
+}
+
+uint32_t lvk::getTextureBlockHeight(lvk::Format format) {
+  return std::max((uint32_t)properties[format].blockHeight, 1u);
+}
+
 uint32_t lvk::calcNumMipLevels(uint32_t width, uint32_t height) {
   assert(width > 0);
   assert(height > 0);
@@ -138,6 +146,12 @@ void lvk::destroy(lvk::IDevice* device, lvk::BufferHandle handle) {
   }
 }
 
+void lvk::destroy(lvk::IDevice* device, const lvk::BufferSlice& slice) {
+  if (device) {
+    device->destroy(slice);
+  }
+}
+
 void lvk::destroy(lvk::IDevice* device, lvk::TextureHandle handle) {
   if (device) {
     device->destroy(handle);
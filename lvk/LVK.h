@@ -10,6 +10,7 @@
 #include <cstdarg>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <memory>
 #include <utility>
 
@@ -106,6 +107,40 @@ using SamplerHandle = lvk::Handle<struct Sampler>;
 using BufferHandle = lvk::Handle<struct Buffer>;
 using TextureHandle = lvk::Handle<struct Texture>;
 
+// a completion token of asynchronous GPU work (i.e. IDevice::uploadAsync()); an empty token is always complete
+struct SubmitHandle {
+  uint64_t handle = 0;
+  bool empty() const {
+    return handle == 0;
+  }
+};
+
+// a range of a large buffer shared with other slices (IDevice::createBufferSlice()); can be owned by a Holder<>
+struct BufferSlice {
+  BufferHandle buffer;
+  uint64_t allocation = 0; // opaque
+  size_t offset = 0;
+  size_t size = 0;
+  bool valid() const {
+    return buffer.valid();
+  }
+  bool empty() const {
+    return buffer.empty();
+  }
+};
+
+// transient per-frame memory (i.e. uniforms) from IDevice::allocateTransient(): persistently mapped, valid until the GPU
+// has finished the frame it was allocated in (frames end with a presenting IDevice::submit() or IDevice::endTransientFrame())
+struct TransientAllocation {
+  uint8_t* ptr = nullptr;
+  uint64_t gpuAddress = 0; // i.e. for push constants
+  BufferHandle buffer; // the same memory as `ptr` at `offset` (i.e. for vertex or index data)
+  size_t offset = 0;
+  bool valid() const {
+    return ptr != nullptr;
+  }
+};
+
 // forward declarations to access incomplete type IDevice
 void destroy(lvk::IDevice* device, lvk::ComputePipelineHandle handle);
 void destroy(lvk::IDevice* device, lvk::RenderPipelineHandle handle);
@@ -113,6 +148,7 @@ void destroy(lvk::IDevice* device, lvk::ShaderModuleHandle handle);
 void destroy(lvk::IDevice* device, lvk::SamplerHandle handle);
 void destroy(lvk::IDevice* device, lvk::BufferHandle handle);
 void destroy(lvk::IDevice* device, lvk::TextureHandle handle);
+void destroy(lvk::IDevice* device, const lvk::BufferSlice& slice);
 
 template<typename HandleType>
 class Holder final {
@@ -236,6 +272,8 @@ struct HWDeviceDesc {
 enum StorageType {
   StorageType_Device,
   StorageType_HostVisible,
+  // attachments whose contents never leave a render pass (i.e. MSAA): lazily allocated memory where the device has it;
+  // cmdBeginRendering() skips render passes which load, store, or resolve into them
   StorageType_Memoryless
 };
 
@@ -627,6 +665,13 @@ struct RenderPipelineDesc final {
   }
 };
 
+// the draw state which selects one of the pipelines compiled for a render pipeline (IDevice::prewarmRenderPipeline())
+struct RenderPipelineVariant final {
+  PrimitiveType topology = Primitive_Triangle;
+  DepthStencilState depthStencil = {}; // ICommandBuffer::cmdBindDepthStencilState()
+  bool depthBiasEnable = false; // ICommandBuffer::cmdSetDepthBias() has been called in this render pass
+};
+
 struct ComputePipelineDesc final {
   lvk::ShaderStages shaderStages;
   const char* debugName = "";
@@ -684,9 +729,19 @@ enum BufferUsageBits : uint8_t {
   BufferUsageBits_Indirect = 1 << 4,
 };
 
+// how the CPU accesses a buffer: selects the fastest memory type for it (overrides the placement implied by StorageType)
+enum BufferAccess : uint8_t {
+  BufferAccess_Default = 0, // derived from StorageType
+  BufferAccess_Static, // rarely updated: device-local memory, written via staging
+  BufferAccess_Stream, // rewritten often, read by the GPU: video memory via Resizable BAR if it has room, otherwise like Upload
+  BufferAccess_Upload, // written sequentially by the CPU: write-combined host-visible memory
+  BufferAccess_Readback, // read by the CPU: cached host-visible memory with random access
+};
+
 struct BufferDesc final {
   uint8_t usage = 0;
   StorageType storage = StorageType_HostVisible;
+  BufferAccess access = BufferAccess_Default;
   size_t size = 0;
   const void* data = nullptr;
   const char* debugName = "";
@@ -723,9 +778,16 @@ struct TextureDesc {
   const char* debugName = "";
 };
 
+// resources produced by previous commands: cmdDispatchThreadGroups() makes them accessible as storage images and storage
+// buffers; cmdBeginRendering() makes the textures sampled and the buffers readable by the draws (indirect, index, vertex,
+// shaders) - the stages are derived from the buffer usage
 struct Dependencies {
   enum { IGL_MAX_SUBMIT_DEPENDENCIES = 4 };
   TextureHandle textures[IGL_MAX_SUBMIT_DEPENDENCIES] = {};
+  // read and written by shaders (storage buffers): the writes are made visible to the subsequent commands
+  BufferHandle buffers[IGL_MAX_SUBMIT_DEPENDENCIES] = {};
+  // only read, so consecutive dispatches or render passes reading them need no barriers
+  BufferHandle buffersRead[IGL_MAX_SUBMIT_DEPENDENCIES] = {};
 };
 
 class ICommandBuffer {
@@ -745,7 +807,8 @@ class ICommandBuffer {
                                        const Dependencies& deps = Dependencies()) = 0;
 
   virtual void cmdBeginRendering(const lvk::RenderPass& renderPass,
-                                 const lvk::Framebuffer& desc) = 0;
+                                 const lvk::Framebuffer& desc,
+                                 const Dependencies& deps = Dependencies()) = 0;
   virtual void cmdEndRendering() = 0;
 
   virtual void cmdBindViewport(const Viewport& viewport) = 0;
@@ -757,6 +820,12 @@ class ICommandBuffer {
   virtual void cmdBindVertexBuffer(uint32_t index,
                                    BufferHandle buffer,
                                    size_t bufferOffset) = 0;
+  void cmdBindVertexBuffer(uint32_t index, const BufferSlice& slice, size_t offset = 0) {
+    if (!IGL_VERIFY(offset < slice.size)) {
+      return;
+    }
+    this->cmdBindVertexBuffer(index, slice.buffer, slice.offset + offset);
+  }
   virtual void cmdPushConstants(const void* data, size_t size, size_t offset = 0) = 0;
   template<typename Struct>
   void cmdPushConstants(const Struct& data) {
@@ -769,6 +838,17 @@ class ICommandBuffer {
                               IndexFormat indexFormat,
                               BufferHandle indexBuffer,
                               size_t indexBufferOffset) = 0;
+  void cmdDrawIndexed(PrimitiveType primitiveType,
+                      size_t indexCount,
+                      IndexFormat indexFormat,
+                      const BufferSlice& indexBuffer,
+                      size_t indexBufferOffset = 0) {
+    const size_t indexSize = indexFormat == IndexFormat_UI16 ? 2u : 4u;
+    if (!IGL_VERIFY(indexBufferOffset + indexCount * indexSize <= indexBuffer.size)) {
+      return;
+    }
+    this->cmdDrawIndexed(primitiveType, indexCount, indexFormat, indexBuffer.buffer, indexBuffer.offset + indexBufferOffset);
+  }
   virtual void cmdDrawIndirect(PrimitiveType primitiveType,
                                BufferHandle indirectBuffer,
                                size_t indirectBufferOffset,
@@ -791,11 +871,21 @@ class IDevice {
  public:
   virtual ~IDevice() = default;
 
-  virtual ICommandBuffer& acquireCommandBuffer() = 0;
+  // command buffers acquired for QueueType_Compute have to be submitted to QueueType_Compute
+  // multiple command buffers can be open at the same time and recorded on different threads; acquireCommandBuffer() is
+  // thread-safe but submit() and resource creation/destruction should stay on one thread (no other thread is recording);
+  // barriers are computed when they are recorded: command buffers which use the same texture or buffer have to be
+  // submitted in the order they were recorded in (i.e. one after another in a batch, as RenderGraph waves do)
+  virtual ICommandBuffer& acquireCommandBuffer(lvk::QueueType queueType = lvk::QueueType_Graphics) = 0;
 
   virtual void submit(const ICommandBuffer& commandBuffer,
                       lvk::QueueType queueType = lvk::QueueType_Graphics,
                       TextureHandle present = {}) = 0;
+  // submits an ordered batch of command buffers at once (they execute in this order); `present` is presented after all of them
+  virtual void submit(const ICommandBuffer* const* commandBuffers,
+                      uint32_t numCommandBuffers,
+                      lvk::QueueType queueType = lvk::QueueType_Graphics,
+                      TextureHandle present = {}) = 0;
 
   virtual Holder<BufferHandle> createBuffer(const BufferDesc& desc,
                                             Result* outResult = nullptr) = 0;
@@ -815,6 +905,10 @@ class IDevice {
   virtual Holder<ShaderModuleHandle> createShaderModule(const ShaderModuleDesc& desc,
                                                         Result* outResult = nullptr) = 0;
 
+  // does not block: the variants are compiled on background threads, so the first draws using them do not stall recording;
+  // until a variant is ready, the draws needing it wait or are skipped (depends on the backend configuration)
+  virtual void prewarmRenderPipeline(RenderPipelineHandle handle, const RenderPipelineVariant* variants, uint32_t numVariants) = 0;
+
   virtual void destroy(ComputePipelineHandle handle) = 0;
   virtual void destroy(RenderPipelineHandle handle) = 0;
   virtual void destroy(ShaderModuleHandle handle) = 0;
@@ -823,20 +917,68 @@ class IDevice {
   virtual void destroy(TextureHandle handle) = 0;
   virtual void destroy(Framebuffer& fb) = 0;
 
+  // sub-allocates `desc.size` bytes from a large buffer shared by all slices with the same usage, storage and access
+  virtual Holder<BufferSlice> createBufferSlice(const BufferDesc& desc, Result* outResult = nullptr) = 0;
+  // the range is reused after the GPU has finished all command buffers submitted so far
+  virtual void destroy(const BufferSlice& slice) = 0;
+
 #pragma region Buffer functions
+  // BufferAccess_Stream buffers in Resizable BAR memory are written right away like host-visible buffers (not ordered with
+  // the GPU work in flight); other device-local buffers are updated via staging copies ordered on the GPU
   virtual Result upload(BufferHandle handle, const void* data, size_t size, size_t offset = 0) = 0;
+  // does not block: `data` is copied into the staging memory right away and small uploads are coalesced into one command
+  // buffer which is submitted before the next submit() (or when waited for); returns an empty token for host-visible buffers
+  virtual SubmitHandle uploadAsync(BufferHandle handle, const void* data, size_t size, size_t offset = 0, Result* outResult = nullptr) = 0;
+  // does not block: `data` is written once the GPU has finished, at the latest by the time isReady() returns true or wait()
+  // returns; `completionHandler` is invoked right after that on the thread calling submit(), isReady() or wait()
+  virtual SubmitHandle download(BufferHandle handle,
+                                void* data,
+                                size_t size,
+                                size_t offset = 0,
+                                std::function<void()> completionHandler = nullptr,
+                                Result* outResult = nullptr) = 0;
   virtual uint8_t* getMappedPtr(BufferHandle handle) const = 0;
+  // upload() and download() do this automatically; required only after writing via getMappedPtr() into non-coherent memory
+  virtual void flushMappedMemory(BufferHandle handle, size_t offset, size_t size) const = 0;
   virtual uint64_t gpuAddress(BufferHandle handle, size_t offset = 0) const = 0;
+  Result upload(const BufferSlice& slice, const void* data, size_t size, size_t offset = 0) {
+    // the neighboring slices share the same buffer: do not write into them
+    if (!IGL_VERIFY(offset + size <= slice.size)) {
+      return Result(Result::Code::ArgumentOutOfRange, "Out of range of the buffer slice");
+    }
+    return this->upload(slice.buffer, data, size, slice.offset + offset);
+  }
+  uint64_t gpuAddress(const BufferSlice& slice, size_t offset = 0) const {
+    if (!IGL_VERIFY(offset <= slice.size)) {
+      return 0;
+    }
+    return this->gpuAddress(slice.buffer, slice.offset + offset);
+  }
+  // thread-safe; no buffers, no staging and no submits: the memory is recycled automatically
+  virtual TransientAllocation allocateTransient(size_t size, size_t alignment = 16) = 0;
+  // ends a transient frame for applications which do not present (headless or compute-only): call it after the last submit
+  // of the frame; the same threading rules as for submit()
+  virtual void endTransientFrame() = 0;
 #pragma endregion
 
 #pragma region Texture functions
   // data[] contains per-layer mip-stacks
   virtual Result upload(TextureHandle handle, const TextureRangeDesc& range, const void* data[]) const = 0;
+  // one mip level and layer of a 2D texture; the same completion rules as for buffers. Fails while the texture is used
+  // by an acquired command buffer which has not been submitted yet
+  virtual SubmitHandle download(TextureHandle handle,
+                                const TextureRangeDesc& range,
+                                void* data,
+                                std::function<void()> completionHandler = nullptr,
+                                Result* outResult = nullptr) = 0;
   virtual Dimensions getDimensions(TextureHandle handle) const = 0;
   virtual void generateMipmap(TextureHandle handle) const = 0;
   virtual Format getFormat(TextureHandle handle) const = 0;
 #pragma endregion
 
+  virtual bool isReady(SubmitHandle handle) const = 0;
+  virtual void wait(SubmitHandle handle) = 0;
+
   virtual TextureHandle getCurrentSwapchainTexture() = 0;
   virtual Format getSwapchainFormat() const = 0;
 
@@ -880,6 +1022,9 @@ namespace lvk {
 bool isDepthOrStencilFormat(lvk::Format format);
 uint32_t calcNumMipLevels(uint32_t width, uint32_t height);
 uint32_t getTextureBytesPerLayer(uint32_t width, uint32_t height, lvk::Format format, uint32_t level);
+// the width and height of a block in texels (1 for uncompressed formats)
+uint32_t getTextureBlockWidth(lvk::Format format);
+uint32_t getTextureBlockHeight(lvk::Format format);
 void logShaderSource(const char* text);
 
 } // namespace lvk
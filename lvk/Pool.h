@@ -1,5 +1,6 @@
 ﻿#pragma once
 
+#include <algorithm>
 #include <assert.h>
 #include <cstdint>
 #include <vector>
@@ -23,6 +24,9 @@ class Pool {
 
  public:
   std::vector<PoolEntry> objects_;
+  // when enabled, indices of all slots created or destroyed since the last call to consumeDirtySlots() are recorded
+  bool trackDirtySlots_ = false;
+  std::vector<uint32_t> dirtySlots_;
 
   Handle<ObjectType> create(ImplObjectType&& obj) {
     uint32_t idx = 0;
@@ -34,6 +38,9 @@ class Pool {
       idx = (uint32_t)objects_.size();
       objects_.emplace_back(obj);
     }
+    if (trackDirtySlots_) {
+      dirtySlots_.push_back(idx);
+    }
     numObjects_++;
     return Handle<ObjectType>(idx, objects_[idx].gen_);
   }
@@ -48,6 +55,9 @@ class Pool {
     objects_[index].gen_++;
     objects_[index].nextFree_ = freeListHead_;
     freeListHead_ = index;
+    if (trackDirtySlots_) {
+      dirtySlots_.push_back(index);
+    }
     numObjects_--;
   }
   const ImplObjectType* get(Handle<ObjectType> handle) const {
@@ -70,12 +80,24 @@ class Pool {
   }
   void clear() {
     objects_.clear();
+    dirtySlots_.clear();
     freeListHead_ = kListEndSentinel;
     numObjects_ = 0;
   }
   uint32_t numObjects() const {
     return numObjects_;
   }
+  bool hasDirtySlots() const {
+    return !dirtySlots_.empty();
+  }
+  // returns sorted unique indices of dirty slots and resets the dirty list
+  std::vector<uint32_t> consumeDirtySlots() {
+    std::vector<uint32_t> slots;
+    slots.swap(dirtySlots_);
+    std::sort(slots.begin(), slots.end());
+    slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+    return slots;
+  }
 };
 
 } // namespace lvk
@@ -0,0 +1,519 @@
+/*
+ * LightweightVK
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "RenderGraph.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+
+bool isCompatible(const lvk::TextureDesc& a, const lvk::TextureDesc& b) {
+  return a.type == b.type && a.format == b.format && a.dimensions.width == b.dimensions.width &&
+         a.dimensions.height == b.dimensions.height && a.dimensions.depth == b.dimensions.depth && a.numLayers == b.numLayers &&
+         a.numSamples == b.numSamples && a.usage == b.usage && a.numMipLevels == b.numMipLevels && a.storage == b.storage;
+}
+
+} // namespace
+
+namespace lvk {
+
+void RenderGraph::reset() {
+  textures_.clear();
+  buffers_.clear();
+  passes_.clear();
+  compiledPasses_.clear();
+  numCulledPasses_ = 0;
+}
+
+RenderGraphTexture RenderGraph::createTexture(const TextureDesc& desc) {
+  IGL_ASSERT_MSG(!desc.data, "Transient textures cannot have initial data");
+
+  textures_.push_back({.desc = desc});
+
+  return {(uint32_t)textures_.size()};
+}
+
+RenderGraphTexture RenderGraph::importTexture(TextureHandle handle) {
+  IGL_ASSERT(handle.valid());
+
+  textures_.push_back({.handle = handle, .isImported = true});
+
+  return {(uint32_t)textures_.size()};
+}
+
+RenderGraphBuffer RenderGraph::importBuffer(BufferHandle handle) {
+  IGL_ASSERT(handle.valid());
+
+  buffers_.push_back(handle);
+
+  return {(uint32_t)buffers_.size()};
+}
+
+void RenderGraph::addPass(RenderGraphPass pass) {
+  IGL_ASSERT_MSG(pass.queue != QueueType_Transfer, "Render graph passes run on the graphics or compute queues");
+
+  // the compute queue cannot sample images owned by the graphics queue (no queue family ownership transfers)
+  if (pass.queue == QueueType_Compute) {
+    for (RenderGraphTexture t : pass.sampled) {
+      if (!IGL_VERIFY(!t.valid())) {
+        LLOGW("Compute pass `%s` cannot sample textures\n", pass.name);
+        return;
+      }
+    }
+  }
+
+  bool hasAttachments = pass.depthStencil.valid();
+  for (uint32_t i = 0; i != LVK_MAX_COLOR_ATTACHMENTS; i++) {
+    hasAttachments = hasAttachments || pass.color[i].valid();
+  }
+
+  // cmdBeginRendering() makes its dependencies sampled and readable by the draws: storage images and written buffers
+  // are for dispatches outside of render passes
+  if (hasAttachments) {
+    for (RenderGraphTexture t : pass.storage) {
+      if (!IGL_VERIFY(!t.valid())) {
+        LLOGW("Pass `%s` with attachments cannot have storage textures\n", pass.name);
+        return;
+      }
+    }
+    for (RenderGraphBuffer b : pass.writeBuffers) {
+      if (!IGL_VERIFY(!b.valid())) {
+        LLOGW("Pass `%s` with attachments cannot write buffers\n", pass.name);
+        return;
+      }
+    }
+  }
+
+  passes_.push_back(std::move(pass));
+}
+
+TextureHandle RenderGraph::getTexture(RenderGraphTexture texture) const {
+  if (!texture.valid()) {
+    return {};
+  }
+
+  IGL_ASSERT(texture.id <= textures_.size());
+
+  return textures_[texture.id - 1].handle;
+}
+
+BufferHandle RenderGraph::getBuffer(RenderGraphBuffer buffer) const {
+  if (!buffer.valid()) {
+    return {};
+  }
+
+  IGL_ASSERT(buffer.id <= buffers_.size());
+
+  return buffers_[buffer.id - 1];
+}
+
+// fn(RenderGraphTexture texture, bool isRead, bool isWrite)
+template<typename Fn>
+void RenderGraph::forEachTexture(const RenderGraphPass& pass, Fn&& fn) const {
+  auto visit = [&fn](RenderGraphTexture texture, bool isRead, bool isWrite) {
+    if (texture.valid()) {
+      fn(texture, isRead, isWrite);
+    }
+  };
+
+  const RenderPass& rp = pass.renderPass;
+
+  for (uint32_t i = 0; i != LVK_MAX_COLOR_ATTACHMENTS; i++) {
+    visit(pass.color[i], rp.color[i].loadOp == LoadOp_Load, true);
+    visit(pass.resolve[i], false, true);
+  }
+  visit(pass.depthStencil, rp.depth.loadOp == LoadOp_Load || rp.stencil.loadOp == LoadOp_Load, true);
+
+  for (RenderGraphTexture t : pass.sampled) {
+    visit(t, true, false);
+  }
+  for (RenderGraphTexture t : pass.storage) {
+    visit(t, true, true);
+  }
+}
+
+// fn(RenderGraphBuffer buffer, bool isWrite)
+template<typename Fn>
+void RenderGraph::forEachBuffer(const RenderGraphPass& pass, Fn&& fn) const {
+  for (RenderGraphBuffer b : pass.readBuffers) {
+    if (b.valid()) {
+      fn(b, false);
+    }
+  }
+  for (RenderGraphBuffer b : pass.writeBuffers) {
+    if (b.valid()) {
+      fn(b, true);
+    }
+  }
+}
+
+void RenderGraph::cull() {
+  IGL_PROFILER_FUNCTION();
+
+  // walk backwards: a pass is alive if it writes something observable outside of the graph or read by an alive pass
+  std::vector<bool> isNeeded(textures_.size(), false);
+  std::vector<bool> isAlive(passes_.size(), false);
+
+  for (size_t i = passes_.size(); i-- > 0;) {
+    const RenderGraphPass& pass = passes_[i];
+
+    bool alive = pass.hasSideEffects;
+
+    forEachTexture(pass, [&](RenderGraphTexture t, bool, bool isWrite) {
+      if (isWrite && (textures_[t.id - 1].isImported || isNeeded[t.id - 1])) {
+        alive = true;
+      }
+    });
+    // all buffers are imported
+    forEachBuffer(pass, [&](RenderGraphBuffer, bool isWrite) {
+      if (isWrite) {
+        alive = true;
+      }
+    });
+
+    if (!alive) {
+      continue;
+    }
+
+    isAlive[i] = true;
+
+    // overwritten textures are not needed before this pass...
+    forEachTexture(pass, [&](RenderGraphTexture t, bool isRead, bool isWrite) {
+      if (isWrite && !isRead) {
+        isNeeded[t.id - 1] = false;
+      }
+    });
+    // ...unless they are read here
+    forEachTexture(pass, [&](RenderGraphTexture t, bool isRead, bool) {
+      if (isRead) {
+        isNeeded[t.id - 1] = true;
+      }
+    });
+  }
+
+  compiledPasses_.clear();
+
+  for (uint32_t i = 0; i != passes_.size(); i++) {
+    if (isAlive[i]) {
+      compiledPasses_.push_back({.pass = i});
+    }
+  }
+
+  numCulledPasses_ = uint32_t(passes_.size() - compiledPasses_.size());
+}
+
+void RenderGraph::assignTextures() {
+  IGL_PROFILER_FUNCTION();
+
+  for (TextureNode& node : textures_) {
+    node.isUsed = false;
+  }
+
+  for (uint32_t i = 0; i != compiledPasses_.size(); i++) {
+    forEachTexture(passes_[compiledPasses_[i].pass], [&](RenderGraphTexture t, bool, bool) {
+      TextureNode& node = textures_[t.id - 1];
+      if (!node.isUsed) {
+        node.isUsed = true;
+        node.firstPass = i;
+      }
+      node.lastPass = i;
+    });
+  }
+
+  // transient textures in the order of their first use
+  std::vector<uint32_t> transients;
+  transients.reserve(textures_.size());
+
+  for (uint32_t i = 0; i != textures_.size(); i++) {
+    if (!textures_[i].isImported && textures_[i].isUsed) {
+      transients.push_back(i);
+    }
+  }
+
+  std::stable_sort(transients.begin(), transients.end(), [this](uint32_t a, uint32_t b) {
+    return textures_[a].firstPass < textures_[b].firstPass;
+  });
+
+  for (PhysicalTexture& p : physicalTextures_) {
+    p.isAssigned = false;
+  }
+
+  // share a texture between transient textures whose lifetimes [firstPass...lastPass] do not overlap
+  for (uint32_t idx : transients) {
+    TextureNode& node = textures_[idx];
+
+    size_t physical = 0;
+
+    while (physical != physicalTextures_.size()) {
+      const PhysicalTexture& p = physicalTextures_[physical];
+      if (isCompatible(p.desc, node.desc) && (!p.isAssigned || p.lastPass < node.firstPass)) {
+        break;
+      }
+      physical++;
+    }
+
+    if (physical == physicalTextures_.size()) {
+      Result result;
+      Holder<TextureHandle> texture = device_.createTexture(node.desc, node.desc.debugName, &result);
+      if (!IGL_VERIFY(result.isOk())) {
+        continue;
+      }
+      physicalTextures_.push_back({.texture = std::move(texture), .desc = node.desc});
+    }
+
+    PhysicalTexture& p = physicalTextures_[physical];
+
+    p.isAssigned = true;
+    p.lastPass = node.lastPass;
+    node.handle = p.texture;
+  }
+
+  // the textures which are no longer used are released (the device defers their destruction)
+  physicalTextures_.erase(
+      std::remove_if(physicalTextures_.begin(), physicalTextures_.end(), [](const PhysicalTexture& p) { return !p.isAssigned; }),
+      physicalTextures_.end());
+}
+
+void RenderGraph::scheduleTransitions() {
+  IGL_PROFILER_FUNCTION();
+
+  // keyed by the actual textures: transient textures backed by the same pooled texture share their state
+  struct TextureState {
+    int32_t lastWriter = -1;
+    bool isReadable = false;
+  };
+  std::unordered_map<uint32_t, TextureState> states;
+
+  for (uint32_t i = 0; i != compiledPasses_.size(); i++) {
+    CompiledPass& cp = compiledPasses_[i];
+    const RenderGraphPass& pass = passes_[cp.pass];
+
+    for (RenderGraphTexture t : pass.sampled) {
+      const TextureHandle handle = getTexture(t);
+      if (!handle) {
+        continue;
+      }
+      TextureState& state = states[handle.index()];
+      if (state.isReadable) {
+        continue;
+      }
+      state.isReadable = true;
+      // transition right after the last write on the same queue; otherwise the consumer transitions the texture itself
+      if (state.lastWriter >= 0 && passes_[compiledPasses_[state.lastWriter].pass].queue == pass.queue) {
+        compiledPasses_[state.lastWriter].transitionsAfter.push_back(handle);
+      } else {
+        cp.transitionsBefore.push_back(handle);
+      }
+    }
+
+    forEachTexture(pass, [&](RenderGraphTexture t, bool, bool isWrite) {
+      const TextureHandle handle = getTexture(t);
+      if (isWrite && handle) {
+        states[handle.index()] = {.lastWriter = int32_t(i)};
+      }
+    });
+  }
+
+  // passes which transition the same textures or buffers have to be recorded in the submission order
+  std::unordered_map<uint64_t, uint32_t> nextWave;
+  std::vector<uint64_t> touched;
+
+  const uint64_t kBufferKey = 1ull << 32;
+
+  for (CompiledPass& cp : compiledPasses_) {
+    touched.clear();
+    forEachTexture(passes_[cp.pass], [&](RenderGraphTexture t, bool, bool isWrite) {
+      const TextureHandle handle = getTexture(t);
+      if (isWrite && handle) {
+        touched.push_back(handle.index());
+      }
+    });
+    for (TextureHandle handle : cp.transitionsBefore) {
+      touched.push_back(handle.index());
+    }
+    for (TextureHandle handle : cp.transitionsAfter) {
+      touched.push_back(handle.index());
+    }
+    forEachBuffer(passes_[cp.pass], [&](RenderGraphBuffer b, bool) {
+      touched.push_back(kBufferKey | getBuffer(b).index());
+    });
+
+    cp.wave = 0;
+    for (uint64_t key : touched) {
+      cp.wave = std::max(cp.wave, nextWave[key]);
+    }
+    for (uint64_t key : touched) {
+      nextWave[key] = cp.wave + 1;
+    }
+  }
+}
+
+void RenderGraph::recordPass(const CompiledPass& compiledPass, ICommandBuffer& buffer) const {
+  IGL_PROFILER_FUNCTION();
+
+  const RenderGraphPass& pass = passes_[compiledPass.pass];
+
+  buffer.cmdPushDebugGroupLabel(pass.name);
+
+  for (TextureHandle handle : compiledPass.transitionsBefore) {
+    buffer.transitionToShaderReadOnly(handle);
+  }
+
+  Framebuffer framebuffer = {
+      .depthStencil = {.texture = getTexture(pass.depthStencil)},
+      .debugName = pass.name,
+  };
+
+  bool hasAttachments = !framebuffer.depthStencil.texture.empty();
+
+  for (uint32_t i = 0; i != LVK_MAX_COLOR_ATTACHMENTS; i++) {
+    framebuffer.color[i] = {.texture = getTexture(pass.color[i]), .resolveTexture = getTexture(pass.resolve[i])};
+    hasAttachments = hasAttachments || pass.color[i].valid();
+  }
+
+  Dependencies deps;
+  {
+    uint32_t numTextures = 0;
+    uint32_t numBuffers = 0;
+    uint32_t numBuffersRead = 0;
+    for (RenderGraphTexture t : pass.storage) {
+      if (t.valid()) {
+        deps.textures[numTextures++] = getTexture(t);
+      }
+    }
+    for (RenderGraphBuffer b : pass.writeBuffers) {
+      if (b.valid()) {
+        deps.buffers[numBuffers++] = getBuffer(b);
+      }
+    }
+    for (RenderGraphBuffer b : pass.readBuffers) {
+      if (b.valid()) {
+        deps.buffersRead[numBuffersRead++] = getBuffer(b);
+      }
+    }
+  }
+
+  if (hasAttachments) {
+    buffer.cmdBeginRendering(pass.renderPass, framebuffer, deps);
+    deps = {};
+  }
+  if (pass.execute) {
+    pass.execute(buffer, deps);
+  }
+  if (hasAttachments) {
+    buffer.cmdEndRendering();
+  }
+
+  for (TextureHandle handle : compiledPass.transitionsAfter) {
+    buffer.transitionToShaderReadOnly(handle);
+  }
+
+  buffer.cmdPopDebugGroupLabel();
+}
+
+void RenderGraph::execute(TextureHandle present, const ParallelFor& parallelFor) {
+  IGL_PROFILER_FUNCTION();
+
+  cull();
+  assignTextures();
+  scheduleTransitions();
+
+  // the last graphics submit presents
+  uint32_t presentPass = ~0u;
+
+  if (present) {
+    for (uint32_t i = 0; i != compiledPasses_.size(); i++) {
+      if (passes_[compiledPasses_[i].pass].queue == QueueType_Graphics) {
+        presentPass = i;
+      }
+    }
+    IGL_ASSERT_MSG(presentPass != ~0u, "Nothing to present: no graphics passes are alive");
+  }
+
+  std::vector<uint32_t> tasks;
+  std::vector<const ICommandBuffer*> batch;
+
+  const uint32_t numPasses = (uint32_t)compiledPasses_.size();
+
+  for (uint32_t begin = 0; begin != numPasses;) {
+    // a segment ends with a pass which has `afterSubmit`: the next passes are recorded after it has been invoked
+    uint32_t end = begin;
+    while (end != numPasses) {
+      if (passes_[compiledPasses_[end++].pass].afterSubmit) {
+        break;
+      }
+    }
+
+    if (parallelFor) {
+      uint32_t numWaves = 0;
+      for (uint32_t i = begin; i != end; i++) {
+        CompiledPass& cp = compiledPasses_[i];
+        cp.buffer = &device_.acquireCommandBuffer(passes_[cp.pass].queue);
+        numWaves = std::max(numWaves, cp.wave + 1);
+      }
+      for (uint32_t wave = 0; wave != numWaves; wave++) {
+        tasks.clear();
+        for (uint32_t i = begin; i != end; i++) {
+          const CompiledPass& cp = compiledPasses_[i];
+          if (cp.wave != wave) {
+            continue;
+          }
+          if (passes_[cp.pass].isThreadSafe) {
+            tasks.push_back(i);
+          } else {
+            // no other thread is recording at this point
+            recordPass(cp, *cp.buffer);
+          }
+        }
+        if (!tasks.empty()) {
+          parallelFor((uint32_t)tasks.size(), [this, &tasks](uint32_t task) {
+            const CompiledPass& cp = compiledPasses_[tasks[task]];
+            recordPass(cp, *cp.buffer);
+          });
+        }
+      }
+    }
+
+    // consecutive passes on the same queue go into one submit
+    for (uint32_t i = begin; i != end;) {
+      const QueueType queue = passes_[compiledPasses_[i].pass].queue;
+
+      uint32_t j = i;
+      while (j != end && passes_[compiledPasses_[j].pass].queue == queue) {
+        j++;
+      }
+
+      const TextureHandle presentTexture = presentPass >= i && presentPass < j ? present : TextureHandle{};
+
+      if (parallelFor) {
+        batch.clear();
+        for (uint32_t k = i; k != j; k++) {
+          batch.push_back(compiledPasses_[k].buffer);
+          compiledPasses_[k].buffer = nullptr;
+        }
+        device_.submit(batch.data(), (uint32_t)batch.size(), queue, presentTexture);
+      } else {
+        ICommandBuffer& buffer = device_.acquireCommandBuffer(queue);
+        for (uint32_t k = i; k != j; k++) {
+          recordPass(compiledPasses_[k], buffer);
+        }
+        device_.submit(buffer, queue, presentTexture);
+      }
+
+      i = j;
+    }
+
+    if (const std::function<void()>& afterSubmit = passes_[compiledPasses_[end - 1].pass].afterSubmit) {
+      afterSubmit();
+    }
+
+    begin = end;
+  }
+}
+
+} // namespace lvk
@@ -0,0 +1,146 @@
+/*
+ * LightweightVK
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include <lvk/LVK.h>
+
+namespace lvk {
+
+// a texture or a buffer used by the passes of a RenderGraph; valid until RenderGraph::reset()
+struct RenderGraphTexture {
+  uint32_t id = 0;
+  bool valid() const {
+    return id != 0;
+  }
+};
+
+struct RenderGraphBuffer {
+  uint32_t id = 0;
+  bool valid() const {
+    return id != 0;
+  }
+};
+
+struct RenderGraphPass final {
+  enum { kMaxResources = 4 };
+
+  const char* name = "";
+  lvk::QueueType queue = lvk::QueueType_Graphics;
+  // passes with attachments are wrapped into cmdBeginRendering()/cmdEndRendering() by the graph
+  lvk::RenderPass renderPass = {};
+  RenderGraphTexture color[LVK_MAX_COLOR_ATTACHMENTS] = {};
+  RenderGraphTexture resolve[LVK_MAX_COLOR_ATTACHMENTS] = {};
+  RenderGraphTexture depthStencil = {};
+  // sampled in shaders: the graph transitions them after their last write (graphics passes only: sampled images are
+  // owned by the graphics queue)
+  RenderGraphTexture sampled[kMaxResources] = {};
+  // read and written by compute shaders (passes without attachments only)
+  RenderGraphTexture storage[kMaxResources] = {};
+  // passes with attachments: `readBuffers` are made readable by the draws and `writeBuffers` are not allowed
+  RenderGraphBuffer readBuffers[kMaxResources] = {};
+  RenderGraphBuffer writeBuffers[kMaxResources] = {};
+  // passes which write neither imported resources nor anything read by other passes are culled
+  bool hasSideEffects = false;
+  // false: recorded on the thread calling RenderGraph::execute() (i.e. the pass creates resources)
+  bool isThreadSafe = true;
+  // `deps` are built from `storage`, `readBuffers` and `writeBuffers`: compute passes pass them to
+  // cmdDispatchThreadGroups(); they are empty for passes with attachments (cmdBeginRendering() takes them)
+  std::function<void(lvk::ICommandBuffer& buffer, const lvk::Dependencies& deps)> execute;
+  // ends a submit batch; invoked on the thread calling RenderGraph::execute() right after the batch has been submitted
+  std::function<void()> afterSubmit;
+};
+
+/**
+ * @brief A frame graph on top of IDevice: passes declare the textures and buffers they use and the graph
+ *
+ * - culls passes whose results are never used;
+ * - places texture transitions between the passes which write and sample textures, and derives the Dependencies of
+ *   every pass from the resources it declares;
+ * - backs transient textures with pooled textures: transient textures with identical descriptions share one
+ *   texture if their lifetimes do not overlap, and the textures are reused by the next frames. This is not
+ *   memory aliasing: transient textures with different descriptions always get separate allocations;
+ * - submits consecutive passes on the same queue as one batch.
+ *
+ * The graph is rebuilt every frame: reset(), create or import resources, addPass(), execute().
+ */
+class RenderGraph final {
+ public:
+  // runs task(0)...task(numTasks-1) on worker threads and returns when all of them have finished
+  using ParallelFor = std::function<void(uint32_t numTasks, const std::function<void(uint32_t task)>& task)>;
+
+  explicit RenderGraph(lvk::IDevice& device) : device_(device) {}
+  ~RenderGraph() = default;
+  RenderGraph(const RenderGraph&) = delete;
+  RenderGraph& operator=(const RenderGraph&) = delete;
+
+  // removes all passes and resources; the textures backing transient textures are kept for the next frame
+  void reset();
+
+  RenderGraphTexture createTexture(const lvk::TextureDesc& desc);
+  RenderGraphTexture importTexture(lvk::TextureHandle handle);
+  RenderGraphBuffer importBuffer(lvk::BufferHandle handle);
+
+  void addPass(RenderGraphPass pass);
+
+  // `parallelFor` records independent passes on worker threads: each pass gets its own command buffer
+  void execute(lvk::TextureHandle present = {}, const ParallelFor& parallelFor = nullptr);
+
+  // valid while the passes are executed and until the next reset()
+  lvk::TextureHandle getTexture(RenderGraphTexture texture) const;
+  lvk::BufferHandle getBuffer(RenderGraphBuffer buffer) const;
+
+  uint32_t getNumCulledPasses() const {
+    return numCulledPasses_;
+  }
+
+ private:
+  struct TextureNode {
+    lvk::TextureDesc desc = {};
+    lvk::TextureHandle handle;
+    bool isImported = false;
+    uint32_t firstPass = 0; // alive passes only
+    uint32_t lastPass = 0;
+    bool isUsed = false;
+  };
+  struct PhysicalTexture {
+    lvk::Holder<lvk::TextureHandle> texture;
+    lvk::TextureDesc desc = {};
+    uint32_t lastPass = 0; // the last pass of the transient textures assigned in this frame
+    bool isAssigned = false;
+  };
+  struct CompiledPass {
+    uint32_t pass = 0; // index in passes_
+    std::vector<lvk::TextureHandle> transitionsBefore; // sampled textures, transitioned in this pass
+    std::vector<lvk::TextureHandle> transitionsAfter; // written textures, transitioned for the next passes
+    uint32_t wave = 0; // passes in one wave do not transition the same textures and can be recorded in parallel
+    lvk::ICommandBuffer* buffer = nullptr;
+  };
+
+  template<typename Fn>
+  void forEachTexture(const RenderGraphPass& pass, Fn&& fn) const;
+  template<typename Fn>
+  void forEachBuffer(const RenderGraphPass& pass, Fn&& fn) const;
+  void cull();
+  void assignTextures();
+  void scheduleTransitions();
+  void recordPass(const CompiledPass& compiledPass, lvk::ICommandBuffer& buffer) const;
+
+ private:
+  lvk::IDevice& device_;
+  std::vector<TextureNode> textures_; // [RenderGraphTexture::id - 1]
+  std::vector<lvk::BufferHandle> buffers_; // [RenderGraphBuffer::id - 1]
+  std::vector<RenderGraphPass> passes_;
+  std::vector<CompiledPass> compiledPasses_; // alive passes in submission order
+  std::vector<PhysicalTexture> physicalTextures_;
+  uint32_t numCulledPasses_ = 0;
+};
+
+} // namespace lvk
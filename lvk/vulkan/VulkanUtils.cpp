@@ -24,6 +24,24 @@ VkSemaphore lvk::createSemaphore(VkDevice device, const char* debugName) {
   return semaphore;
 }
 
+VkSemaphore lvk::createSemaphoreTimeline(VkDevice device, uint64_t initialValue, const char* debugName) {
+  const VkSemaphoreTypeCreateInfo semaphoreTypeCreateInfo = {
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+      .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+      .initialValue = initialValue,
+  };
+  const VkSemaphoreCreateInfo ci = {
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+      .pNext = &semaphoreTypeCreateInfo,
+      .flags = 0,
+  };
+  VkSemaphore semaphore = VK_NULL_HANDLE;
+  VK_ASSERT(vkCreateSemaphore(device, &ci, nullptr, &semaphore));
+  VK_ASSERT(
+      ivkSetDebugObjectName(device, VK_OBJECT_TYPE_SEMAPHORE, (uint64_t)semaphore, debugName));
+  return semaphore;
+}
+
 VkFence lvk::createFence(VkDevice device, const char* debugName) {
   const VkFenceCreateInfo ci = {
       .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
@@ -62,9 +80,12 @@ uint32_t lvk::findQueueFamilyIndex(VkPhysicalDevice physDev, VkQueueFlags flags)
       return q;
   }
 
-  // dedicated queue for transfer
+  // dedicated queue for transfer (prefer transfer-only queue families)
   if (flags & VK_QUEUE_TRANSFER_BIT) {
-    const uint32_t q = findDedicatedQueueFamilyIndex(flags, VK_QUEUE_GRAPHICS_BIT);
+    uint32_t q = findDedicatedQueueFamilyIndex(flags, VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+    if (q != DeviceQueues::INVALID)
+      return q;
+    q = findDedicatedQueueFamilyIndex(flags, VK_QUEUE_GRAPHICS_BIT);
     if (q != DeviceQueues::INVALID)
       return q;
   }
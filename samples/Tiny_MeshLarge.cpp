@@ -48,12 +48,15 @@
 #include <lvk/LVK.h>
 #include <lvk/HelpersGLFW.h>
 #include <lvk/HelpersImGui.h>
+#include <lvk/RenderGraph.h>
 
 constexpr uint32_t kMeshCacheVersion = 0xC0DE0009;
 constexpr uint32_t kMaxTextures = 512;
 constexpr int kNumSamplesMSAA = 8;
 constexpr bool kEnableCompression = true;
 constexpr bool kPreferIntegratedGPU = false;
+// record independent render graph passes on worker threads (set to false to compare with single-threaded recording)
+constexpr bool kRecordOnWorkerThreads = true;
 #if defined(NDEBUG)
 constexpr bool kEnableValidationLayers = false;
 #else
@@ -411,11 +414,13 @@ int width_ = 0;
 int height_ = 0;
 FramesPerSecondCounter fps_;
 
-constexpr uint32_t kNumBufferedFrames = 3;
-
 std::unique_ptr<lvk::IDevice> device_;
 lvk::Framebuffer fbMain_; // swapchain
-lvk::Framebuffer fbOffscreen_;
+// transient attachments of the offscreen pass: the render graph backs them with its own textures
+lvk::TextureDesc descOffscreenColor_;
+lvk::TextureDesc descOffscreenDepth_;
+lvk::TextureDesc descOffscreenResolve_;
+std::unique_ptr<lvk::RenderGraph> renderGraph_;
 lvk::Framebuffer fbShadowMap_;
 lvk::Holder<lvk::ComputePipelineHandle> computePipelineState_Grayscale_;
 lvk::Holder<lvk::RenderPipelineHandle> renderPipelineState_Mesh_;
@@ -425,7 +430,6 @@ lvk::Holder<lvk::RenderPipelineHandle> renderPipelineState_Skybox_;
 lvk::Holder<lvk::RenderPipelineHandle> renderPipelineState_Fullscreen_;
 lvk::Holder<lvk::BufferHandle> vb0_, ib0_; // buffers for vertices and indices
 lvk::Holder<lvk::BufferHandle> sbMaterials_; // storage buffer for materials
-std::vector<lvk::Holder<lvk::BufferHandle>> ubPerFrame_, ubPerFrameShadow_, ubPerObject_;
 lvk::Holder<lvk::SamplerHandle> sampler_;
 lvk::Holder<lvk::SamplerHandle> samplerShadow_;
 lvk::Holder<lvk::TextureHandle> textureDummyWhite_;
@@ -535,6 +539,9 @@ std::atomic<bool> loaderShouldExit_ = false;
 std::atomic<uint32_t> remainingMaterialsToLoad_ = 0;
 std::unique_ptr<tf::Executor> loaderPool_ =
     std::make_unique<tf::Executor>(std::max(2u, std::thread::hardware_concurrency() / 2));
+// records command buffers (a separate pool so that recording does not wait for the texture loader)
+std::unique_ptr<tf::Executor> renderPool_ = std::make_unique<tf::Executor>(2u);
+double cpuRecordingTimeMs_ = 0; // time to record and submit all passes of the last frame
 
 static bool endsWith(const std::string& str, const std::string& suffix) {
   return str.size() >= suffix.size() &&
@@ -592,26 +599,6 @@ void initIGL() {
         nullptr);
   }
 
-  // create an Uniform buffers to store uniforms for 2 objects
-  for (uint32_t i = 0; i != kNumBufferedFrames; i++) {
-    ubPerFrame_.push_back(device_->createBuffer({.usage = lvk::BufferUsageBits_Uniform,
-                                                 .storage = lvk::StorageType_HostVisible,
-                                                 .size = sizeof(UniformsPerFrame),
-                                                 .debugName = "Buffer: uniforms (per frame)"},
-                                                nullptr));
-    ubPerFrameShadow_.push_back(
-        device_->createBuffer({.usage = lvk::BufferUsageBits_Uniform,
-                               .storage = lvk::StorageType_HostVisible,
-                               .size = sizeof(UniformsPerFrame),
-                               .debugName = "Buffer: uniforms (per frame shadow)"},
-                              nullptr));
-    ubPerObject_.push_back(device_->createBuffer({.usage = lvk::BufferUsageBits_Uniform,
-                                                  .storage = lvk::StorageType_HostVisible,
-                                                  .size = sizeof(UniformsPerObject),
-                                                  .debugName = "Buffer: uniforms (per object)"},
-                                                 nullptr));
-  }
-
   depthStencilState_ = {.compareOp = lvk::CompareOp_Less, .isDepthWriteEnabled = true};
   depthStencilStateLEqual_ = {.compareOp = lvk::CompareOp_LessEqual, .isDepthWriteEnabled = true};
 
@@ -641,7 +628,7 @@ void initIGL() {
       }},
       .depth = {
           .loadOp = lvk::LoadOp_Clear,
-          .storeOp = lvk::StoreOp_Store,
+          .storeOp = lvk::StoreOp_DontCare,
           .clearDepth = 1.0f,
       }};
 
@@ -944,8 +931,8 @@ void createRenderPipelines() {
         .vertexInput = vdesc,
         .shaderStages = device_->createShaderStages(
             kCodeVS, "Shader Module: main (vert)", kCodeFS, "Shader Module: main (frag)"),
-        .color = {{.format = device_->getFormat(fbOffscreen_.color[0].texture)}},
-        .depthFormat = device_->getFormat(fbOffscreen_.depthStencil.texture),
+        .color = {{.format = descOffscreenColor_.format}},
+        .depthFormat = descOffscreenDepth_.format,
         .cullMode = lvk::CullMode_Back,
         .frontFaceWinding = lvk::WindingMode_CCW,
         .samplesCount = kNumSamplesMSAA,
@@ -1001,9 +988,9 @@ void createRenderPipelineSkybox() {
       .shaderStages = device_->createShaderStages(
           kSkyboxVS, "Shader Module: skybox (vert)", kSkyboxFS, "Shader Module: skybox (frag)"),
       .color = {{
-          .format = device_->getFormat(fbOffscreen_.color[0].texture),
+          .format = descOffscreenColor_.format,
       }},
-      .depthFormat = device_->getFormat(fbOffscreen_.depthStencil.texture),
+      .depthFormat = descOffscreenDepth_.format,
       .cullMode = lvk::CullMode_Front,
       .frontFaceWinding = lvk::WindingMode_CCW,
       .samplesCount = kNumSamplesMSAA,
@@ -1013,6 +1000,19 @@ void createRenderPipelineSkybox() {
   renderPipelineState_Skybox_ = device_->createRenderPipeline(desc, nullptr);
 }
 
+// compile the pipelines for the draw states used in render() in the background: no hitches on the first frame
+void prewarmRenderPipelines() {
+  const lvk::RenderPipelineVariant variantDepthLess = {.depthStencil = depthStencilState_};
+  const lvk::RenderPipelineVariant variantDepthLEqual = {.depthStencil = depthStencilStateLEqual_};
+  const lvk::RenderPipelineVariant variantNoDepth = {};
+
+  device_->prewarmRenderPipeline(renderPipelineState_Shadow_, &variantDepthLess, 1);
+  device_->prewarmRenderPipeline(renderPipelineState_Mesh_, &variantDepthLess, 1);
+  device_->prewarmRenderPipeline(renderPipelineState_MeshWireframe_, &variantDepthLess, 1);
+  device_->prewarmRenderPipeline(renderPipelineState_Skybox_, &variantDepthLEqual, 1);
+  device_->prewarmRenderPipeline(renderPipelineState_Fullscreen_, &variantNoDepth, 1);
+}
+
 void createShadowMap() {
   const uint32_t w = 4096;
   const uint32_t h = 4096;
@@ -1029,10 +1029,10 @@ void createShadowMap() {
   };
 }
 
-void createOffscreenFramebuffer() {
+void createOffscreenTextureDescs() {
   const uint32_t w = width_;
   const uint32_t h = height_;
-  lvk::TextureDesc descDepth = {
+  descOffscreenDepth_ = {
       .type = lvk::TextureType_2D,
       .format = lvk::Format_Z_UN24,
       .dimensions = {w, h},
@@ -1041,16 +1041,17 @@ void createOffscreenFramebuffer() {
       .debugName = "Offscreen framebuffer (d)",
   };
   if (kNumSamplesMSAA > 1) {
-    descDepth.usage = lvk::TextureUsageBits_Attachment;
-    descDepth.numSamples = kNumSamplesMSAA;
-    descDepth.numMipLevels = 1;
+    descOffscreenDepth_.usage = lvk::TextureUsageBits_Attachment;
+    descOffscreenDepth_.numSamples = kNumSamplesMSAA;
+    descOffscreenDepth_.numMipLevels = 1;
+    descOffscreenDepth_.storage = lvk::StorageType_Memoryless;
   }
 
   const uint8_t usage = lvk::TextureUsageBits_Attachment | lvk::TextureUsageBits_Sampled |
                         lvk::TextureUsageBits_Storage;
   const lvk::Format format = lvk::Format_RGBA_UN8;
 
-  lvk::TextureDesc descColor = {
+  descOffscreenColor_ = {
       .type = lvk::TextureType_2D,
       .format = format,
       .dimensions = {w, h},
@@ -1059,31 +1060,23 @@ void createOffscreenFramebuffer() {
       .debugName = "Offscreen framebuffer (color)",
   };
   if (kNumSamplesMSAA > 1) {
-    descColor.usage = lvk::TextureUsageBits_Attachment;
-    descColor.numSamples = kNumSamplesMSAA;
-    descColor.numMipLevels = 1;
+    descOffscreenColor_.usage = lvk::TextureUsageBits_Attachment;
+    descOffscreenColor_.numSamples = kNumSamplesMSAA;
+    descOffscreenColor_.numMipLevels = 1;
+    // only the resolved image leaves the render pass
+    descOffscreenColor_.storage = lvk::StorageType_Memoryless;
   }
 
-  lvk::Framebuffer fb = {
-      .color = {{.texture = device_->createTexture(descColor).release()}},
-      .depthStencil = {.texture = device_->createTexture(descDepth).release()},
+  descOffscreenResolve_ = {
+      .type = lvk::TextureType_2D,
+      .format = format,
+      .dimensions = {w, h},
+      .usage = usage,
+      .debugName = "Offscreen framebuffer (color resolve)",
   };
-
-  if (kNumSamplesMSAA > 1) {
-    fb.color[0].resolveTexture =
-        device_
-            ->createTexture({.type = lvk::TextureType_2D,
-                             .format = format,
-                             .dimensions = {w, h},
-                             .usage = usage,
-                             .debugName = "Offscreen framebuffer (color resolve)"})
-            .release();
-  }
-
-  fbOffscreen_ = fb;
 }
 
-void render(lvk::TextureHandle nativeDrawable, uint32_t frameIndex) {
+void render(lvk::TextureHandle nativeDrawable) {
   IGL_PROFILER_FUNCTION();
 
   fbMain_.color[0].texture = nativeDrawable;
@@ -1111,150 +1104,197 @@ void render(lvk::TextureHandle nativeDrawable, uint32_t frameIndex) {
       .bDrawNormals = perFrame_.bDrawNormals,
       .bDebugLines = perFrame_.bDebugLines,
   };
-  device_->upload(ubPerFrame_[frameIndex], &perFrame_, sizeof(perFrame_));
+  // per-frame uniforms live in transient memory which is recycled when the GPU has finished this frame
+  const lvk::TransientAllocation ubPerFrame = device_->allocateTransient(sizeof(UniformsPerFrame));
+  const lvk::TransientAllocation ubPerFrameShadow = device_->allocateTransient(sizeof(UniformsPerFrame));
+  const lvk::TransientAllocation ubPerObject = device_->allocateTransient(sizeof(UniformsPerObject));
+
+  if (!ubPerFrame.valid() || !ubPerFrameShadow.valid() || !ubPerObject.valid()) {
+    // the transient arena is exhausted: skip this frame and recycle its memory
+    device_->endTransientFrame();
+    return;
+  }
+
+  memcpy(ubPerFrame.ptr, &perFrame_, sizeof(perFrame_));
 
   {
     const UniformsPerFrame perFrameShadow{
         .proj = shadowProj,
         .view = shadowView,
     };
-    device_->upload(ubPerFrameShadow_[frameIndex], &perFrameShadow, sizeof(perFrameShadow));
+    memcpy(ubPerFrameShadow.ptr, &perFrameShadow, sizeof(perFrameShadow));
   }
 
   UniformsPerObject perObject;
 
   perObject.model = glm::scale(mat4(1.0f), vec3(0.05f));
 
-  device_->upload(ubPerObject_[frameIndex], &perObject, sizeof(perObject));
+  memcpy(ubPerObject.ptr, &perObject, sizeof(perObject));
+
+  // the frame is described as a graph: it derives the transitions between the passes and backs the transient
+  // attachments with pooled textures; culled passes are not recorded
+  renderGraph_->reset();
 
-  // Command buffers (1-N per thread): create, submit and forget
+  const lvk::RenderGraphTexture texSwapchain = renderGraph_->importTexture(nativeDrawable);
+  const lvk::RenderGraphTexture texShadowMap = renderGraph_->importTexture(fbShadowMap_.depthStencil.texture);
+  const lvk::RenderGraphTexture texOffscreenColor = renderGraph_->createTexture(descOffscreenColor_);
+  const lvk::RenderGraphTexture texOffscreenDepth = renderGraph_->createTexture(descOffscreenDepth_);
+  const lvk::RenderGraphTexture texOffscreenResolve =
+      kNumSamplesMSAA > 1 ? renderGraph_->createTexture(descOffscreenResolve_) : lvk::RenderGraphTexture{};
+  // the final image of the offscreen pass
+  const lvk::RenderGraphTexture texOffscreen = kNumSamplesMSAA > 1 ? texOffscreenResolve : texOffscreenColor;
 
   // Pass 1: shadows
   if (isShadowMapDirty_) {
-    lvk::ICommandBuffer& buffer = device_->acquireCommandBuffer();
-
-    buffer.cmdBeginRendering(renderPassShadow_, fbShadowMap_);
-    {
-      buffer.cmdBindRenderPipeline(renderPipelineState_Shadow_);
-      buffer.cmdPushDebugGroupLabel("Render Shadows", lvk::Color(1, 0, 0));
-      buffer.cmdBindDepthStencilState(depthStencilState_);
-      buffer.cmdBindVertexBuffer(0, vb0_, 0);
-      struct {
-        uint64_t perFrame;
-        uint64_t perObject;
-      } bindings = {
-          .perFrame = device_->gpuAddress(ubPerFrameShadow_[frameIndex]),
-          .perObject = device_->gpuAddress(ubPerObject_[frameIndex]),
-      };
-      buffer.cmdPushConstants(bindings);
-      buffer.cmdDrawIndexed(
-          lvk::Primitive_Triangle, indexData_.size(), lvk::IndexFormat_UI32, ib0_, 0);
-      buffer.cmdPopDebugGroupLabel();
-    }
-    buffer.cmdEndRendering();
-    buffer.transitionToShaderReadOnly(fbShadowMap_.depthStencil.texture);
-    device_->submit(buffer, lvk::QueueType_Graphics);
-    device_->generateMipmap(fbShadowMap_.depthStencil.texture);
-
-    isShadowMapDirty_ = false;
+    renderGraph_->addPass({
+        .name = "Shadows",
+        .renderPass = renderPassShadow_,
+        .depthStencil = texShadowMap,
+        .execute =
+            [&ubPerFrameShadow, &ubPerObject](lvk::ICommandBuffer& buffer, const lvk::Dependencies&) {
+              IGL_PROFILER_ZONE("Record Shadows", IGL_PROFILER_COLOR_CREATE);
+              buffer.cmdBindRenderPipeline(renderPipelineState_Shadow_);
+              buffer.cmdPushDebugGroupLabel("Render Shadows", lvk::Color(1, 0, 0));
+              buffer.cmdBindDepthStencilState(depthStencilState_);
+              buffer.cmdBindVertexBuffer(0, vb0_, 0);
+              struct {
+                uint64_t perFrame;
+                uint64_t perObject;
+              } bindings = {
+                  .perFrame = ubPerFrameShadow.gpuAddress,
+                  .perObject = ubPerObject.gpuAddress,
+              };
+              buffer.cmdPushConstants(bindings);
+              buffer.cmdDrawIndexed(
+                  lvk::Primitive_Triangle, indexData_.size(), lvk::IndexFormat_UI32, ib0_, 0);
+              buffer.cmdPopDebugGroupLabel();
+              IGL_PROFILER_ZONE_END();
+            },
+        .afterSubmit =
+            []() {
+              device_->generateMipmap(fbShadowMap_.depthStencil.texture);
+              isShadowMapDirty_ = false;
+            },
+    });
   }
 
   // Pass 2: mesh
-  {
-    lvk::ICommandBuffer& buffer = device_->acquireCommandBuffer();
-
-    // This will clear the framebuffer
-    buffer.cmdBeginRendering(renderPassOffscreen_, fbOffscreen_);
-    {
-      // Scene
-      buffer.cmdBindRenderPipeline(renderPipelineState_Mesh_);
-      buffer.cmdPushDebugGroupLabel("Render Mesh", lvk::Color(1, 0, 0));
-      buffer.cmdBindDepthStencilState(depthStencilState_);
-      buffer.cmdBindVertexBuffer(0, vb0_, 0);
-
-      struct {
-        uint64_t perFrame;
-        uint64_t perObject;
-        uint64_t materials;
-      } bindings = {
-          .perFrame = device_->gpuAddress(ubPerFrame_[frameIndex]),
-          .perObject = device_->gpuAddress(ubPerObject_[frameIndex]),
-          .materials = device_->gpuAddress(sbMaterials_),
-      };
-      buffer.cmdPushConstants(bindings);
-      buffer.cmdDrawIndexed(
-          lvk::Primitive_Triangle, indexData_.size(), lvk::IndexFormat_UI32, ib0_, 0);
-      if (enableWireframe_) {
-        buffer.cmdBindRenderPipeline(renderPipelineState_MeshWireframe_);
-        buffer.cmdDrawIndexed(
-            lvk::Primitive_Triangle, indexData_.size(), lvk::IndexFormat_UI32, ib0_, 0);
-      }
-      buffer.cmdPopDebugGroupLabel();
-
-      // Skybox
-      buffer.cmdBindRenderPipeline(renderPipelineState_Skybox_);
-      buffer.cmdPushDebugGroupLabel("Render Skybox", lvk::Color(0, 1, 0));
-      buffer.cmdBindDepthStencilState(depthStencilStateLEqual_);
-      buffer.cmdDraw(lvk::Primitive_Triangle, 0, 3 * 6 * 2);
-      buffer.cmdPopDebugGroupLabel();
-    }
-    buffer.cmdEndRendering();
-    buffer.transitionToShaderReadOnly(fbOffscreen_.color[0].texture);
-    device_->submit(buffer, lvk::QueueType_Graphics);
-  }
+  renderGraph_->addPass({
+      .name = "Mesh",
+      .renderPass = renderPassOffscreen_,
+      .color = {texOffscreenColor},
+      .resolve = {texOffscreenResolve},
+      .depthStencil = texOffscreenDepth,
+      .sampled = {texShadowMap},
+      .execute =
+          [&ubPerFrame, &ubPerObject](lvk::ICommandBuffer& buffer, const lvk::Dependencies&) {
+            IGL_PROFILER_ZONE("Record Mesh", IGL_PROFILER_COLOR_CREATE);
+            // Scene
+            buffer.cmdBindRenderPipeline(renderPipelineState_Mesh_);
+            buffer.cmdPushDebugGroupLabel("Render Mesh", lvk::Color(1, 0, 0));
+            buffer.cmdBindDepthStencilState(depthStencilState_);
+            buffer.cmdBindVertexBuffer(0, vb0_, 0);
+
+            struct {
+              uint64_t perFrame;
+              uint64_t perObject;
+              uint64_t materials;
+            } bindings = {
+                .perFrame = ubPerFrame.gpuAddress,
+                .perObject = ubPerObject.gpuAddress,
+                .materials = device_->gpuAddress(sbMaterials_),
+            };
+            buffer.cmdPushConstants(bindings);
+            buffer.cmdDrawIndexed(
+                lvk::Primitive_Triangle, indexData_.size(), lvk::IndexFormat_UI32, ib0_, 0);
+            if (enableWireframe_) {
+              buffer.cmdBindRenderPipeline(renderPipelineState_MeshWireframe_);
+              buffer.cmdDrawIndexed(
+                  lvk::Primitive_Triangle, indexData_.size(), lvk::IndexFormat_UI32, ib0_, 0);
+            }
+            buffer.cmdPopDebugGroupLabel();
+
+            // Skybox
+            buffer.cmdBindRenderPipeline(renderPipelineState_Skybox_);
+            buffer.cmdPushDebugGroupLabel("Render Skybox", lvk::Color(0, 1, 0));
+            buffer.cmdBindDepthStencilState(depthStencilStateLEqual_);
+            buffer.cmdDraw(lvk::Primitive_Triangle, 0, 3 * 6 * 2);
+            buffer.cmdPopDebugGroupLabel();
+            IGL_PROFILER_ZONE_END();
+          },
+  });
 
   // Pass 3: compute shader post-processing
   if (enableComputePass_) {
-    lvk::TextureHandle tex = kNumSamplesMSAA > 1 ? fbOffscreen_.color[0].resolveTexture
-                                                 : fbOffscreen_.color[0].texture;
-    lvk::ICommandBuffer& buffer = device_->acquireCommandBuffer();
-
-    buffer.cmdBindComputePipeline(computePipelineState_Grayscale_);
-
-    struct {
-      uint32_t texture;
-    } bindings = {
-        .texture = tex.index(),
-    };
-    buffer.cmdPushConstants(bindings);
-    buffer.cmdDispatchThreadGroups(
-        {
-            .width = (uint32_t)width_,
-            .height = (uint32_t)height_,
-            .depth = 1u,
-        },
-        {
-            .textures = {tex},
-        });
-
-    device_->submit(buffer, lvk::QueueType_Compute);
+    // runs on the async compute queue (if available); the next graphics submit waits for it
+    renderGraph_->addPass({
+        .name = "Grayscale",
+        .queue = lvk::QueueType_Compute,
+        .storage = {texOffscreen},
+        .execute =
+            [texOffscreen](lvk::ICommandBuffer& buffer, const lvk::Dependencies& deps) {
+              const lvk::TextureHandle tex = renderGraph_->getTexture(texOffscreen);
+
+              buffer.cmdBindComputePipeline(computePipelineState_Grayscale_);
+
+              struct {
+                uint32_t texture;
+              } bindings = {
+                  .texture = tex.index(),
+              };
+              buffer.cmdPushConstants(bindings);
+              buffer.cmdDispatchThreadGroups(
+                  {
+                      .width = (uint32_t)width_,
+                      .height = (uint32_t)height_,
+                      .depth = 1u,
+                  },
+                  deps);
+            },
+    });
   }
 
   // Pass 4: render into the swapchain image
-  {
-    lvk::ICommandBuffer& buffer = device_->acquireCommandBuffer();
+  renderGraph_->addPass({
+      .name = "Swapchain Output",
+      .renderPass = renderPassMain_,
+      .color = {texSwapchain},
+      .sampled = {texOffscreen},
+      // ImGui stays on this thread: it can create new buffers and upload data
+      .isThreadSafe = false,
+      .execute =
+          [texOffscreen](lvk::ICommandBuffer& buffer, const lvk::Dependencies&) {
+            IGL_PROFILER_ZONE("Record Swapchain Output", IGL_PROFILER_COLOR_CREATE);
+            buffer.cmdBindRenderPipeline(renderPipelineState_Fullscreen_);
+            buffer.cmdPushDebugGroupLabel("Swapchain Output", lvk::Color(1, 0, 0));
+            struct {
+              uint32_t texture;
+            } bindings = {
+                .texture = renderGraph_->getTexture(texOffscreen).index(),
+            };
+            buffer.cmdPushConstants(bindings);
+            buffer.cmdDraw(lvk::Primitive_Triangle, 0, 3);
+            buffer.cmdPopDebugGroupLabel();
+            imgui_->endFrame(*device_.get(), buffer);
+            IGL_PROFILER_ZONE_END();
+          },
+  });
 
-    // This will clear the framebuffer
-    buffer.cmdBeginRendering(renderPassMain_, fbMain_);
-    {
-      buffer.cmdBindRenderPipeline(renderPipelineState_Fullscreen_);
-      buffer.cmdPushDebugGroupLabel("Swapchain Output", lvk::Color(1, 0, 0));
-      struct {
-        uint32_t texture;
-      } bindings = {
-          .texture = kNumSamplesMSAA > 1 ? fbOffscreen_.color[0].resolveTexture.index()
-                                         : fbOffscreen_.color[0].texture.index(),
-      };
-      buffer.cmdPushConstants(bindings);
-      buffer.cmdDraw(lvk::Primitive_Triangle, 0, 3);
-      buffer.cmdPopDebugGroupLabel();
-
-      imgui_->endFrame(*device_.get(), buffer);
-    }
-    buffer.cmdEndRendering();
+  const double recordingStartTime = glfwGetTime();
 
-    device_->submit(buffer, lvk::QueueType_Graphics, fbMain_.color[0].texture);
+  if (kRecordOnWorkerThreads) {
+    renderGraph_->execute(nativeDrawable, [](uint32_t numTasks, const std::function<void(uint32_t)>& task) {
+      tf::Taskflow taskflow;
+      for (uint32_t i = 0; i != numTasks; i++) {
+        taskflow.emplace([&task, i]() { task(i); });
+      }
+      renderPool_->run(taskflow).wait();
+    });
+  } else {
+    renderGraph_->execute(nativeDrawable);
   }
+
+  cpuRecordingTimeMs_ = 1000.0 * (glfwGetTime() - recordingStartTime);
 }
 
 void generateCompressedTexture(LoadedImage img) {
@@ -1798,10 +1838,12 @@ int main(int argc, char* argv[]) {
   fbMain_ = {
       .color = {{.texture = device_->getCurrentSwapchainTexture()}},
   };
+  renderGraph_ = std::make_unique<lvk::RenderGraph>(*device_);
   createShadowMap();
-  createOffscreenFramebuffer();
+  createOffscreenTextureDescs();
   createRenderPipelines();
   createRenderPipelineSkybox();
+  prewarmRenderPipelines();
   createComputePipeline();
 
   imgui_ = std::make_unique<lvk::ImGuiRenderer>(
@@ -1809,8 +1851,6 @@ int main(int argc, char* argv[]) {
 
   double prevTime = glfwGetTime();
 
-  uint32_t frameIndex = 0;
-
   // Main loop
   while (!glfwWindowShouldClose(window_)) {
     {
@@ -1857,6 +1897,7 @@ int main(int argc, char* argv[]) {
         if (ImGui::Begin("##FPS", nullptr, flags)) {
           ImGui::Text("FPS : %i", (int)fps_.getFPS());
           ImGui::Text("Ms  : %.1f", 1000.0 / fps_.getFPS());
+          ImGui::Text("Rec : %.2f", cpuRecordingTimeMs_);
         }
         ImGui::End();
       }
@@ -1868,21 +1909,19 @@ int main(int argc, char* argv[]) {
     fps_.tick(delta);
     positioner_.update(delta, mousePos_, mousePressed_);
     prevTime = newTime;
-    render(device_->getCurrentSwapchainTexture(), frameIndex);
+    render(device_->getCurrentSwapchainTexture());
     glfwPollEvents();
-    frameIndex = (frameIndex + 1) % kNumBufferedFrames;
   }
 
   loaderShouldExit_.store(true, std::memory_order_release);
 
+  renderPool_ = nullptr;
   imgui_ = nullptr;
+  renderGraph_ = nullptr;
   // destroy all the Vulkan stuff before closing the window
   vb0_ = nullptr;
   ib0_ = nullptr;
   sbMaterials_ = nullptr;
-  ubPerFrame_.clear();
-  ubPerFrameShadow_.clear();
-  ubPerObject_.clear();
   renderPipelineState_Mesh_ = nullptr;
   renderPipelineState_MeshWireframe_ = nullptr;
   renderPipelineState_Shadow_ = nullptr;
@@ -1898,7 +1937,6 @@ int main(int argc, char* argv[]) {
   samplerShadow_ = nullptr;
   device_->destroy(fbMain_);
   device_->destroy(fbShadowMap_);
-  device_->destroy(fbOffscreen_);
   device_ = nullptr;
 
   glfwDestroyWindow(window_);
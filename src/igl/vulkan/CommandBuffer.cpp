@@ -14,7 +14,11 @@
 
 namespace lvk::vulkan {
 
-CommandBuffer::CommandBuffer(VulkanContext* ctx) : ctx_(ctx), wrapper_(&ctx_->immediate_->acquire()) {}
+CommandBuffer::CommandBuffer(VulkanContext* ctx, lvk::QueueType queueType) :
+  ctx_(ctx),
+  queueType_(queueType),
+  immediate_(queueType == lvk::QueueType_Compute && ctx->immediateCompute_ ? ctx->immediateCompute_.get() : ctx->immediate_.get()),
+  wrapper_(&immediate_->acquire()) {}
 
 CommandBuffer::~CommandBuffer() {
   IGL_ASSERT(!isRendering_); // did you forget to call cmdEndRendering()?
@@ -22,25 +26,6 @@ CommandBuffer::~CommandBuffer() {
 
 namespace {
 
-void transitionColorAttachment(VkCommandBuffer buffer, lvk::vulkan::VulkanTexture* colorTex) {
-  if (!IGL_VERIFY(colorTex)) {
-    return;
-  }
-
-  const VulkanImage& colorImg = *colorTex->image_.get();
-  if (!IGL_VERIFY(!colorImg.isDepthFormat_ && !colorImg.isStencilFormat_)) {
-    IGL_ASSERT_MSG(false, "Color attachments cannot have depth/stencil formats");
-    return;
-  }
-  IGL_ASSERT_MSG(colorImg.imageFormat_ != VK_FORMAT_UNDEFINED, "Invalid color attachment format");
-  colorImg.transitionLayout(buffer,
-                            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-                            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-                            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, // wait for all subsequent
-                                                                                                          // fragment/compute shaders
-                            VkImageSubresourceRange{VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS});
-}
-
 VkAttachmentLoadOp loadOpToVkAttachmentLoadOp(lvk::LoadOp a) {
   using lvk::LoadOp;
   switch (a) {
@@ -74,29 +59,6 @@ VkAttachmentStoreOp storeOpToVkAttachmentStoreOp(lvk::StoreOp a) {
   return VK_ATTACHMENT_STORE_OP_DONT_CARE;
 }
 
-VkStencilOp stencilOpToVkStencilOp(lvk::StencilOp op) {
-  switch (op) {
-  case lvk::StencilOp_Keep:
-    return VK_STENCIL_OP_KEEP;
-  case lvk::StencilOp_Zero:
-    return VK_STENCIL_OP_ZERO;
-  case lvk::StencilOp_Replace:
-    return VK_STENCIL_OP_REPLACE;
-  case lvk::StencilOp_IncrementClamp:
-    return VK_STENCIL_OP_INCREMENT_AND_CLAMP;
-  case lvk::StencilOp_DecrementClamp:
-    return VK_STENCIL_OP_DECREMENT_AND_CLAMP;
-  case lvk::StencilOp_Invert:
-    return VK_STENCIL_OP_INVERT;
-  case lvk::StencilOp_IncrementWrap:
-    return VK_STENCIL_OP_INCREMENT_AND_WRAP;
-  case lvk::StencilOp_DecrementWrap:
-    return VK_STENCIL_OP_DECREMENT_AND_WRAP;
-  }
-  IGL_ASSERT(false);
-  return VK_STENCIL_OP_KEEP;
-}
-
 VkIndexType indexFormatToVkIndexType(lvk::IndexFormat fmt) {
   switch (fmt) {
   case lvk::IndexFormat_UI16:
@@ -108,27 +70,113 @@ VkIndexType indexFormatToVkIndexType(lvk::IndexFormat fmt) {
   return VK_INDEX_TYPE_NONE_KHR;
 }
 
-VkPrimitiveTopology primitiveTypeToVkPrimitiveTopology(lvk::PrimitiveType t) {
-  switch (t) {
-  case lvk::Primitive_Point:
-    return VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
-  case lvk::Primitive_Line:
-    return VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
-  case lvk::Primitive_LineStrip:
-    return VK_PRIMITIVE_TOPOLOGY_LINE_STRIP;
-  case lvk::Primitive_Triangle:
-    return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-  case lvk::Primitive_TriangleStrip:
-    return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+} // namespace
+
+void CommandBuffer::transitionImage(const VulkanImage& image,
+                                    VkImageLayout newImageLayout,
+                                    VkPipelineStageFlags2 dstStageMask,
+                                    VkAccessFlags2 dstAccessMask,
+                                    const VkImageSubresourceRange& subresourceRange,
+                                    bool discardContents) const {
+  std::lock_guard<std::recursive_mutex> lock(ctx_->resourceStatesMutex_);
+
+  IGL_ASSERT_MSG(immediate_ != ctx_->immediateCompute_.get() || image.isConcurrent_,
+                 "Exclusive images are owned by the graphics queue and cannot be accessed on the compute queue");
+
+  trackRecorder(image.lastRecorderQueue_, image.lastRecorder_);
+
+  // barriers in one batch are not ordered with each other: the same image cannot be transitioned twice
+  for (const VkImageMemoryBarrier2& b : pendingImageBarriers_) {
+    if (b.image == image.getVkImage()) {
+      flushBarriers();
+      break;
+    }
+  }
+
+  image.transitionLayout(pendingImageBarriers_, newImageLayout, dstStageMask, dstAccessMask, subresourceRange, discardContents);
+}
+
+void CommandBuffer::transitionBuffer(const VulkanBuffer& buffer, VkPipelineStageFlags2 dstStageMask, VkAccessFlags2 dstAccessMask) const {
+  std::lock_guard<std::recursive_mutex> lock(ctx_->resourceStatesMutex_);
+
+  trackRecorder(buffer.lastRecorderQueue_, buffer.lastRecorder_);
+
+  for (const VkBufferMemoryBarrier2& b : pendingBufferBarriers_) {
+    if (b.buffer == buffer.getVkBuffer()) {
+      flushBarriers();
+      break;
+    }
   }
-  IGL_ASSERT_MSG(false, "Implement PrimitiveType = %u", (uint32_t)t);
-  return VK_PRIMITIVE_TOPOLOGY_MAX_ENUM;
+
+  buffer.transitionAccess(pendingBufferBarriers_, dstStageMask, dstAccessMask);
 }
 
-} // namespace
+void CommandBuffer::trackRecorder(const VulkanImmediateCommands*& lastRecorderQueue,
+                                  VulkanImmediateCommands::SubmitHandle& lastRecorder) const {
+  const VulkanImmediateCommands::SubmitHandle handle = wrapper_->handle_;
+
+  if (lastRecorderQueue == immediate_ && lastRecorder.handle() == handle.handle()) {
+    return;
+  }
+
+  if (lastRecorderQueue && lastRecorderQueue->isEncoding(lastRecorder)) {
+    submitAfter_.emplace_back(lastRecorderQueue, lastRecorder);
+  }
+
+  lastRecorderQueue = immediate_;
+  lastRecorder = handle;
+}
+
+void CommandBuffer::flushBarriers() const {
+  if (pendingImageBarriers_.empty() && pendingBufferBarriers_.empty()) {
+    return;
+  }
 
-void CommandBuffer ::transitionToShaderReadOnly(TextureHandle handle) const {
+  IGL_PROFILER_FUNCTION_COLOR(IGL_PROFILER_COLOR_TRANSITION);
+
+  if (immediate_ == ctx_->immediateCompute_.get()) {
+    // the tracked state can come from the graphics queue: those stages do not exist on the compute queue and
+    // the submits of both queues are ordered by timeline semaphores
+    const VkPipelineStageFlags2 computeStages = VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT |
+                                                VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT |
+                                                VK_PIPELINE_STAGE_2_CLEAR_BIT | VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    auto sanitize = [computeStages](auto& b) {
+      if (b.srcStageMask & ~computeStages) {
+        b.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        b.srcAccessMask = VK_ACCESS_2_NONE;
+      }
+      // i.e. transitionToShaderReadOnly() targets the fragment and compute stages
+      if (b.dstStageMask & ~computeStages) {
+        b.dstStageMask &= computeStages;
+      }
+    };
+    for (VkImageMemoryBarrier2& b : pendingImageBarriers_) {
+      sanitize(b);
+    }
+    for (VkBufferMemoryBarrier2& b : pendingBufferBarriers_) {
+      sanitize(b);
+    }
+  }
+
+#if IGL_VULKAN_PRINT_COMMANDS
+  LLOGL("%p vkCmdPipelineBarrier2(%u, %u)\n",
+        wrapper_->cmdBuf_,
+        (uint32_t)pendingBufferBarriers_.size(),
+        (uint32_t)pendingImageBarriers_.size());
+#endif // IGL_VULKAN_PRINT_COMMANDS
+  ivkCmdPipelineBarrier2(wrapper_->cmdBuf_,
+                         (uint32_t)pendingBufferBarriers_.size(),
+                         pendingBufferBarriers_.data(),
+                         (uint32_t)pendingImageBarriers_.size(),
+                         pendingImageBarriers_.data());
+
+  pendingImageBarriers_.clear();
+  pendingBufferBarriers_.clear();
+}
+
+void CommandBuffer::transitionToShaderReadOnly(TextureHandle handle) const {
   IGL_PROFILER_FUNCTION();
+  IGL_ASSERT_MSG(!isRendering_, "Textures cannot be transitioned inside a render pass");
 
   const lvk::vulkan::VulkanTexture& tex = *ctx_->texturesPool_.get(handle);
   const VulkanImage* img = tex.image_.get();
@@ -137,17 +185,12 @@ void CommandBuffer ::transitionToShaderReadOnly(TextureHandle handle) const {
 
   // transition only non-multisampled images - MSAA images cannot be accessed from shaders
   if (img->samples_ == VK_SAMPLE_COUNT_1_BIT) {
-    const VkImageAspectFlags flags = tex.image_->getImageAspectFlags();
-    const VkPipelineStageFlags srcStage = lvk::vulkan::isDepthOrStencilVkFormat(tex.image_->imageFormat_)
-                                              ? VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT
-                                              : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    // set the result of the previous render pass
-    img->transitionLayout(wrapper_->cmdBuf_,
-                          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                          srcStage,
-                          VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, // wait for subsequent
-                                                                                                        // fragment/compute shaders
-                          VkImageSubresourceRange{flags, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS});
+    // the source stages come from the tracked state of every subresource; already transitioned ones are skipped
+    transitionImage(*img,
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                    VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                    VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                    VkImageSubresourceRange{img->getImageAspectFlags(), 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS});
   }
 }
 
@@ -158,15 +201,21 @@ void CommandBuffer::cmdBindComputePipeline(lvk::ComputePipelineHandle handle) {
     return;
   }
 
-  VkPipeline* pipeline = ctx_->computePipelinesPool_.get(handle);
+  currentComputePipeline_ = handle;
+
+  bindComputePipeline();
+}
+
+void CommandBuffer::bindComputePipeline() {
+  // the pipeline is recreated if the bindless pipeline layout has changed
+  VkPipeline pipeline = ctx_->getVkPipeline(currentComputePipeline_, getVkPipelineLayout());
 
-  IGL_ASSERT(pipeline);
-  IGL_ASSERT(*pipeline != VK_NULL_HANDLE);
+  IGL_ASSERT(pipeline != VK_NULL_HANDLE);
 
-  if (lastPipelineBound_ != *pipeline) {
-    lastPipelineBound_ = *pipeline;
+  if (lastPipelineBound_ != pipeline) {
+    lastPipelineBound_ = pipeline;
     if (pipeline != VK_NULL_HANDLE) {
-      vkCmdBindPipeline(wrapper_->cmdBuf_, VK_PIPELINE_BIND_POINT_COMPUTE, *pipeline);
+      vkCmdBindPipeline(wrapper_->cmdBuf_, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
     }
   }
 }
@@ -177,9 +226,20 @@ void CommandBuffer::cmdDispatchThreadGroups(const Dimensions& threadgroupCount,
   for (uint32_t i = 0; i != Dependencies::IGL_MAX_SUBMIT_DEPENDENCIES && deps.textures[i]; i++) {
     useComputeTexture(deps.textures[i]);
   }
+  for (uint32_t i = 0; i != Dependencies::IGL_MAX_SUBMIT_DEPENDENCIES && deps.buffers[i]; i++) {
+    useComputeBuffer(deps.buffers[i], true);
+  }
+  for (uint32_t i = 0; i != Dependencies::IGL_MAX_SUBMIT_DEPENDENCIES && deps.buffersRead[i]; i++) {
+    useComputeBuffer(deps.buffersRead[i], false);
+  }
 
   ctx_->checkAndUpdateDescriptorSets();
-  ctx_->bindDefaultDescriptorSets(wrapper_->cmdBuf_, VK_PIPELINE_BIND_POINT_COMPUTE);
+  pipelineLayout_ = ctx_->bindDefaultDescriptorSets(*immediate_, *wrapper_, VK_PIPELINE_BIND_POINT_COMPUTE);
+
+  // bindless tables could have been grown by checkAndUpdateDescriptorSets()
+  bindComputePipeline();
+
+  flushBarriers();
 
   vkCmdDispatch(wrapper_->cmdBuf_, threadgroupCount.width, threadgroupCount.height, threadgroupCount.depth);
 }
@@ -211,23 +271,122 @@ void CommandBuffer::useComputeTexture(TextureHandle handle) {
     return;
   }
 
-  // "frame graph" heuristics: if we are already in VK_IMAGE_LAYOUT_GENERAL, wait for the previous
-  // compute shader
-  const VkPipelineStageFlags srcStage = (vkImage.imageLayout_ == VK_IMAGE_LAYOUT_GENERAL) ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
-                                                                                          : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-  vkImage.transitionLayout(
-      wrapper_->cmdBuf_,
-      VK_IMAGE_LAYOUT_GENERAL,
-      srcStage,
-      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-      VkImageSubresourceRange{vkImage.getImageAspectFlags(), 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS});
+  // GENERAL -> GENERAL still waits for the previous writes
+  transitionImage(vkImage,
+                  VK_IMAGE_LAYOUT_GENERAL,
+                  VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+                  VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                  VkImageSubresourceRange{vkImage.getImageAspectFlags(), 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS});
 }
 
-void CommandBuffer::cmdBeginRendering(const lvk::RenderPass& renderPass, const lvk::Framebuffer& fb) {
+void CommandBuffer::useComputeBuffer(BufferHandle handle, bool isWritten) {
+  IGL_ASSERT(!handle.empty());
+
+  const VulkanBuffer* buf = ctx_->buffersPool_.get(handle);
+
+  if (!(buf->getUsageFlags() & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)) {
+    IGL_ASSERT_MSG(false, "Did you forget to specify BufferUsageBits_Storage on your buffer?");
+    return;
+  }
+
+  const VkAccessFlags2 dstAccessMask =
+      isWritten ? VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT : VK_ACCESS_2_SHADER_STORAGE_READ_BIT;
+
+  transitionBuffer(*buf, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, dstAccessMask);
+}
+
+void CommandBuffer::useRenderingBuffer(BufferHandle handle, bool isWritten) {
+  IGL_ASSERT(!handle.empty());
+
+  const VulkanBuffer* buf = ctx_->buffersPool_.get(handle);
+  const VkBufferUsageFlags usage = buf->getUsageFlags();
+
+  // wait only in the stages which can access this buffer
+  VkPipelineStageFlags2 dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+  VkAccessFlags2 dstAccessMask = VK_ACCESS_2_NONE;
+
+  if (usage & VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT) {
+    dstStageMask |= VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT;
+    dstAccessMask |= VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT;
+  }
+  if (usage & VK_BUFFER_USAGE_INDEX_BUFFER_BIT) {
+    dstStageMask |= VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT;
+    dstAccessMask |= VK_ACCESS_2_INDEX_READ_BIT;
+  }
+  if (usage & VK_BUFFER_USAGE_VERTEX_BUFFER_BIT) {
+    dstStageMask |= VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT;
+    dstAccessMask |= VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT;
+  }
+  // shaders read buffers via buffer device addresses: these are storage buffer accesses
+  if (usage & (VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)) {
+    dstStageMask |= VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_GEOMETRY_SHADER_BIT |
+                    VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+    dstAccessMask |= VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_UNIFORM_READ_BIT;
+  }
+
+  if (isWritten) {
+    // only shaders can write buffers during rendering
+    IGL_ASSERT_MSG(usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, "Did you forget to specify BufferUsageBits_Storage on your buffer?");
+    dstStageMask |= VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_GEOMETRY_SHADER_BIT |
+                    VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+    dstAccessMask |= VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT;
+  }
+
+  if (!IGL_VERIFY(dstStageMask != VK_PIPELINE_STAGE_2_NONE)) {
+    return;
+  }
+
+  transitionBuffer(*buf, dstStageMask, dstAccessMask);
+}
+
+bool CommandBuffer::isMemorylessUsageValid(const lvk::RenderPass& renderPass, const lvk::Framebuffer& fb) const {
+  auto isTransient = [this](TextureHandle handle) {
+    return handle && ctx_->texturesPool_.get(handle)->image_->isTransientAttachment();
+  };
+
+  for (uint32_t i = 0; i != fb.getNumColorAttachments(); i++) {
+    const auto& descColor = renderPass.color[i];
+    if (isTransient(fb.color[i].texture) && (descColor.loadOp == LoadOp_Load || descColor.storeOp == StoreOp_Store)) {
+      return false;
+    }
+    if (isTransient(fb.color[i].resolveTexture)) {
+      return false;
+    }
+  }
+
+  if (isTransient(fb.depthStencil.texture) &&
+      (renderPass.depth.loadOp == LoadOp_Load || renderPass.depth.storeOp == StoreOp_Store ||
+       renderPass.stencil.loadOp == LoadOp_Load || renderPass.stencil.storeOp == StoreOp_Store)) {
+    return false;
+  }
+
+  return true;
+}
+
+void CommandBuffer::cmdBeginRendering(const lvk::RenderPass& renderPass, const lvk::Framebuffer& fb, const Dependencies& deps) {
   IGL_PROFILER_FUNCTION();
 
   IGL_ASSERT(!isRendering_);
 
+  // memoryless contents do not outlive the render pass: they can only be cleared, discarded, or resolved
+  if (!IGL_VERIFY(isMemorylessUsageValid(renderPass, fb))) {
+    LLOGW("Memoryless attachments cannot be loaded, stored, or be resolve targets: the render pass is skipped\n");
+    isRendering_ = true;
+    isRenderingRefused_ = true;
+    return;
+  }
+
+  // barriers cannot be recorded inside the render pass: everything the draws read is made visible here
+  for (uint32_t i = 0; i != Dependencies::IGL_MAX_SUBMIT_DEPENDENCIES && deps.textures[i]; i++) {
+    transitionToShaderReadOnly(deps.textures[i]);
+  }
+  for (uint32_t i = 0; i != Dependencies::IGL_MAX_SUBMIT_DEPENDENCIES && deps.buffers[i]; i++) {
+    useRenderingBuffer(deps.buffers[i], true);
+  }
+  for (uint32_t i = 0; i != Dependencies::IGL_MAX_SUBMIT_DEPENDENCIES && deps.buffersRead[i]; i++) {
+    useRenderingBuffer(deps.buffersRead[i], false);
+  }
+
   isRendering_ = true;
 
   const uint32_t numFbColorAttachments = fb.getNumColorAttachments();
@@ -237,16 +396,29 @@ void CommandBuffer::cmdBeginRendering(const lvk::RenderPass& renderPass, const l
 
   framebuffer_ = fb;
 
-  // transition all the color attachments
+  // transition all the color attachments; cleared attachments do not need their previous contents
   for (uint32_t i = 0; i != numFbColorAttachments; i++) {
+    const auto& descColor = renderPass.color[i];
     if (const auto handle = fb.color[i].texture) {
-      lvk::vulkan::VulkanTexture* colorTex = ctx_->texturesPool_.get(handle);
-      transitionColorAttachment(wrapper_->cmdBuf_, colorTex);
+      const VulkanImage& colorImg = *ctx_->texturesPool_.get(handle)->image_.get();
+      IGL_ASSERT_MSG(!colorImg.isDepthFormat_ && !colorImg.isStencilFormat_, "Color attachments cannot have depth/stencil formats");
+      IGL_ASSERT_MSG(colorImg.imageFormat_ != VK_FORMAT_UNDEFINED, "Invalid color attachment format");
+      transitionImage(colorImg,
+                      VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                      VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                      VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                      VkImageSubresourceRange{VK_IMAGE_ASPECT_COLOR_BIT, descColor.level, 1, 0, 1},
+                      descColor.loadOp == LoadOp_Clear || descColor.loadOp == LoadOp_DontCare);
     }
     // handle MSAA
     if (TextureHandle handle = fb.color[i].resolveTexture) {
-      lvk::vulkan::VulkanTexture* colorResolveTex = ctx_->texturesPool_.get(handle);
-      transitionColorAttachment(wrapper_->cmdBuf_, colorResolveTex);
+      const VulkanImage& colorResolveImg = *ctx_->texturesPool_.get(handle)->image_.get();
+      transitionImage(colorResolveImg,
+                      VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                      VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                      VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+                      VkImageSubresourceRange{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1},
+                      descColor.storeOp == StoreOp_MsaaResolve);
     }
   }
   // transition depth-stencil attachment
@@ -256,14 +428,18 @@ void CommandBuffer::cmdBeginRendering(const lvk::RenderPass& renderPass, const l
     const lvk::vulkan::VulkanImage* depthImg = vkDepthTex.image_.get();
     IGL_ASSERT_MSG(depthImg->imageFormat_ != VK_FORMAT_UNDEFINED, "Invalid depth attachment format");
     const VkImageAspectFlags flags = vkDepthTex.image_->getImageAspectFlags();
-    depthImg->transitionLayout(wrapper_->cmdBuf_,
-                               VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
-                               VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
-                               VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, // wait for all subsequent
-                                                                  // operations
-                               VkImageSubresourceRange{flags, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS});
+    const bool isStencilLoaded = renderPass.stencil.loadOp == LoadOp_Load || renderPass.stencil.loadOp == LoadOp_None;
+    transitionImage(*depthImg,
+                    VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+                    VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                    VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                    VkImageSubresourceRange{flags, renderPass.depth.level, 1, 0, 1},
+                    (renderPass.depth.loadOp == LoadOp_Clear || renderPass.depth.loadOp == LoadOp_DontCare) && !isStencilLoaded);
   }
 
+  // all attachment transitions are recorded with one barrier
+  flushBarriers();
+
   VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
   uint32_t mipLevel = 0;
   uint32_t fbWidth = 0;
@@ -297,7 +473,7 @@ void CommandBuffer::cmdBeginRendering(const lvk::RenderPass& renderPass, const l
     colorAttachments[i] = {
         .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
         .pNext = nullptr,
-        .imageView = colorTexture.getVkImageViewForFramebuffer(0),
+        .imageView = colorTexture.getVkImageViewForFramebuffer(descColor.level),
         .imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
         .resolveMode = (samples > 1) ? VK_RESOLVE_MODE_AVERAGE_BIT : VK_RESOLVE_MODE_NONE,
         .resolveImageView = VK_NULL_HANDLE,
@@ -325,7 +501,7 @@ void CommandBuffer::cmdBeginRendering(const lvk::RenderPass& renderPass, const l
     depthAttachment = {
         .sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
         .pNext = nullptr,
-        .imageView = depthTexture.getVkImageViewForFramebuffer(0),
+        .imageView = depthTexture.getVkImageViewForFramebuffer(descDepth.level),
         .imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
         .resolveMode = VK_RESOLVE_MODE_NONE,
         .resolveImageView = VK_NULL_HANDLE,
@@ -372,7 +548,7 @@ void CommandBuffer::cmdBeginRendering(const lvk::RenderPass& renderPass, const l
   cmdBindScissorRect(scissor);
 
   ctx_->checkAndUpdateDescriptorSets();
-  ctx_->bindDefaultDescriptorSets(wrapper_->cmdBuf_, VK_PIPELINE_BIND_POINT_GRAPHICS);
+  pipelineLayout_ = ctx_->bindDefaultDescriptorSets(*immediate_, *wrapper_, VK_PIPELINE_BIND_POINT_GRAPHICS);
 
   vkCmdBeginRendering(wrapper_->cmdBuf_, &renderingInfo);
 }
@@ -382,24 +558,14 @@ void CommandBuffer::cmdEndRendering() {
 
   isRendering_ = false;
 
-  vkCmdEndRendering(wrapper_->cmdBuf_);
-
-  const uint32_t numFbColorAttachments = framebuffer_.getNumColorAttachments();
-
-  // set image layouts after the render pass
-  for (uint32_t i = 0; i != numFbColorAttachments; i++) {
-    const auto& attachment = framebuffer_.color[i];
-    const vulkan::VulkanTexture& tex = *ctx_->texturesPool_.get(attachment.texture);
-    // this must match the final layout of the render pass
-    tex.image_->imageLayout_ = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+  if (isRenderingRefused_) {
+    isRenderingRefused_ = false;
+    return;
   }
 
-  if (framebuffer_.depthStencil.texture) {
-    const vulkan::VulkanTexture& tex = *ctx_->texturesPool_.get(framebuffer_.depthStencil.texture);
-    // this must match the final layout of the render pass
-    tex.image_->imageLayout_ = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-  }
+  vkCmdEndRendering(wrapper_->cmdBuf_);
 
+  // the attachments stay in the layouts they were transitioned into by cmdBeginRendering()
   framebuffer_ = {};
 }
 
@@ -451,15 +617,9 @@ void CommandBuffer::cmdBindRenderPipeline(lvk::RenderPipelineHandle handle) {
 void CommandBuffer::cmdBindDepthStencilState(const DepthStencilState& desc) {
   IGL_PROFILER_FUNCTION();
 
-  dynamicState_.depthWriteEnable_ = desc.isDepthWriteEnabled;
-  dynamicState_.setDepthCompareOp(compareOpToVkCompareOp(desc.compareOp));
+  dynamicState_.setDepthStencilState(desc);
 
   auto setStencilState = [this](VkStencilFaceFlagBits faceMask, const lvk::StencilStateDesc& desc) {
-    dynamicState_.setStencilStateOps(faceMask,
-                                     stencilOpToVkStencilOp(desc.stencilFailureOp),
-                                     stencilOpToVkStencilOp(desc.depthStencilPassOp),
-                                     stencilOpToVkStencilOp(desc.depthFailureOp),
-                                     compareOpToVkCompareOp(desc.stencilCompareOp));
     vkCmdSetStencilReference(wrapper_->cmdBuf_, faceMask, desc.readMask);
     vkCmdSetStencilCompareMask(wrapper_->cmdBuf_, faceMask, 0xFF);
     vkCmdSetStencilWriteMask(wrapper_->cmdBuf_, faceMask, desc.writeMask);
@@ -498,21 +658,26 @@ void CommandBuffer::cmdPushConstants(const void* data, size_t size, size_t offse
   }
 
   vkCmdPushConstants(wrapper_->cmdBuf_,
-                     ctx_->vkPipelineLayout_,
+                     getVkPipelineLayout(),
                      VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT,
                      (uint32_t)offset,
                      (uint32_t)size,
                      data);
 }
 
-void CommandBuffer::bindGraphicsPipeline() {
+bool CommandBuffer::bindGraphicsPipeline() {
+  if (isRenderingRefused_) {
+    // there is no render pass to draw into
+    return false;
+  }
+
   const lvk::vulkan::RenderPipelineState* rps = ctx_->renderPipelinesPool_.get(currentPipeline_);
 
   if (!IGL_VERIFY(rps)) {
-    return;
+    return false;
   }
 
-  VkPipeline pipeline = rps->getVkPipeline(dynamicState_);
+  VkPipeline pipeline = rps->getVkPipeline(dynamicState_, getVkPipelineLayout());
 
   if (lastPipelineBound_ != pipeline) {
     lastPipelineBound_ = pipeline;
@@ -520,6 +685,13 @@ void CommandBuffer::bindGraphicsPipeline() {
       vkCmdBindPipeline(wrapper_->cmdBuf_, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
     }
   }
+
+  return pipeline != VK_NULL_HANDLE;
+}
+
+VkPipelineLayout CommandBuffer::getVkPipelineLayout() const {
+  // nothing has been bound yet: use the latest bindless pipeline layout
+  return pipelineLayout_ != VK_NULL_HANDLE ? pipelineLayout_ : ctx_->getVkPipelineLayout();
 }
 
 void CommandBuffer::cmdDraw(PrimitiveType primitiveType, size_t vertexStart, size_t vertexCount) {
@@ -530,7 +702,9 @@ void CommandBuffer::cmdDraw(PrimitiveType primitiveType, size_t vertexStart, siz
   }
 
   dynamicState_.setTopology(primitiveTypeToVkPrimitiveTopology(primitiveType));
-  bindGraphicsPipeline();
+  if (!bindGraphicsPipeline()) {
+    return;
+  }
 
   vkCmdDraw(wrapper_->cmdBuf_, (uint32_t)vertexCount, 1, (uint32_t)vertexStart, 0);
 }
@@ -547,7 +721,9 @@ void CommandBuffer::cmdDrawIndexed(PrimitiveType primitiveType,
   }
 
   dynamicState_.setTopology(primitiveTypeToVkPrimitiveTopology(primitiveType));
-  bindGraphicsPipeline();
+  if (!bindGraphicsPipeline()) {
+    return;
+  }
 
   lvk::vulkan::VulkanBuffer* buf = ctx_->buffersPool_.get(indexBuffer);
 
@@ -565,7 +741,9 @@ void CommandBuffer::cmdDrawIndirect(PrimitiveType primitiveType,
   IGL_PROFILER_FUNCTION();
 
   dynamicState_.setTopology(primitiveTypeToVkPrimitiveTopology(primitiveType));
-  bindGraphicsPipeline();
+  if (!bindGraphicsPipeline()) {
+    return;
+  }
 
   lvk::vulkan::VulkanBuffer* bufIndirect = ctx_->buffersPool_.get(indirectBuffer);
 
@@ -583,7 +761,9 @@ void CommandBuffer::cmdDrawIndexedIndirect(PrimitiveType primitiveType,
   IGL_PROFILER_FUNCTION();
 
   dynamicState_.setTopology(primitiveTypeToVkPrimitiveTopology(primitiveType));
-  bindGraphicsPipeline();
+  if (!bindGraphicsPipeline()) {
+    return;
+  }
 
   lvk::vulkan::VulkanBuffer* bufIndex = ctx_->buffersPool_.get(indexBuffer);
   lvk::vulkan::VulkanBuffer* bufIndirect = ctx_->buffersPool_.get(indirectBuffer);
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include <igl/vulkan/Common.h>
 #include <igl/vulkan/RenderPipelineState.h>
 #include <igl/vulkan/VulkanImmediateCommands.h>
@@ -14,12 +16,14 @@
 namespace lvk {
 namespace vulkan {
 
+class VulkanBuffer;
 class VulkanContext;
+class VulkanImage;
 
 class CommandBuffer final : public ICommandBuffer {
  public:
   CommandBuffer() = default;
-  explicit CommandBuffer(VulkanContext* ctx);
+  CommandBuffer(VulkanContext* ctx, lvk::QueueType queueType);
   ~CommandBuffer() override;
 
   CommandBuffer& operator=(CommandBuffer&& other) = default;
@@ -33,7 +37,7 @@ class CommandBuffer final : public ICommandBuffer {
   void cmdInsertDebugEventLabel(const char* label, const lvk::Color& color) const override;
   void cmdPopDebugGroupLabel() const override;
 
-  void cmdBeginRendering(const lvk::RenderPass& renderPass, const lvk::Framebuffer& desc) override;
+  void cmdBeginRendering(const lvk::RenderPass& renderPass, const lvk::Framebuffer& desc, const Dependencies& deps) override;
   void cmdEndRendering() override;
 
   void cmdBindViewport(const Viewport& viewport) override;
@@ -42,6 +46,10 @@ class CommandBuffer final : public ICommandBuffer {
   void cmdBindRenderPipeline(lvk::RenderPipelineHandle handle) override;
   void cmdBindDepthStencilState(const DepthStencilState& state) override;
 
+  // the BufferSlice overloads of ICommandBuffer
+  using ICommandBuffer::cmdBindVertexBuffer;
+  using ICommandBuffer::cmdDrawIndexed;
+
   void cmdBindVertexBuffer(uint32_t index, BufferHandle buffer, size_t bufferOffset) override;
   void cmdPushConstants(const void* data, size_t size, size_t offset) override;
 
@@ -69,24 +77,56 @@ class CommandBuffer final : public ICommandBuffer {
   void cmdSetDepthBias(float depthBias, float slopeScale, float clamp) override;
 
  private:
+  // queues a transition of the image; pending transitions are recorded with one barrier only by cmdBeginRendering(),
+  // cmdDispatchThreadGroups() and Device::submit() (or when the same resource is transitioned twice), never by draws:
+  // do not queue transitions inside dynamic rendering
+  void transitionImage(const VulkanImage& image,
+                       VkImageLayout newImageLayout,
+                       VkPipelineStageFlags2 dstStageMask,
+                       VkAccessFlags2 dstAccessMask,
+                       const VkImageSubresourceRange& subresourceRange,
+                       bool discardContents = false) const;
+  void transitionBuffer(const VulkanBuffer& buffer, VkPipelineStageFlags2 dstStageMask, VkAccessFlags2 dstAccessMask) const;
+  // remembers this command buffer as the last one which transitioned the resource (requires resourceStatesMutex_)
+  void trackRecorder(const VulkanImmediateCommands*& lastRecorderQueue, VulkanImmediateCommands::SubmitHandle& lastRecorder) const;
+  void flushBarriers() const;
   void useComputeTexture(TextureHandle texture);
-  void bindGraphicsPipeline();
+  void useComputeBuffer(BufferHandle buffer, bool isWritten);
+  void useRenderingBuffer(BufferHandle buffer, bool isWritten);
+  bool isMemorylessUsageValid(const lvk::RenderPass& renderPass, const lvk::Framebuffer& fb) const;
+  // false if there is no pipeline to draw with (i.e. it is still being compiled by IDevice::prewarmRenderPipeline())
+  bool bindGraphicsPipeline();
+  void bindComputePipeline();
+  VkPipelineLayout getVkPipelineLayout() const;
 
  private:
   friend class Device;
 
   VulkanContext* ctx_ = nullptr;
+  lvk::QueueType queueType_ = lvk::QueueType_Graphics;
+  VulkanImmediateCommands* immediate_ = nullptr; // the queue this command buffer is going to be submitted to
   const VulkanImmediateCommands::CommandBufferWrapper* wrapper_ = nullptr;
 
   lvk::Framebuffer framebuffer_ = {};
 
+  mutable std::vector<VkImageMemoryBarrier2> pendingImageBarriers_;
+  mutable std::vector<VkBufferMemoryBarrier2> pendingBufferBarriers_;
+  // command buffers which transitioned the same resources before this one and were still being recorded at that time:
+  // barriers are computed in the recording order, so they have to be submitted before this one
+  mutable std::vector<std::pair<const VulkanImmediateCommands*, VulkanImmediateCommands::SubmitHandle>> submitAfter_;
+
   VulkanImmediateCommands::SubmitHandle lastSubmitHandle_ = {};
 
   VkPipeline lastPipelineBound_ = VK_NULL_HANDLE;
+  // the bindless pipeline layout of the last bound descriptor set; another thread can grow the bindless tables meanwhile
+  VkPipelineLayout pipelineLayout_ = VK_NULL_HANDLE;
 
   bool isRendering_ = false;
+  // cmdBeginRendering() refused the render pass: nothing is drawn until cmdEndRendering()
+  bool isRenderingRefused_ = false;
 
   lvk::RenderPipelineHandle currentPipeline_ = {};
+  lvk::ComputePipelineHandle currentComputePipeline_ = {};
   RenderPipelineDynamicState dynamicState_ = {};
 };
 
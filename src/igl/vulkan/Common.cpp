@@ -242,6 +242,46 @@ VkCompareOp compareOpToVkCompareOp(lvk::CompareOp func) {
   return VK_COMPARE_OP_ALWAYS;
 }
 
+VkStencilOp stencilOpToVkStencilOp(lvk::StencilOp op) {
+  switch (op) {
+  case lvk::StencilOp_Keep:
+    return VK_STENCIL_OP_KEEP;
+  case lvk::StencilOp_Zero:
+    return VK_STENCIL_OP_ZERO;
+  case lvk::StencilOp_Replace:
+    return VK_STENCIL_OP_REPLACE;
+  case lvk::StencilOp_IncrementClamp:
+    return VK_STENCIL_OP_INCREMENT_AND_CLAMP;
+  case lvk::StencilOp_DecrementClamp:
+    return VK_STENCIL_OP_DECREMENT_AND_CLAMP;
+  case lvk::StencilOp_Invert:
+    return VK_STENCIL_OP_INVERT;
+  case lvk::StencilOp_IncrementWrap:
+    return VK_STENCIL_OP_INCREMENT_AND_WRAP;
+  case lvk::StencilOp_DecrementWrap:
+    return VK_STENCIL_OP_DECREMENT_AND_WRAP;
+  }
+  IGL_ASSERT(false);
+  return VK_STENCIL_OP_KEEP;
+}
+
+VkPrimitiveTopology primitiveTypeToVkPrimitiveTopology(lvk::PrimitiveType t) {
+  switch (t) {
+  case lvk::Primitive_Point:
+    return VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+  case lvk::Primitive_Line:
+    return VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+  case lvk::Primitive_LineStrip:
+    return VK_PRIMITIVE_TOPOLOGY_LINE_STRIP;
+  case lvk::Primitive_Triangle:
+    return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+  case lvk::Primitive_TriangleStrip:
+    return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+  }
+  IGL_ASSERT_MSG(false, "Implement PrimitiveType = %u", (uint32_t)t);
+  return VK_PRIMITIVE_TOPOLOGY_MAX_ENUM;
+}
+
 VkSampleCountFlagBits getVulkanSampleCountFlags(size_t numSamples) {
   if (numSamples <= 1) {
     return VK_SAMPLE_COUNT_1_BIT;
@@ -61,6 +61,8 @@ uint32_t getBytesPerPixel(VkFormat format);
 VkFormat textureFormatToVkFormat(lvk::Format format);
 VkMemoryPropertyFlags storageTypeToVkMemoryPropertyFlags(lvk::StorageType storage);
 VkCompareOp compareOpToVkCompareOp(lvk::CompareOp func);
+VkStencilOp stencilOpToVkStencilOp(lvk::StencilOp op);
+VkPrimitiveTopology primitiveTypeToVkPrimitiveTopology(lvk::PrimitiveType t);
 VkSampleCountFlagBits getVulkanSampleCountFlags(size_t numSamples);
 VkSurfaceFormatKHR colorSpaceToVkSurfaceFormat(lvk::ColorSpace colorSpace, bool isBGR = false);
 
@@ -22,6 +22,9 @@
 
 namespace {
 
+// BufferSlice allocations are carved out of buffers of this size (or larger if a single slice does not fit)
+constexpr VkDeviceSize kBufferSliceBlockSize = 64u * 1024u * 1024u;
+
 bool supportsFormat(VkPhysicalDevice physicalDevice, VkFormat format) {
   VkFormatProperties properties;
   vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
@@ -45,72 +48,203 @@ VkShaderStageFlagBits shaderStageToVkShaderStage(lvk::ShaderStage stage) {
   return VK_SHADER_STAGE_FLAG_BITS_MAX_ENUM;
 }
 
+// packs all fields of SamplerStateDesc except `debugName` into a single key (4 bits per enum)
+uint64_t getSamplerCacheKey(const lvk::SamplerStateDesc& desc) {
+  IGL_ASSERT(desc.minFilter < 16 && desc.magFilter < 16 && desc.mipMap < 16);
+  IGL_ASSERT(desc.wrapU < 16 && desc.wrapV < 16 && desc.wrapW < 16 && desc.depthCompareOp < 16);
+
+  return uint64_t(desc.minFilter) | (uint64_t(desc.magFilter) << 4) | (uint64_t(desc.mipMap) << 8) | (uint64_t(desc.wrapU) << 12) |
+         (uint64_t(desc.wrapV) << 16) | (uint64_t(desc.wrapW) << 20) | (uint64_t(desc.depthCompareOp) << 24) |
+         (uint64_t(desc.mipLodMin) << 28) | (uint64_t(desc.mipLodMax) << 36) | (uint64_t(desc.maxAnisotropic) << 44) |
+         (uint64_t(desc.depthCompareEnabled ? 1 : 0) << 52);
+}
+
 } // namespace
 
 namespace lvk::vulkan {
 
 Device::Device(std::unique_ptr<VulkanContext> ctx) : ctx_(std::move(ctx)) {}
 
-ICommandBuffer& Device::acquireCommandBuffer() {
+Device::~Device() {
+  for (SliceBlock& b : sliceBlocks_) {
+    vmaClearVirtualBlock(b.block);
+    vmaDestroyVirtualBlock(b.block);
+    destroy(b.buffer);
+  }
+}
+
+ICommandBuffer& Device::acquireCommandBuffer(lvk::QueueType queueType) {
   IGL_PROFILER_FUNCTION();
 
-  IGL_ASSERT_MSG(!currentCommandBuffer_.ctx_, "Cannot acquire more than 1 command buffer simultaneously");
+  CommandBuffer* cmdBuffer = nullptr;
+
+  {
+    std::lock_guard<std::mutex> lock(commandBuffersMutex_);
 
-  currentCommandBuffer_ = CommandBuffer(ctx_.get());
+    if (freeCommandBuffers_.empty()) {
+      commandBuffers_.emplace_back(std::make_unique<CommandBuffer>());
+      freeCommandBuffers_.push_back(commandBuffers_.back().get());
+    }
+
+    cmdBuffer = freeCommandBuffers_.back();
+    freeCommandBuffers_.pop_back();
+  }
+
+  // can block until a VkCommandBuffer becomes available - do not hold the lock here
+  *cmdBuffer = CommandBuffer(ctx_.get(), queueType);
 
-  return currentCommandBuffer_;
+  return *cmdBuffer;
 }
 
 void Device::submit(const lvk::ICommandBuffer& commandBuffer, lvk::QueueType queueType, TextureHandle present) {
+  const lvk::ICommandBuffer* commandBuffers[] = {&commandBuffer};
+
+  submit(commandBuffers, 1u, queueType, present);
+}
+
+void Device::submit(const lvk::ICommandBuffer* const* commandBuffers,
+                    uint32_t numCommandBuffers,
+                    lvk::QueueType queueType,
+                    TextureHandle present) {
   IGL_PROFILER_FUNCTION();
 
+  if (!IGL_VERIFY(commandBuffers && numCommandBuffers > 0)) {
+    return;
+  }
+
+  IGL_ASSERT(numCommandBuffers <= VulkanImmediateCommands::kMaxCommandBuffers);
+
   const VulkanContext& ctx = getVulkanContext();
 
-  vulkan::CommandBuffer* vkCmdBuffer = const_cast<vulkan::CommandBuffer*>(static_cast<const vulkan::CommandBuffer*>(&commandBuffer));
+  vulkan::CommandBuffer* vkCmdBuffers[VulkanImmediateCommands::kMaxCommandBuffers] = {};
+  const VulkanImmediateCommands::CommandBufferWrapper* wrappers[VulkanImmediateCommands::kMaxCommandBuffers] = {};
+
+  for (uint32_t i = 0; i != numCommandBuffers; i++) {
+    vkCmdBuffers[i] = const_cast<vulkan::CommandBuffer*>(static_cast<const vulkan::CommandBuffer*>(commandBuffers[i]));
+
+    IGL_ASSERT(vkCmdBuffers[i]);
+    IGL_ASSERT(vkCmdBuffers[i]->ctx_);
+    IGL_ASSERT(vkCmdBuffers[i]->wrapper_);
+    IGL_ASSERT_MSG((queueType == QueueType_Compute) == (vkCmdBuffers[i]->queueType_ == QueueType_Compute),
+                   "The command buffer was acquired for a different queue");
+    IGL_ASSERT_MSG(vkCmdBuffers[i]->immediate_ == vkCmdBuffers[0]->immediate_, "All command buffers in a batch should use the same queue");
+
+    wrappers[i] = vkCmdBuffers[i]->wrapper_;
+  }
+
+  // resources transitioned by several command buffers have to be submitted in the order they were recorded in
+  for (uint32_t i = 0; i != numCommandBuffers; i++) {
+    for (const auto& [queue, handle] : vkCmdBuffers[i]->submitAfter_) {
+      bool isSubmittedBefore = !queue->isEncoding(handle);
+      for (uint32_t j = 0; j != i && !isSubmittedBefore; j++) {
+        isSubmittedBefore = vkCmdBuffers[j]->immediate_ == queue && wrappers[j]->handle_.handle() == handle.handle();
+      }
+      IGL_ASSERT_MSG(isSubmittedBefore,
+                     "A texture or buffer was transitioned by another command buffer which has to be submitted before this one");
+    }
+  }
 
-  IGL_ASSERT(vkCmdBuffer);
-  IGL_ASSERT(vkCmdBuffer->ctx_);
-  IGL_ASSERT(vkCmdBuffer->wrapper_);
+  vulkan::CommandBuffer* lastCmdBuffer = vkCmdBuffers[numCommandBuffers - 1];
 
   const bool isGraphicsQueue = queueType == QueueType_Graphics;
+  const bool isAsyncCompute = lastCmdBuffer->immediate_ == ctx.immediateCompute_.get();
 
   if (present) {
+    IGL_ASSERT_MSG(!isAsyncCompute, "Cannot present from the compute queue");
     const lvk::vulkan::VulkanTexture& tex = *ctx.texturesPool_.get(present);
 
     IGL_ASSERT(tex.isSwapchainTexture());
 
-    // prepare image for presentation the image might be coming from a compute shader
-    const VkPipelineStageFlagBits srcStage = (tex.image_->imageLayout_ == VK_IMAGE_LAYOUT_GENERAL)
-                                                 ? VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
-                                                 : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    tex.image_->transitionLayout(
-        vkCmdBuffer->wrapper_->cmdBuf_,
-        VK_IMAGE_LAYOUT_PRESENT_SRC_KHR,
-        srcStage,
-        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, // wait for all subsequent operations
-        VkImageSubresourceRange{VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS});
+    // prepare image for presentation: the source stages (rendering or a compute shader) come from the tracked state
+    const VkImageSubresourceRange range = {VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+    lastCmdBuffer->transitionImage(*tex.image_, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE, range);
+    // the next transition of this image has to be chained with the wait on its acquire semaphore
+    tex.image_->setImageLayout(
+        VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, range, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
+  }
+
+  // pending transitions are recorded before the command buffers are ended
+  for (uint32_t i = 0; i != numCommandBuffers; i++) {
+    vkCmdBuffers[i]->flushBarriers();
+  }
+
+  // uploads running on the dedicated transfer queue have to be visible to these command buffers
+  ctx.stagingDevice_->acquirePendingOwnership();
+
+  if (ctx.transientArena_) {
+    ctx.transientArena_->flush();
   }
 
   const bool shouldPresent = isGraphicsQueue && ctx.hasSwapchain() && present;
   if (shouldPresent) {
-    ctx.immediate_->waitSemaphore(ctx.swapchain_->acquireSemaphore_);
+    // the wait applies to every command buffer of the batch: their color attachment output and compute stages wait for
+    // the swapchain image, earlier stages (i.e. vertex processing) can start before it has been acquired
+    ctx.immediate_->waitSemaphore(ctx.swapchain_->acquireSemaphore_,
+                                  VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT);
   }
 
-  vkCmdBuffer->lastSubmitHandle_ = ctx.immediate_->submit(*vkCmdBuffer->wrapper_);
+  if (isAsyncCompute) {
+    // async compute consumes everything submitted to the graphics queue so far...
+    VulkanImmediateCommands& compute = *ctx.immediateCompute_;
+    compute.waitTimelineSemaphore(ctx.immediate_->getTimelineSemaphore(),
+                                  ctx.immediate_->getLastSignaledValue(),
+                                  VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_TRANSFER_BIT);
+    compute.submit(wrappers, numCommandBuffers);
+    // ...and the next graphics submit consumes its results
+    ctx.immediate_->waitTimelineSemaphore(compute.getTimelineSemaphore(),
+                                          compute.getLastSignaledValue(),
+                                          VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT |
+                                              VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT |
+                                              VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_TRANSFER_BIT);
+  } else {
+    ctx.immediate_->submit(wrappers, numCommandBuffers, shouldPresent);
+  }
 
   if (shouldPresent) {
     ctx.present();
   }
 
+  if (ctx.transientArena_ && isGraphicsQueue && present) {
+    // the graphics queue consumes the results of async compute: this is the last submit of the frame
+    ctx.transientArena_->endFrame(ctx.immediate_->getLastSubmitHandle());
+  }
+
   ctx.processDeferredTasks();
+  ctx.stagingDevice_->processDownloads();
 
-  // reset
-  currentCommandBuffer_ = {};
+  for (uint32_t i = 0; i != numCommandBuffers; i++) {
+    // reset
+    *vkCmdBuffers[i] = {};
+  }
+
+  std::lock_guard<std::mutex> lock(commandBuffersMutex_);
+
+  freeCommandBuffers_.insert(freeCommandBuffers_.end(), vkCmdBuffers, vkCmdBuffers + numCommandBuffers);
 }
 
 Holder<BufferHandle> Device::createBuffer(const BufferDesc& requestedDesc, Result* outResult) {
   BufferDesc desc = requestedDesc;
 
+  // the access hint overrides the placement implied by the storage type
+  switch (desc.access) {
+  case BufferAccess_Default:
+    break;
+  case BufferAccess_Static:
+    desc.storage = StorageType_Device;
+    break;
+  case BufferAccess_Stream:
+    desc.storage = ctx_->reserveReBarMemory(desc.size) ? StorageType_Device : StorageType_HostVisible;
+    break;
+  case BufferAccess_Upload:
+  case BufferAccess_Readback:
+    desc.storage = StorageType_HostVisible;
+    break;
+  }
+
+  // BufferAccess_Stream has reserved its Resizable BAR memory above; this is opt-in because writes into Resizable BAR
+  // memory are not ordered with the GPU work in flight, unlike the staging copies used for other device-local buffers
+  const bool useReBar = desc.access == BufferAccess_Stream && desc.storage == StorageType_Device;
+
   if (!ctx_->useStaging_ && (desc.storage == StorageType_Device)) {
     desc.storage = StorageType_HostVisible;
   }
@@ -142,12 +276,26 @@ Holder<BufferHandle> Device::createBuffer(const BufferDesc& requestedDesc, Resul
     usageFlags |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT_KHR;
   }
 
-  const VkMemoryPropertyFlags memFlags = storageTypeToVkMemoryPropertyFlags(desc.storage);
+  VkMemoryPropertyFlags memFlags = storageTypeToVkMemoryPropertyFlags(desc.storage);
+
+  // see VulkanBuffer: host-visible memory without HOST_CACHED is written sequentially (write-combined)
+  if (useReBar) {
+    memFlags |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+  } else if (desc.access == BufferAccess_Stream || desc.access == BufferAccess_Upload) {
+    memFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+  } else if (desc.access == BufferAccess_Readback) {
+    memFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+  } else if (desc.storage == StorageType_HostVisible) {
+    memFlags |= VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+  }
 
   Result result;
   BufferHandle handle = ctx_->createBuffer(desc.size, usageFlags, memFlags, &result, desc.debugName);
 
   if (!IGL_VERIFY(result.isOk())) {
+    if (useReBar) {
+      ctx_->releaseReBarMemory(desc.size);
+    }
     Result::setResult(outResult, result);
     return {};
   }
@@ -164,6 +312,19 @@ Holder<BufferHandle> Device::createBuffer(const BufferDesc& requestedDesc, Resul
 Holder<SamplerHandle> Device::createSampler(const SamplerStateDesc& desc, Result* outResult) {
   IGL_PROFILER_FUNCTION();
 
+  const uint64_t key = getSamplerCacheKey(desc);
+
+  // identical sampler states share the same VkSampler and the same bindless index
+  auto it = samplerCache_.find(key);
+
+  if (it != samplerCache_.end()) {
+    IGL_ASSERT(ctx_->samplersPool_.get(it->second.handle));
+    it->second.refCount++;
+    samplerCacheStats_.hits++;
+    Result::setResult(outResult, Result());
+    return {this, it->second.handle};
+  }
+
   Result result;
 
   SamplerHandle handle = ctx_->createSampler(
@@ -174,6 +335,10 @@ Holder<SamplerHandle> Device::createSampler(const SamplerStateDesc& desc, Result
     return {};
   }
 
+  samplerCacheStats_.misses++;
+  samplerCache_[key] = {handle, 1u};
+  samplerCacheKeys_[handle.index()] = key;
+
   Holder<SamplerHandle> holder = {this, handle};
 
   Result::setResult(outResult, result);
@@ -228,6 +393,14 @@ Holder<TextureHandle> Device::createTexture(const TextureDesc& requestedDesc, co
     desc.usage = lvk::TextureUsageBits_Sampled;
   }
 
+  const bool isMemoryless = desc.storage == StorageType_Memoryless;
+
+  // memoryless textures exist only inside render passes: they cannot be sampled, copied, or have mip-levels
+  if (isMemoryless && !IGL_VERIFY(desc.usage == lvk::TextureUsageBits_Attachment && desc.numMipLevels == 1 && !desc.data)) {
+    Result::setResult(outResult, Result::Code::ArgumentOutOfRange, "Memoryless textures can only be single-level attachments");
+    return {};
+  }
+
   /* Use staging device to transfer data into the image when the storage is private to the device */
   VkImageUsageFlags usageFlags = (desc.storage == StorageType_Device) ? VK_IMAGE_USAGE_TRANSFER_DST_BIT : 0;
 
@@ -243,12 +416,21 @@ Holder<TextureHandle> Device::createTexture(const TextureDesc& requestedDesc, co
                                                            : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
   }
 
-  // For now, always set this flag so we can read it back
-  usageFlags |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+  if (isMemoryless) {
+    usageFlags |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+  } else {
+    // For now, always set this flag so we can read it back
+    usageFlags |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+  }
 
   IGL_ASSERT_MSG(usageFlags != 0, "Invalid usage flags");
 
-  const VkMemoryPropertyFlags memFlags = storageTypeToVkMemoryPropertyFlags(desc.storage);
+  VkMemoryPropertyFlags memFlags = storageTypeToVkMemoryPropertyFlags(desc.storage);
+
+  // no lazily allocated memory (desktop GPUs): a transient image in regular device memory
+  if (isMemoryless && !ctx_->hasLazilyAllocatedMemory_) {
+    memFlags &= ~VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+  }
 
   const bool hasDebugName = desc.debugName && *desc.debugName;
 
@@ -287,6 +469,12 @@ Holder<TextureHandle> Device::createTexture(const TextureDesc& requestedDesc, co
     return {};
   }
 
+  // uploads bypass the staging buffer: VulkanStagingDevice writes texels with vkCopyMemoryToImageEXT()
+  if (desc.storage == StorageType_Device && samples == VK_SAMPLE_COUNT_1_BIT &&
+      ctx_->isHostImageCopyOptimal(vkFormat, imageType, usageFlags, createFlags)) {
+    usageFlags |= VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT;
+  }
+
   Result result;
   auto image = ctx_->createImage(imageType,
                                  VkExtent3D{desc.dimensions.width, desc.dimensions.height, desc.dimensions.depth},
@@ -321,12 +509,9 @@ Holder<TextureHandle> Device::createTexture(const TextureDesc& requestedDesc, co
     return {};
   }
 
+  // bindless tables grow on demand in VulkanContext::checkAndUpdateDescriptorSets()
   TextureHandle handle = ctx_->texturesPool_.create(vulkan::VulkanTexture(std::move(image), std::move(imageView)));
 
-  IGL_ASSERT(ctx_->texturesPool_.numObjects() <= ctx_->config_.maxTextures);
-
-  ctx_->awaitingCreation_ = true;
-
   if (desc.data) {
     IGL_ASSERT(desc.type == TextureType_2D);
     const void* mipMaps[] = {desc.data};
@@ -348,29 +533,22 @@ lvk::Holder<lvk::ComputePipelineHandle> Device::createComputePipeline(const Comp
     return {};
   }
 
-  const VulkanShaderModule* sm = ctx_->shaderModulesPool_.get(desc.shaderStages.getModule(Stage_Compute));
-
-  IGL_ASSERT(sm);
-
-  VkShaderModule vkShaderModule = sm ? sm->getVkShaderModule() : VK_NULL_HANDLE;
+  // the shader module is owned by the pipeline and is kept alive to recreate the pipeline when the bindless
+  // pipeline layout changes
+  ComputePipelineHandle handle = ctx_->computePipelinesPool_.create(ComputePipelineState{
+      .shaderModule_ = desc.shaderStages.getModule(Stage_Compute),
+      .debugName_ = desc.debugName,
+  });
 
-  const VkComputePipelineCreateInfo ci = {
-      .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
-      .flags = 0,
-      .stage = ivkGetPipelineShaderStageCreateInfo(VK_SHADER_STAGE_COMPUTE_BIT, vkShaderModule, sm->getEntryPoint()),
-      .layout = ctx_->vkPipelineLayout_,
-      .basePipelineHandle = VK_NULL_HANDLE,
-      .basePipelineIndex = -1,
-  };
-  VkPipeline pipeline = VK_NULL_HANDLE;
-  VK_ASSERT(vkCreateComputePipelines(ctx_->getVkDevice(), ctx_->pipelineCache_, 1, &ci, nullptr, &pipeline));
-  VK_ASSERT(ivkSetDebugObjectName(ctx_->getVkDevice(), VK_OBJECT_TYPE_PIPELINE, (uint64_t)pipeline, desc.debugName));
+  if (!IGL_VERIFY(ctx_->getVkPipeline(handle, ctx_->getVkPipelineLayout()) != VK_NULL_HANDLE)) {
+    destroy(handle);
+    Result::setResult(outResult, Result::Code::RuntimeError, "Cannot create compute pipeline");
+    return {};
+  }
 
-  // a shader module can be destroyed while pipelines created using its shaders are still in use
-  // https://registry.khronos.org/vulkan/specs/1.3/html/chap9.html#vkDestroyShaderModule
-  destroy(desc.shaderStages.getModule(Stage_Compute));
+  Result::setResult(outResult, Result());
 
-  return {this, ctx_->computePipelinesPool_.create(std::move(pipeline))};
+  return {this, handle};
 }
 
 lvk::Holder<lvk::RenderPipelineHandle> Device::createRenderPipeline(const RenderPipelineDesc& desc, Result* outResult) {
@@ -395,14 +573,47 @@ lvk::Holder<lvk::RenderPipelineHandle> Device::createRenderPipeline(const Render
   return {this, ctx_->renderPipelinesPool_.create(RenderPipelineState(this, desc))};
 }
 
+void Device::prewarmRenderPipeline(RenderPipelineHandle handle, const RenderPipelineVariant* variants, uint32_t numVariants) {
+  IGL_PROFILER_FUNCTION();
+
+  const RenderPipelineState* rps = ctx_->renderPipelinesPool_.get(handle);
+
+  if (!IGL_VERIFY(rps) || !numVariants) {
+    return;
+  }
+
+  IGL_ASSERT(variants);
+
+  // the same dynamic state as recorded by CommandBuffer for these variants
+  std::vector<RenderPipelineDynamicState> dynamicStates(numVariants);
+
+  for (uint32_t i = 0; i != numVariants; i++) {
+    RenderPipelineDynamicState& state = dynamicStates[i];
+    state.setTopology(primitiveTypeToVkPrimitiveTopology(variants[i].topology));
+    state.setDepthStencilState(variants[i].depthStencil);
+    state.depthBiasEnable_ = variants[i].depthBiasEnable;
+  }
+
+  rps->prewarm(dynamicStates.data(), numVariants);
+}
+
 void Device::destroy(lvk::ComputePipelineHandle handle) {
-  VkPipeline* pipeline = ctx_->computePipelinesPool_.get(handle);
+  ComputePipelineState* cps = ctx_->computePipelinesPool_.get(handle);
 
-  IGL_ASSERT(pipeline);
-  IGL_ASSERT(*pipeline != VK_NULL_HANDLE);
+  IGL_ASSERT(cps);
 
-  ctx_->deferredTask(
-      std::packaged_task<void()>([device = ctx_->getVkDevice(), pipeline = *pipeline]() { vkDestroyPipeline(device, pipeline, nullptr); }));
+  if (!cps) {
+    return;
+  }
+
+  if (cps->pipeline_ != VK_NULL_HANDLE) {
+    ctx_->deferredTask(
+        std::packaged_task<void()>([device = ctx_->getVkDevice(), pipeline = cps->pipeline_]() { vkDestroyPipeline(device, pipeline, nullptr); }));
+  }
+
+  // a shader module can be destroyed while pipelines created using its shaders are still in use
+  // https://registry.khronos.org/vulkan/specs/1.3/html/chap9.html#vkDestroyShaderModule
+  destroy(cps->shaderModule_);
 
   ctx_->computePipelinesPool_.destroy(handle);
 }
@@ -418,26 +629,166 @@ void Device::destroy(lvk::ShaderModuleHandle handle) {
 void Device::destroy(SamplerHandle handle) {
   IGL_PROFILER_FUNCTION_COLOR(IGL_PROFILER_COLOR_DESTROY);
 
+  if (!ctx_->samplersPool_.get(handle)) {
+    return;
+  }
+
+  // cached samplers are reference-counted: destroy the VkSampler only when the last Holder goes away
+  auto itKey = samplerCacheKeys_.find(handle.index());
+
+  if (itKey != samplerCacheKeys_.end()) {
+    auto it = samplerCache_.find(itKey->second);
+    IGL_ASSERT(it != samplerCache_.end() && it->second.handle == handle);
+    IGL_ASSERT(it->second.refCount > 0);
+    if (--it->second.refCount) {
+      return;
+    }
+    samplerCache_.erase(it);
+    samplerCacheKeys_.erase(itKey);
+  }
+
   VkSampler sampler = *ctx_->samplersPool_.get(handle);
 
   ctx_->samplersPool_.destroy(handle);
 
   ctx_->deferredTask(
       std::packaged_task<void()>([device = ctx_->vkDevice_, sampler = sampler]() { vkDestroySampler(device, sampler, nullptr); }));
-
-  // inform the context it should prune the samplers
-  ctx_->awaitingDeletion_ = true;
 }
 
 void Device::destroy(BufferHandle handle) {
+  // deferred destruction is tracked on the graphics queue: hand off any in-flight transfer-queue uploads first
+  ctx_->stagingDevice_->acquirePendingOwnership();
   ctx_->buffersPool_.destroy(handle);
 }
 
+Holder<BufferSlice> Device::createBufferSlice(const BufferDesc& desc, Result* outResult) {
+  IGL_PROFILER_FUNCTION();
+
+  if (!IGL_VERIFY(desc.size)) {
+    Result::setResult(outResult, Result(Result::Code::ArgumentOutOfRange, "Invalid buffer slice size"));
+    return {};
+  }
+
+  const VkPhysicalDeviceLimits& limits = ctx_->getVkPhysicalDeviceProperties().limits;
+
+  // buffer_reference blocks are 16-byte aligned by default
+  VkDeviceSize alignment = 16;
+  if (desc.usage & BufferUsageBits_Uniform) {
+    alignment = std::max(alignment, limits.minUniformBufferOffsetAlignment);
+  }
+  if (desc.usage & BufferUsageBits_Storage) {
+    alignment = std::max(alignment, limits.minStorageBufferOffsetAlignment);
+  }
+
+  const VmaVirtualAllocationCreateInfo ai = {
+      .size = desc.size,
+      .alignment = alignment,
+  };
+
+  BufferSlice slice;
+
+  {
+    std::lock_guard<std::mutex> lock(slicesMutex_);
+
+    // recycle the ranges the GPU is done with
+    std::erase_if(pendingSliceFrees_, [this](const PendingSliceFree& f) {
+      if (!ctx_->immediate_->isReady(f.handle) || (ctx_->immediateCompute_ && !ctx_->immediateCompute_->isReady(f.handleCompute))) {
+        return false;
+      }
+      for (const SliceBlock& b : sliceBlocks_) {
+        if (b.buffer == f.buffer) {
+          vmaVirtualFree(b.block, f.allocation);
+        }
+      }
+      return true;
+    });
+
+    auto tryAllocate = [&ai, &slice](const SliceBlock& b) -> bool {
+      VmaVirtualAllocation allocation = VK_NULL_HANDLE;
+      VkDeviceSize offset = 0;
+      if (vmaVirtualAllocate(b.block, &ai, &allocation, &offset) != VK_SUCCESS) {
+        return false;
+      }
+      slice = {.buffer = b.buffer, .allocation = (uint64_t)allocation, .offset = offset, .size = ai.size};
+      return true;
+    };
+
+    for (const SliceBlock& b : sliceBlocks_) {
+      if (b.usage == desc.usage && b.storage == desc.storage && b.access == desc.access && tryAllocate(b)) {
+        break;
+      }
+    }
+
+    if (slice.empty()) {
+      // the whole block has to fit into the uniform buffer range
+      const VkDeviceSize blockSize = std::max(
+          (desc.usage & BufferUsageBits_Uniform) ? std::min(kBufferSliceBlockSize, VkDeviceSize(limits.maxUniformBufferRange))
+                                                 : kBufferSliceBlockSize,
+          VkDeviceSize(desc.size));
+
+      Result result;
+      Holder<BufferHandle> buffer = createBuffer(
+          {
+              .usage = desc.usage,
+              .storage = desc.storage,
+              .access = desc.access,
+              .size = blockSize,
+              .debugName = "Buffer: slices",
+          },
+          &result);
+      if (!result.isOk()) {
+        Result::setResult(outResult, result);
+        return {};
+      }
+
+      const VmaVirtualBlockCreateInfo ci = {
+          .size = blockSize,
+      };
+      SliceBlock block = {
+          .buffer = buffer.release(),
+          .usage = desc.usage,
+          .storage = desc.storage,
+          .access = desc.access,
+      };
+      VK_ASSERT(vmaCreateVirtualBlock(&ci, &block.block));
+      sliceBlocks_.push_back(block);
+
+      IGL_VERIFY(tryAllocate(block));
+    }
+  }
+
+  if (desc.data) {
+    const Result result = upload(slice.buffer, desc.data, desc.size, slice.offset);
+    if (!IGL_VERIFY(result.isOk())) {
+      destroy(slice);
+      Result::setResult(outResult, result);
+      return {};
+    }
+  }
+
+  Result::setResult(outResult, Result());
+
+  return {this, slice};
+}
+
+void Device::destroy(const BufferSlice& slice) {
+  if (slice.empty()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(slicesMutex_);
+
+  pendingSliceFrees_.push_back({
+      .buffer = slice.buffer,
+      .allocation = (VmaVirtualAllocation)slice.allocation,
+      .handle = ctx_->immediate_->getNextSubmitHandle(),
+      .handleCompute = ctx_->immediateCompute_ ? ctx_->immediateCompute_->getNextSubmitHandle() : VulkanImmediateCommands::SubmitHandle(),
+  });
+}
+
 void Device::destroy(lvk::TextureHandle handle) {
+  ctx_->stagingDevice_->acquirePendingOwnership();
   ctx_->texturesPool_.destroy(handle);
-
-  // inform the context it should prune the textures
-  ctx_->awaitingDeletion_ = true;
 }
 
 void Device::destroy(Framebuffer& fb) {
@@ -483,6 +834,69 @@ Result Device::upload(BufferHandle handle, const void* data, size_t size, size_t
   return lvk::Result();
 }
 
+SubmitHandle Device::uploadAsync(BufferHandle handle, const void* data, size_t size, size_t offset, Result* outResult) {
+  IGL_PROFILER_FUNCTION();
+
+  if (!IGL_VERIFY(data)) {
+    Result::setResult(outResult, Result::Code::RuntimeError, "Data is null");
+    return {};
+  }
+
+  lvk::vulkan::VulkanBuffer* buf = ctx_->buffersPool_.get(handle);
+
+  if (!IGL_VERIFY(buf)) {
+    Result::setResult(outResult, Result::Code::RuntimeError, "Invalid buffer handle");
+    return {};
+  }
+
+  if (!IGL_VERIFY(offset + size <= buf->getSize())) {
+    Result::setResult(outResult, Result::Code::ArgumentOutOfRange, "Out of range");
+    return {};
+  }
+
+  Result::setResult(outResult, Result());
+
+  return ctx_->stagingDevice_->bufferSubData(*buf, offset, size, data);
+}
+
+SubmitHandle Device::download(BufferHandle handle,
+                              void* data,
+                              size_t size,
+                              size_t offset,
+                              std::function<void()> completionHandler,
+                              Result* outResult) {
+  IGL_PROFILER_FUNCTION();
+
+  if (!IGL_VERIFY(data)) {
+    Result::setResult(outResult, Result::Code::RuntimeError, "Data is null");
+    return {};
+  }
+
+  lvk::vulkan::VulkanBuffer* buf = ctx_->buffersPool_.get(handle);
+
+  if (!IGL_VERIFY(buf)) {
+    Result::setResult(outResult, Result::Code::RuntimeError, "Invalid buffer handle");
+    return {};
+  }
+
+  if (!IGL_VERIFY(offset + size <= buf->getSize())) {
+    Result::setResult(outResult, Result::Code::ArgumentOutOfRange, "Out of range");
+    return {};
+  }
+
+  Result::setResult(outResult, Result());
+
+  return ctx_->stagingDevice_->getBufferSubData(*buf, offset, size, data, std::move(completionHandler));
+}
+
+bool Device::isReady(SubmitHandle handle) const {
+  return ctx_->stagingDevice_->isReady(handle);
+}
+
+void Device::wait(SubmitHandle handle) {
+  ctx_->stagingDevice_->wait(handle);
+}
+
 uint8_t* Device::getMappedPtr(BufferHandle handle) const {
   lvk::vulkan::VulkanBuffer* buf = ctx_->buffersPool_.get(handle);
 
@@ -491,6 +905,20 @@ uint8_t* Device::getMappedPtr(BufferHandle handle) const {
   return buf->isMapped() ? buf->getMappedPtr() : nullptr;
 }
 
+void Device::flushMappedMemory(BufferHandle handle, size_t offset, size_t size) const {
+  lvk::vulkan::VulkanBuffer* buf = ctx_->buffersPool_.get(handle);
+
+  IGL_ASSERT(buf);
+
+  if (!IGL_VERIFY(offset + size <= buf->getSize())) {
+    return;
+  }
+
+  if (!buf->isCoherentMemory()) {
+    buf->flushMappedMemory(offset, size);
+  }
+}
+
 uint64_t Device::gpuAddress(BufferHandle handle, size_t offset) const {
   IGL_ASSERT_MSG((offset & 7) == 0, "Buffer offset must be 8 bytes aligned as per GLSL_EXT_buffer_reference spec.");
 
@@ -501,6 +929,34 @@ uint64_t Device::gpuAddress(BufferHandle handle, size_t offset) const {
   return buf ? (uint64_t)buf->getVkDeviceAddress() + offset : 0u;
 }
 
+TransientAllocation Device::allocateTransient(size_t size, size_t alignment) {
+  vulkan::VulkanTransientArena* arena = nullptr;
+  {
+    // command buffers can be recorded on different threads
+    std::lock_guard<std::mutex> lock(transientArenaMutex_);
+
+    if (!ctx_->transientArena_) {
+      ctx_->transientArena_ = std::make_unique<vulkan::VulkanTransientArena>(
+          *ctx_, ctx_->config_.transientArenaSizePerFrame, ctx_->config_.numTransientArenaFrames);
+    }
+    arena = ctx_->transientArena_.get();
+  }
+
+  return arena->allocate(size, alignment);
+}
+
+void Device::endTransientFrame() {
+  if (!ctx_->transientArena_) {
+    return;
+  }
+
+  // the frame could have been consumed by either queue
+  const VulkanImmediateCommands::SubmitHandle handleCompute =
+      ctx_->immediateCompute_ ? ctx_->immediateCompute_->getLastSubmitHandle() : VulkanImmediateCommands::SubmitHandle();
+
+  ctx_->transientArena_->endFrame(ctx_->immediate_->getLastSubmitHandle(), handleCompute);
+}
+
 static Result validateRange(const lvk::Dimensions& dimensions, uint32_t numLevels, const lvk::TextureRangeDesc& range) {
   if (!IGL_VERIFY(range.dimensions.width > 0 && range.dimensions.height > 0 || range.dimensions.depth > 0 || range.numLayers > 0 ||
                   range.numMipLevels > 0)) {
@@ -538,6 +994,10 @@ Result Device::upload(TextureHandle handle, const TextureRangeDesc& range, const
     return result;
   }
 
+  if (!IGL_VERIFY(!texture->image_->isTransientAttachment())) {
+    return Result(Result::Code::ArgumentOutOfRange, "Memoryless textures cannot be uploaded");
+  }
+
   const uint32_t numLayers = std::max(range.numLayers, 1u);
 
   const VkImageType type = texture->image_->type_;
@@ -559,6 +1019,81 @@ Result Device::upload(TextureHandle handle, const TextureRangeDesc& range, const
   return Result();
 }
 
+SubmitHandle Device::download(TextureHandle handle,
+                              const TextureRangeDesc& range,
+                              void* data,
+                              std::function<void()> completionHandler,
+                              Result* outResult) {
+  IGL_PROFILER_FUNCTION();
+
+  if (!IGL_VERIFY(data)) {
+    Result::setResult(outResult, Result::Code::RuntimeError, "Data is null");
+    return {};
+  }
+
+  lvk::vulkan::VulkanTexture* texture = ctx_->texturesPool_.get(handle);
+
+  if (!IGL_VERIFY(texture)) {
+    Result::setResult(outResult, Result::Code::RuntimeError, "Invalid texture handle");
+    return {};
+  }
+
+  const auto result = validateRange(texture->getDimensions(), texture->image_->levels_, range);
+
+  if (!IGL_VERIFY(result.isOk())) {
+    Result::setResult(outResult, result);
+    return {};
+  }
+
+  const lvk::vulkan::VulkanImage& image = *texture->image_.get();
+
+  if (!IGL_VERIFY(!image.isTransientAttachment())) {
+    Result::setResult(outResult, Result::Code::RuntimeError, "Memoryless textures cannot be downloaded");
+    return {};
+  }
+
+  // the tracked layout includes transitions recorded in command buffers which have not been submitted yet, while the
+  // readback is submitted right away; held until the readback is recorded so that no other transitions sneak in
+  std::lock_guard<std::recursive_mutex> lock(ctx_->resourceStatesMutex_);
+
+  if (!IGL_VERIFY(!image.lastRecorderQueue_ || !image.lastRecorderQueue_->isEncoding(image.lastRecorder_))) {
+    Result::setResult(outResult, Result::Code::RuntimeError, "The texture is used by a command buffer which has not been submitted");
+    return {};
+  }
+
+  const VkImageLayout layout = image.getImageLayout(range.mipLevel, range.layer);
+
+  if (!IGL_VERIFY(image.type_ == VK_IMAGE_TYPE_2D && layout != VK_IMAGE_LAYOUT_UNDEFINED)) {
+    Result::setResult(outResult, Result::Code::RuntimeError, "Only initialized 2D textures can be downloaded");
+    return {};
+  }
+
+  // the copy reads only the color aspect
+  if (!IGL_VERIFY(!image.isDepthFormat_ && !image.isStencilFormat_)) {
+    Result::setResult(outResult, Result::Code::RuntimeError, "Depth and stencil textures cannot be downloaded");
+    return {};
+  }
+
+  const uint64_t storageSize = uint64_t(range.dimensions.width) * range.dimensions.height * getBytesPerPixel(image.imageFormat_);
+
+  if (!IGL_VERIFY(storageSize <= ctx_->stagingDevice_->getMaxImageReadbackSize())) {
+    Result::setResult(outResult, Result::Code::ArgumentOutOfRange, "The texture region does not fit into the readback buffer");
+    return {};
+  }
+
+  Result::setResult(outResult, Result());
+
+  return ctx_->stagingDevice_->getImageData2D(image.getVkImage(),
+                                              range.mipLevel,
+                                              range.layer,
+                                              ivkGetRect2D(range.x, range.y, range.dimensions.width, range.dimensions.height),
+                                              image.imageFormat_,
+                                              layout,
+                                              data,
+                                              false,
+                                              std::move(completionHandler));
+}
+
 Dimensions Device::getDimensions(TextureHandle handle) const {
   if (!handle) {
     return {};
@@ -575,7 +1110,7 @@ void Device::generateMipmap(TextureHandle handle) const {
   lvk::vulkan::VulkanTexture* tex = ctx_->texturesPool_.get(handle);
 
   if (tex->image_->levels_ > 1) {
-    IGL_ASSERT(tex->image_->imageLayout_ != VK_IMAGE_LAYOUT_UNDEFINED);
+    IGL_ASSERT(tex->image_->getImageLayout() != VK_IMAGE_LAYOUT_UNDEFINED);
     const auto& wrapper = ctx_->immediate_->acquire();
     tex->image_->generateMipmap(wrapper.cmdBuf_);
     ctx_->immediate_->submit(wrapper);
@@ -11,7 +11,10 @@
 #include <lvk/Pool.h>
 #include <igl/vulkan/Common.h>
 #include <igl/vulkan/CommandBuffer.h>
+#include <lvk/vulkan/VulkanUtils.h>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 namespace lvk {
@@ -24,10 +27,15 @@ class VulkanShaderModule;
 class Device final : public IDevice {
  public:
   explicit Device(std::unique_ptr<VulkanContext> ctx);
+  ~Device() override;
 
-  ICommandBuffer& acquireCommandBuffer() override;
+  ICommandBuffer& acquireCommandBuffer(lvk::QueueType queueType) override;
 
   void submit(const lvk::ICommandBuffer& commandBuffer, lvk::QueueType queueType, TextureHandle present) override;
+  void submit(const lvk::ICommandBuffer* const* commandBuffers,
+              uint32_t numCommandBuffers,
+              lvk::QueueType queueType,
+              TextureHandle present) override;
 
   Holder<BufferHandle> createBuffer(const BufferDesc& desc, Result* outResult) override;
   Holder<SamplerHandle> createSampler(const SamplerStateDesc& desc, Result* outResult) override;
@@ -37,6 +45,8 @@ class Device final : public IDevice {
   Holder<RenderPipelineHandle> createRenderPipeline(const RenderPipelineDesc& desc, Result* outResult) override;
   Holder<ShaderModuleHandle> createShaderModule(const ShaderModuleDesc& desc, Result* outResult) override;
 
+  void prewarmRenderPipeline(RenderPipelineHandle handle, const RenderPipelineVariant* variants, uint32_t numVariants) override;
+
   void destroy(ComputePipelineHandle handle) override;
   void destroy(RenderPipelineHandle handle) override;
   void destroy(ShaderModuleHandle handle) override;
@@ -45,18 +55,52 @@ class Device final : public IDevice {
   void destroy(TextureHandle handle) override;
   void destroy(Framebuffer& fb) override;
 
+  Holder<BufferSlice> createBufferSlice(const BufferDesc& desc, Result* outResult) override;
+  void destroy(const BufferSlice& slice) override;
+
+  // the BufferSlice overloads of IDevice
+  using IDevice::gpuAddress;
+  using IDevice::upload;
+
   Result upload(BufferHandle handle, const void* data, size_t size, size_t offset) override;
+  SubmitHandle uploadAsync(BufferHandle handle, const void* data, size_t size, size_t offset, Result* outResult) override;
+  SubmitHandle download(BufferHandle handle,
+                        void* data,
+                        size_t size,
+                        size_t offset,
+                        std::function<void()> completionHandler,
+                        Result* outResult) override;
   uint8_t* getMappedPtr(BufferHandle handle) const override;
+  void flushMappedMemory(BufferHandle handle, size_t offset, size_t size) const override;
   uint64_t gpuAddress(BufferHandle handle, size_t offset) const override;
+  TransientAllocation allocateTransient(size_t size, size_t alignment) override;
+  void endTransientFrame() override;
 
   Result upload(TextureHandle handle, const TextureRangeDesc& range, const void* data[]) const override;
+  SubmitHandle download(TextureHandle handle,
+                        const TextureRangeDesc& range,
+                        void* data,
+                        std::function<void()> completionHandler,
+                        Result* outResult) override;
   Dimensions getDimensions(TextureHandle handle) const override;
   void generateMipmap(TextureHandle handle) const override;
   Format getFormat(TextureHandle handle) const override;
 
+  bool isReady(SubmitHandle handle) const override;
+  void wait(SubmitHandle handle) override;
+
   TextureHandle getCurrentSwapchainTexture() override;
   Format getSwapchainFormat() const override;
 
+  struct SamplerCacheStats {
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+  };
+
+  SamplerCacheStats getSamplerCacheStats() const {
+    return samplerCacheStats_;
+  }
+
   VulkanContext& getVulkanContext() {
     return *ctx_.get();
   }
@@ -91,7 +135,39 @@ class Device final : public IDevice {
 
   std::unique_ptr<VulkanContext> ctx_;
 
-  lvk::vulkan::CommandBuffer currentCommandBuffer_;
+  // command buffers being recorded now (possibly on different threads) and the ones available for reuse
+  std::mutex commandBuffersMutex_;
+  std::vector<std::unique_ptr<lvk::vulkan::CommandBuffer>> commandBuffers_;
+  std::vector<lvk::vulkan::CommandBuffer*> freeCommandBuffers_;
+
+  std::mutex transientArenaMutex_; // lazy creation of VulkanContext::transientArena_
+
+  // BufferSlice: VMA virtual blocks over large buffers, one set per BufferDesc usage, storage and access
+  struct SliceBlock {
+    BufferHandle buffer;
+    VmaVirtualBlock block = VK_NULL_HANDLE;
+    uint8_t usage = 0;
+    StorageType storage = StorageType_Device;
+    BufferAccess access = BufferAccess_Default;
+  };
+  struct PendingSliceFree {
+    BufferHandle buffer;
+    VmaVirtualAllocation allocation = VK_NULL_HANDLE;
+    VulkanImmediateCommands::SubmitHandle handle; // the range can be reused when this has retired...
+    VulkanImmediateCommands::SubmitHandle handleCompute; // ...and this one too (VulkanContext::immediateCompute_)
+  };
+  std::mutex slicesMutex_;
+  std::vector<SliceBlock> sliceBlocks_;
+  std::vector<PendingSliceFree> pendingSliceFrees_;
+
+  // deduplicated samplers: SamplerStateDesc (without debugName) => shared sampler
+  struct SamplerCacheEntry {
+    SamplerHandle handle;
+    uint32_t refCount = 0;
+  };
+  std::unordered_map<uint64_t, SamplerCacheEntry> samplerCache_;
+  std::unordered_map<uint32_t, uint64_t> samplerCacheKeys_; // sampler index => cache key
+  SamplerCacheStats samplerCacheStats_;
 };
 
 } // namespace vulkan
@@ -207,7 +207,24 @@ VkBlendFactor blendFactorToVkBlendFactor(lvk::BlendFactor value) {
 
 namespace lvk::vulkan {
 
-RenderPipelineState::RenderPipelineState(lvk::vulkan::Device* device, const RenderPipelineDesc& desc) : device_(device), desc_(desc) {
+void RenderPipelineDynamicState::setDepthStencilState(const lvk::DepthStencilState& desc) {
+  depthWriteEnable_ = desc.isDepthWriteEnabled;
+  setDepthCompareOp(compareOpToVkCompareOp(desc.compareOp));
+
+  auto setStencilState = [this](bool front, const lvk::StencilStateDesc& desc) {
+    setStencilStateOps(front,
+                       stencilOpToVkStencilOp(desc.stencilFailureOp),
+                       stencilOpToVkStencilOp(desc.depthStencilPassOp),
+                       stencilOpToVkStencilOp(desc.depthFailureOp),
+                       compareOpToVkCompareOp(desc.stencilCompareOp));
+  };
+
+  setStencilState(true, desc.frontFaceStencil);
+  setStencilState(false, desc.backFaceStencil);
+}
+
+RenderPipelineState::RenderPipelineState(lvk::vulkan::Device* device, const RenderPipelineDesc& desc) :
+  device_(device), desc_(desc), pipelines_(std::make_unique<Pipelines>()) {
   // Iterate and cache vertex input bindings and attributes
   const lvk::VertexInput& vstate = desc_.vertexInput;
 
@@ -243,14 +260,22 @@ RenderPipelineState::~RenderPipelineState() {
     return;
   }
 
+  const VulkanContext& ctx = device_->getVulkanContext();
+
+  {
+    // the pipelines being compiled use our shader modules and vertex input state
+    std::unique_lock<std::mutex> lock(ctx.pipelinesMutex_);
+    ctx.pipelinesCondition_.wait(lock, [this]() { return pipelines_->pending.empty(); });
+  }
+
   for (lvk::ShaderModuleHandle m : desc_.shaderStages.modules_) {
     device_->destroy(m);
   }
 
-  for (auto p : pipelines_) {
+  for (auto p : pipelines_->pipelines) {
     if (p.second != VK_NULL_HANDLE) {
-      device_->getVulkanContext().deferredTask(std::packaged_task<void()>(
-          [device = device_->getVulkanContext().getVkDevice(), pipeline = p.second]() { vkDestroyPipeline(device, pipeline, nullptr); }));
+      ctx.deferredTask(std::packaged_task<void()>(
+          [device = ctx.getVkDevice(), pipeline = p.second]() { vkDestroyPipeline(device, pipeline, nullptr); }));
     }
   }
 }
@@ -276,19 +301,155 @@ RenderPipelineState& RenderPipelineState::operator=(RenderPipelineState&& other)
   return *this;
 }
 
-VkPipeline RenderPipelineState::getVkPipeline(const RenderPipelineDynamicState& dynamicState) const {
-  const auto it = pipelines_.find(dynamicState);
+void RenderPipelineState::setPipelineLayout(VkPipelineLayout layout) const {
+  if (pipelines_->layout == layout) {
+    return;
+  }
+
+  const VulkanContext& ctx = device_->getVulkanContext();
 
-  if (it != pipelines_.end()) {
-    return it->second;
+  // the bindless pipeline layout has been recreated - all cached pipelines are not compatible anymore
+  for (auto p : pipelines_->pipelines) {
+    if (p.second != VK_NULL_HANDLE) {
+      ctx.deferredTask(std::packaged_task<void()>(
+                           [device = ctx.getVkDevice(), pipeline = p.second]() { vkDestroyPipeline(device, pipeline, nullptr); }),
+                       ctx.immediate_->getNextSubmitHandle());
+    }
   }
+  pipelines_->pipelines.clear();
+  pipelines_->layout = layout;
+}
 
-  // build a new Vulkan pipeline
+void RenderPipelineState::installPipelines(const VulkanContext& ctx,
+                                           Pipelines& pipelines,
+                                           VkPipelineLayout layout,
+                                           const RenderPipelineDynamicState* dynamicStates,
+                                           const VkPipeline* vkPipelines,
+                                           uint32_t numPipelines) {
+  {
+    std::lock_guard<std::mutex> lock(ctx.pipelinesMutex_);
+
+    for (uint32_t i = 0; i != numPipelines; i++) {
+      pipelines.pending.erase(dynamicStates[i]);
+
+      if (pipelines.layout == layout && pipelines.pipelines.emplace(dynamicStates[i], vkPipelines[i]).second) {
+        continue;
+      }
+
+      // the bindless pipeline layout has been recreated while compiling: the pipeline might be in use by the caller
+      if (vkPipelines[i] != VK_NULL_HANDLE) {
+        ctx.deferredTask(std::packaged_task<void()>(
+                             [device = ctx.getVkDevice(), pipeline = vkPipelines[i]]() { vkDestroyPipeline(device, pipeline, nullptr); }),
+                         ctx.immediate_->getNextSubmitHandle());
+      }
+    }
+  }
+
+  ctx.pipelinesCondition_.notify_all();
+}
 
+VkPipeline RenderPipelineState::getVkPipeline(const RenderPipelineDynamicState& dynamicState, VkPipelineLayout layout) const {
   const VulkanContext& ctx = device_->getVulkanContext();
 
+  {
+    // command buffers can be recorded on different threads
+    std::unique_lock<std::mutex> lock(ctx.pipelinesMutex_);
+
+    for (;;) {
+      setPipelineLayout(layout);
+
+      const auto it = pipelines_->pipelines.find(dynamicState);
+
+      if (it != pipelines_->pipelines.end()) {
+        return it->second;
+      }
+
+      if (!pipelines_->pending.count(dynamicState)) {
+        break;
+      }
+
+      // the pipeline is being compiled by prewarm() or by another thread
+      if (ctx.config_.skipDrawsWithPendingPipelines) {
+        return VK_NULL_HANDLE;
+      }
+
+      IGL_PROFILER_ZONE("Waiting for pipeline...", IGL_PROFILER_COLOR_WAIT);
+      ctx.pipelinesCondition_.wait(lock);
+      IGL_PROFILER_ZONE_END();
+    }
+
+    pipelines_->pending.insert(dynamicState);
+  }
+
+  // build a new Vulkan pipeline; the other threads can use the other pipelines meanwhile
+
+  IGL_PROFILER_ZONE("Create pipeline", IGL_PROFILER_COLOR_CREATE);
+
   VkPipeline pipeline = VK_NULL_HANDLE;
 
+  createPipelineBuilder(dynamicState).build(ctx.getVkDevice(), ctx.pipelineCache_, layout, &pipeline, desc_.debugName);
+
+  IGL_PROFILER_ZONE_END();
+
+  installPipelines(ctx, *pipelines_, layout, &dynamicState, &pipeline, 1);
+
+  return pipeline;
+}
+
+void RenderPipelineState::prewarm(const RenderPipelineDynamicState* dynamicStates, uint32_t numDynamicStates) const {
+  VulkanContext& ctx = device_->getVulkanContext();
+
+  // released by the compilation job: the bindless tables can grow and retire the layout meanwhile
+  const VkPipelineLayout layout = ctx.acquirePipelineLayout();
+
+  std::vector<RenderPipelineDynamicState> states;
+  states.reserve(numDynamicStates);
+
+  {
+    std::lock_guard<std::mutex> lock(ctx.pipelinesMutex_);
+
+    setPipelineLayout(layout);
+
+    for (uint32_t i = 0; i != numDynamicStates; i++) {
+      if (!pipelines_->pipelines.count(dynamicStates[i]) && pipelines_->pending.insert(dynamicStates[i]).second) {
+        states.push_back(dynamicStates[i]);
+      }
+    }
+  }
+
+  if (states.empty()) {
+    ctx.releasePipelineLayout(layout);
+    return;
+  }
+
+  // the builders are prepared on this thread: the jobs do not touch the pools which can be modified meanwhile
+  std::vector<VulkanPipelineBuilder> builders;
+  builders.reserve(states.size());
+
+  for (const RenderPipelineDynamicState& s : states) {
+    builders.push_back(createPipelineBuilder(s));
+  }
+
+  ctx.pipelineCompiler_->enqueue([&ctx,
+                                  pipelines = pipelines_.get(),
+                                  layout,
+                                  debugName = desc_.debugName,
+                                  states = std::move(states),
+                                  builders = std::move(builders)]() {
+    std::vector<VkPipeline> vkPipelines(states.size(), VK_NULL_HANDLE);
+
+    VulkanPipelineBuilder::build(
+        ctx.getVkDevice(), ctx.pipelineCache_, layout, builders.data(), (uint32_t)builders.size(), vkPipelines.data(), debugName);
+
+    installPipelines(ctx, *pipelines, layout, states.data(), vkPipelines.data(), (uint32_t)states.size());
+
+    ctx.releasePipelineLayout(layout);
+  });
+}
+
+VulkanPipelineBuilder RenderPipelineState::createPipelineBuilder(const RenderPipelineDynamicState& dynamicState) const {
+  const VulkanContext& ctx = device_->getVulkanContext();
+
   const uint32_t numColorAttachments = desc_.getNumColorAttachments();
 
   // Not all attachments are valid. We need to create color blend attachments only for active
@@ -336,7 +497,9 @@ VkPipeline RenderPipelineState::getVkPipeline(const RenderPipelineDynamicState&
         VK_SHADER_STAGE_GEOMETRY_BIT, geometryModule->getVkShaderModule(), geometryModule->getEntryPoint()));
   }
 
-  lvk::vulkan::VulkanPipelineBuilder()
+  VulkanPipelineBuilder builder;
+
+  builder
       .dynamicStates({
           // from Vulkan 1.0
           VK_DYNAMIC_STATE_VIEWPORT,
@@ -371,11 +534,9 @@ VkPipeline RenderPipelineState::getVkPipeline(const RenderPipelineDynamicState&
       .colorAttachmentFormats(colorAttachmentFormats)
       .depthAttachmentFormat(textureFormatToVkFormat(desc_.depthFormat))
       .stencilAttachmentFormat(textureFormatToVkFormat(desc_.stencilFormat))
-      .build(ctx.getVkDevice(), ctx.pipelineCache_, ctx.vkPipelineLayout_, &pipeline, desc_.debugName);
-
-  pipelines_[dynamicState] = pipeline;
+      .createFlags(ctx.useDescriptorBuffer_ ? VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT : VkPipelineCreateFlags(0));
 
-  return pipeline;
+  return builder;
 }
 
 } // namespace lvk::vulkan
@@ -10,14 +10,18 @@
 #include <lvk/LVK.h>
 #include <igl/vulkan/Common.h>
 
+#include <memory>
 #include <string.h>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace lvk {
 namespace vulkan {
 
 class Device;
+class VulkanContext;
+class VulkanPipelineBuilder;
 
 class alignas(sizeof(uint64_t)) RenderPipelineDynamicState {
   uint32_t topology_ : 4;
@@ -107,6 +111,9 @@ class alignas(sizeof(uint64_t)) RenderPipelineDynamicState {
     }
   }
 
+  // the same state as set by CommandBuffer::cmdBindDepthStencilState()
+  void setDepthStencilState(const lvk::DepthStencilState& desc);
+
   // comparison operator and hash function for std::unordered_map<>
   bool operator==(const RenderPipelineDynamicState& other) const {
     return *(uint64_t*)this == *(uint64_t*)&other;
@@ -134,7 +141,12 @@ class RenderPipelineState final {
   RenderPipelineState(RenderPipelineState&& other);
   RenderPipelineState& operator=(RenderPipelineState&& other);
 
-  VkPipeline getVkPipeline(const RenderPipelineDynamicState& dynamicState) const;
+  // thread-safe; all cached pipelines are recreated if `layout` is different from the one they were created with
+  // returns VK_NULL_HANDLE while prewarm() is compiling the pipeline and VulkanContextConfig::skipDrawsWithPendingPipelines is set
+  VkPipeline getVkPipeline(const RenderPipelineDynamicState& dynamicState, VkPipelineLayout layout) const;
+  // compiles the missing pipelines with one vkCreateGraphicsPipelines() call on a background thread; the job keeps the
+  // latest bindless pipeline layout alive (VulkanContext::acquirePipelineLayout())
+  void prewarm(const RenderPipelineDynamicState* dynamicStates, uint32_t numDynamicStates) const;
 
   const RenderPipelineDesc& getRenderPipelineDesc() const {
     return desc_;
@@ -150,7 +162,27 @@ class RenderPipelineState final {
   std::vector<VkVertexInputBindingDescription> vkBindings_;
   std::vector<VkVertexInputAttributeDescription> vkAttributes_;
 
-  mutable std::unordered_map<RenderPipelineDynamicState, VkPipeline, RenderPipelineDynamicState::HashFunction> pipelines_;
+  struct Pipelines {
+    std::unordered_map<RenderPipelineDynamicState, VkPipeline, RenderPipelineDynamicState::HashFunction> pipelines;
+    // compiled without VulkanContext::pipelinesMutex_ held: by prewarm() jobs or by getVkPipeline() on other threads
+    std::unordered_set<RenderPipelineDynamicState, RenderPipelineDynamicState::HashFunction> pending;
+    // the pipeline layout all `pipelines` were created with
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+  };
+
+  VulkanPipelineBuilder createPipelineBuilder(const RenderPipelineDynamicState& dynamicState) const;
+  // VulkanContext::pipelinesMutex_ should be locked
+  void setPipelineLayout(VkPipelineLayout layout) const;
+  // takes VulkanContext::pipelinesMutex_; the pipelines created with an outdated layout are destroyed
+  static void installPipelines(const VulkanContext& ctx,
+                               Pipelines& pipelines,
+                               VkPipelineLayout layout,
+                               const RenderPipelineDynamicState* dynamicStates,
+                               const VkPipeline* vkPipelines,
+                               uint32_t numPipelines);
+
+  // does not move with the pipeline state: the background compilation jobs install their pipelines here
+  std::unique_ptr<Pipelines> pipelines_;
 };
 
 } // namespace vulkan
@@ -11,9 +11,42 @@
 #include "VulkanBuffer.h"
 
 #include <string.h>
+#include <algorithm>
+
+namespace {
+
+constexpr VkAccessFlags2 kWriteAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT |
+                                            VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_HOST_WRITE_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+} // namespace
 
 namespace lvk::vulkan {
 
+namespace {
+
+// non-coherent ranges have to be aligned to nonCoherentAtomSize; the mapping covers the whole allocation (see the
+// constructor), so a range which would extend past the buffer is flushed to the end of the allocation
+VkMappedMemoryRange getAlignedMappedMemoryRange(const VulkanContext& ctx,
+                                                VkDeviceMemory memory,
+                                                VkDeviceSize bufferSize,
+                                                VkDeviceSize offset,
+                                                VkDeviceSize size) {
+  const VkDeviceSize atomSize = std::max(ctx.getVkPhysicalDeviceProperties().limits.nonCoherentAtomSize, VkDeviceSize(1));
+
+  const VkDeviceSize begin = (offset / atomSize) * atomSize;
+  const VkDeviceSize end = size == VK_WHOLE_SIZE ? bufferSize : ((offset + size + atomSize - 1) / atomSize) * atomSize;
+
+  return VkMappedMemoryRange{
+      VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
+      nullptr,
+      memory,
+      begin,
+      end >= bufferSize ? VK_WHOLE_SIZE : end - begin,
+  };
+}
+
+} // namespace
+
 VulkanBuffer::VulkanBuffer(VulkanContext* ctx,
                            VkDevice device,
                            VkDeviceSize bufferSize,
@@ -27,26 +60,52 @@ VulkanBuffer::VulkanBuffer(VulkanContext* ctx,
   IGL_ASSERT(bufferSize > 0);
 
   // Initialize Buffer Info
-  const VkBufferCreateInfo ci = ivkGetBufferCreateInfo(bufferSize, usageFlags);
+  VkBufferCreateInfo ci = ivkGetBufferCreateInfo(bufferSize, usageFlags);
+
+  // buffers can be written by the dedicated transfer queue and accessed by async compute without ownership transfers
+  const std::vector<uint32_t>& queueFamilyIndices = ctx_->concurrentQueueFamilyIndices_;
+  if (queueFamilyIndices.size() > 1) {
+    ci.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    ci.queueFamilyIndexCount = (uint32_t)queueFamilyIndices.size();
+    ci.pQueueFamilyIndices = queueFamilyIndices.data();
+  }
 
   if (IGL_VULKAN_USE_VMA) {
     // Initialize VmaAllocation Info
+    vmaAllocInfo_.usage = VMA_MEMORY_USAGE_AUTO;
+
     if (memFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
       vmaAllocInfo_.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
-      vmaAllocInfo_.preferredFlags = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
-      vmaAllocInfo_.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT;
+      vmaAllocInfo_.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+      if (memFlags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT) {
+        // read by the CPU
+        vmaAllocInfo_.preferredFlags = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+        vmaAllocInfo_.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT;
+      } else {
+        // only written sequentially by the CPU: write-combined memory is fine
+        vmaAllocInfo_.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+      }
     }
     if (memFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) {
       vmaAllocInfo_.requiredFlags |= VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
     }
-
-    vmaAllocInfo_.usage = VMA_MEMORY_USAGE_AUTO;
+    if (isReBar()) {
+      // write-combined video memory: never read it on the CPU
+      vmaAllocInfo_.requiredFlags |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+      vmaAllocInfo_.preferredFlags = 0;
+      vmaAllocInfo_.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT | VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+      vmaAllocInfo_.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+    }
 
     vmaCreateBuffer((VmaAllocator)ctx_->getVmaAllocator(), &ci, &vmaAllocInfo_, &vkBuffer_, &vmaAllocation_, nullptr);
 
     // handle memory-mapped buffers
     if (memFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
       vmaMapMemory((VmaAllocator)ctx_->getVmaAllocator(), vmaAllocation_, &mappedPtr_);
+
+      VkMemoryPropertyFlags props = 0;
+      vmaGetAllocationMemoryProperties((VmaAllocator)ctx_->getVmaAllocator(), vmaAllocation_, &props);
+      isCoherentMemory_ = (props & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
     }
   } else {
     // create buffer
@@ -57,13 +116,21 @@ VulkanBuffer::VulkanBuffer(VulkanContext* ctx,
       VkMemoryRequirements requirements = {};
       vkGetBufferMemoryRequirements(device_, vkBuffer_, &requirements);
 
-      VK_ASSERT(ivkAllocateMemory(ctx_->getVkPhysicalDevice(), device_, &requirements, memFlags, &vkMemory_));
+      // HOST_CACHED is only a preference
+      const VkMemoryPropertyFlags requiredFlags = memFlags & ~VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+      VK_ASSERT(ivkAllocateMemory(ctx_->getVkPhysicalDevice(), device_, &requirements, requiredFlags, &vkMemory_));
       VK_ASSERT(vkBindBufferMemory(device_, vkBuffer_, vkMemory_, 0));
+
+      // the memory type which was actually chosen can be coherent even if it was not requested
+      VkPhysicalDeviceMemoryProperties memProperties = {};
+      vkGetPhysicalDeviceMemoryProperties(ctx_->getVkPhysicalDevice(), &memProperties);
+      const uint32_t memoryTypeIndex = ivkFindMemoryType(ctx_->getVkPhysicalDevice(), requirements.memoryTypeBits, requiredFlags);
+      isCoherentMemory_ = (memProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
     }
 
-    // handle memory-mapped buffers
+    // handle memory-mapped buffers; the whole allocation is mapped so that aligned flushes can reach its end
     if (memFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
-      VK_ASSERT(vkMapMemory(device_, vkMemory_, 0, bufferSize_, 0, &mappedPtr_));
+      VK_ASSERT(vkMapMemory(device_, vkMemory_, 0, VK_WHOLE_SIZE, 0, &mappedPtr_));
     }
   }
 
@@ -87,6 +154,10 @@ VulkanBuffer::~VulkanBuffer() {
     return;
   }
 
+  if (isReBar()) {
+    ctx_->releaseReBarMemory(bufferSize_);
+  }
+
   if (IGL_VULKAN_USE_VMA) {
     if (mappedPtr_) {
       vmaUnmapMemory((VmaAllocator)ctx_->getVmaAllocator(), vmaAllocation_);
@@ -116,7 +187,12 @@ VulkanBuffer::VulkanBuffer(VulkanBuffer&& other) :
   bufferSize_(other.bufferSize_),
   usageFlags_(other.usageFlags_),
   memFlags_(other.memFlags_),
-  mappedPtr_(other.mappedPtr_) {
+  mappedPtr_(other.mappedPtr_),
+  isCoherentMemory_(other.isCoherentMemory_),
+  stageMask_(other.stageMask_),
+  accessMask_(other.accessMask_),
+  lastRecorderQueue_(other.lastRecorderQueue_),
+  lastRecorder_(other.lastRecorder_) {
   other.ctx_ = nullptr;
 }
 
@@ -132,6 +208,11 @@ VulkanBuffer& VulkanBuffer::operator=(VulkanBuffer&& other) {
   std::swap(usageFlags_, other.usageFlags_);
   std::swap(memFlags_, other.memFlags_);
   std::swap(mappedPtr_, other.mappedPtr_);
+  std::swap(isCoherentMemory_, other.isCoherentMemory_);
+  std::swap(stageMask_, other.stageMask_);
+  std::swap(accessMask_, other.accessMask_);
+  std::swap(lastRecorderQueue_, other.lastRecorderQueue_);
+  std::swap(lastRecorder_, other.lastRecorder_);
   return *this;
 }
 
@@ -143,17 +224,24 @@ void VulkanBuffer::flushMappedMemory(VkDeviceSize offset, VkDeviceSize size) con
   if (IGL_VULKAN_USE_VMA) {
     vmaFlushAllocation((VmaAllocator)ctx_->getVmaAllocator(), vmaAllocation_, offset, size);
   } else {
-    const VkMappedMemoryRange memoryRange = {
-        VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE,
-        nullptr,
-        vkMemory_,
-        offset,
-        size,
-    };
+    const VkMappedMemoryRange memoryRange = getAlignedMappedMemoryRange(*ctx_, vkMemory_, bufferSize_, offset, size);
     vkFlushMappedMemoryRanges(device_, 1, &memoryRange);
   }
 }
 
+void VulkanBuffer::invalidateMappedMemory(VkDeviceSize offset, VkDeviceSize size) const {
+  if (!IGL_VERIFY(isMapped())) {
+    return;
+  }
+
+  if (IGL_VULKAN_USE_VMA) {
+    vmaInvalidateAllocation((VmaAllocator)ctx_->getVmaAllocator(), vmaAllocation_, offset, size);
+  } else {
+    const VkMappedMemoryRange memoryRange = getAlignedMappedMemoryRange(*ctx_, vkMemory_, bufferSize_, offset, size);
+    vkInvalidateMappedMemoryRanges(device_, 1, &memoryRange);
+  }
+}
+
 void VulkanBuffer::getBufferSubData(size_t offset, size_t size, void* data) {
   // Only mapped host-visible buffers can be downloaded this way. All other
   // GPU buffers should use a temporary staging buffer
@@ -166,6 +254,10 @@ void VulkanBuffer::getBufferSubData(size_t offset, size_t size, void* data) {
 
   IGL_ASSERT(offset + size <= bufferSize_);
 
+  if (!isCoherentMemory_) {
+    invalidateMappedMemory(offset, size);
+  }
+
   const uint8_t* src = static_cast<uint8_t*>(mappedPtr_) + offset;
   memcpy(data, src, size);
 }
@@ -186,6 +278,54 @@ void VulkanBuffer::bufferSubData(size_t offset, size_t size, const void* data) {
   } else {
     memset((uint8_t*)mappedPtr_ + offset, 0, size);
   }
+
+  if (!isCoherentMemory_) {
+    flushMappedMemory(offset, size);
+  }
+}
+
+void VulkanBuffer::transitionAccess(std::vector<VkBufferMemoryBarrier2>& barriers,
+                                    VkPipelineStageFlags2 dstStageMask,
+                                    VkAccessFlags2 dstAccessMask) const {
+  std::lock_guard<std::recursive_mutex> lock(ctx_->resourceStatesMutex_);
+
+  const bool isReadOnly = (dstAccessMask & kWriteAccessMask) == 0;
+  const bool wasReadOnly = (accessMask_ & kWriteAccessMask) == 0;
+
+  if (isReadOnly && wasReadOnly) {
+    const bool isCoveredStage = (stageMask_ & VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT) || (stageMask_ & dstStageMask) == dstStageMask;
+    const bool isCoveredAccess = (accessMask_ & VK_ACCESS_2_MEMORY_READ_BIT) || (accessMask_ & dstAccessMask) == dstAccessMask;
+    // nothing recorded yet or already visible to these reads
+    if (stageMask_ == VK_PIPELINE_STAGE_2_NONE || (isCoveredStage && isCoveredAccess)) {
+      stageMask_ |= dstStageMask;
+      accessMask_ |= dstAccessMask;
+      return;
+    }
+  }
+
+  // a write waits for all previous accesses; a new read chains with the barrier which made the last write visible
+  if (stageMask_ != VK_PIPELINE_STAGE_2_NONE) {
+    barriers.push_back(VkBufferMemoryBarrier2{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+        .srcStageMask = stageMask_,
+        .srcAccessMask = accessMask_ & kWriteAccessMask,
+        .dstStageMask = dstStageMask,
+        .dstAccessMask = dstAccessMask,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = vkBuffer_,
+        .offset = 0,
+        .size = VK_WHOLE_SIZE,
+    });
+  }
+
+  if (isReadOnly && wasReadOnly) {
+    stageMask_ |= dstStageMask;
+    accessMask_ |= dstAccessMask;
+  } else {
+    stageMask_ = dstStageMask;
+    accessMask_ = dstAccessMask;
+  }
 }
 
 } // namespace lvk::vulkan
@@ -8,9 +8,11 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include <igl/vulkan/Common.h>
 #include <igl/vulkan/VulkanHelpers.h>
+#include <igl/vulkan/VulkanImmediateCommands.h>
 #include <lvk/vulkan/VulkanUtils.h>
 
 namespace lvk {
@@ -21,6 +23,8 @@ class VulkanContext;
 class VulkanBuffer final {
  public:
   VulkanBuffer() = default;
+  // host-visible memory with HOST_CACHED is read randomly by the CPU (HOST_CACHED is only preferred); without it,
+  // the CPU writes sequentially and write-combined memory is used
   VulkanBuffer(VulkanContext* ctx,
                VkDevice device,
                VkDeviceSize bufferSize,
@@ -43,7 +47,17 @@ class VulkanBuffer final {
   bool isMapped() const {
     return mappedPtr_ != nullptr;
   }
+  // device-local memory mapped via Resizable BAR (accounted in VulkanContext::reBarUsage_)
+  bool isReBar() const {
+    return (memFlags_ & (VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)) ==
+           (VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+  }
+  // bufferSubData() and getBufferSubData() flush and invalidate non-coherent memory automatically
+  bool isCoherentMemory() const {
+    return isCoherentMemory_;
+  }
   void flushMappedMemory(VkDeviceSize offset, VkDeviceSize size) const;
+  void invalidateMappedMemory(VkDeviceSize offset, VkDeviceSize size) const;
   VkBuffer getVkBuffer() const {
     return vkBuffer_;
   }
@@ -56,8 +70,15 @@ class VulkanBuffer final {
   VkBufferUsageFlags getUsageFlags() const {
     return usageFlags_;
   }
+  // appends a barrier which makes the accesses recorded so far visible to the next access (none if both are reads
+  // already made visible); uploads and readbacks synchronize with full memory barriers and are not tracked
+  void transitionAccess(std::vector<VkBufferMemoryBarrier2>& barriers,
+                        VkPipelineStageFlags2 dstStageMask,
+                        VkAccessFlags2 dstAccessMask) const;
 
  private:
+  friend class CommandBuffer;
+
   VulkanContext* ctx_ = nullptr;
   VkDevice device_ = VK_NULL_HANDLE;
   VkBuffer vkBuffer_ = VK_NULL_HANDLE;
@@ -69,6 +90,13 @@ class VulkanBuffer final {
   VkBufferUsageFlags usageFlags_ = 0;
   VkMemoryPropertyFlags memFlags_ = 0;
   void* mappedPtr_ = nullptr;
+  bool isCoherentMemory_ = true;
+  // the accesses recorded into command buffers since the last write
+  mutable VkPipelineStageFlags2 stageMask_ = VK_PIPELINE_STAGE_2_NONE;
+  mutable VkAccessFlags2 accessMask_ = VK_ACCESS_2_NONE;
+  // the last command buffer which recorded an access; Device::submit() checks the submission order against it
+  mutable const VulkanImmediateCommands* lastRecorderQueue_ = nullptr;
+  mutable VulkanImmediateCommands::SubmitHandle lastRecorder_ = {};
 };
 
 } // namespace vulkan
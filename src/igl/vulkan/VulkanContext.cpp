@@ -5,7 +5,9 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
 #include <cstring>
+#include <numeric>
 #include <set>
 #include <vector>
 
@@ -39,6 +41,8 @@ enum Bindings {
   kBinding_NumBindins = 3,
 };
 
+const uint32_t kPushConstantsSize = 128;
+
 VKAPI_ATTR VkBool32 VKAPI_CALL
 vulkanDebugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT msgSeverity,
                     [[maybe_unused]] VkDebugUtilsMessageTypeFlagsEXT msgType,
@@ -191,6 +195,10 @@ VulkanContext::VulkanContext(const VulkanContextConfig& config,
 
   glslang_initialize_process();
 
+  // bindless descriptor sets are updated incrementally using only the created/destroyed slots
+  texturesPool_.trackDirtySlots_ = true;
+  samplersPool_.trackDirtySlots_ = true;
+
   createInstance();
 
   if (window) {
@@ -203,9 +211,17 @@ VulkanContext::~VulkanContext() {
 
   VK_ASSERT(vkDeviceWaitIdle(vkDevice_));
 
+  // finish the background compilation jobs while their render pipelines are alive
+  pipelineCompiler_.reset(nullptr);
   stagingDevice_.reset(nullptr);
+  transientArena_.reset(nullptr);
   swapchain_.reset(nullptr); // swapchain has to be destroyed prior to Surface
 
+  if (descriptorBuffer_.valid()) {
+    buffersPool_.destroy(descriptorBuffer_);
+    descriptorBuffer_ = {};
+  }
+
   if (shaderModulesPool_.numObjects()) {
     LLOGW("Leaked %u shader modules\n", shaderModulesPool_.numObjects());
   }
@@ -237,6 +253,7 @@ VulkanContext::~VulkanContext() {
 
   waitDeferredTasks();
 
+  immediateCompute_.reset(nullptr);
   immediate_.reset(nullptr);
 
   vkDestroyDescriptorSetLayout(vkDevice_, vkDSLBindless_, nullptr);
@@ -432,6 +449,11 @@ lvk::Result VulkanContext::initContext(const HWDeviceDesc& desc) {
 
   useStaging_ = !ivkIsHostVisibleSingleHeapMemory(vkPhysicalDevice_);
 
+  // the BAR heap can be as small as 256 MB and is shared with the driver: use only a part of it
+  reBarBudget_ = useStaging_ ? VkDeviceSize(config_.reBarBudgetFraction * ivkGetHostVisibleDeviceLocalHeapSize(vkPhysicalDevice_)) : 0;
+
+  hasLazilyAllocatedMemory_ = ivkHasMemoryType(vkPhysicalDevice_, VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+
   vkGetPhysicalDeviceFeatures2(vkPhysicalDevice_, &vkFeatures10_);
   vkGetPhysicalDeviceProperties2(vkPhysicalDevice_, &vkPhysicalDeviceProperties2_);
 
@@ -477,25 +499,39 @@ lvk::Result VulkanContext::initContext(const HWDeviceDesc& desc) {
     return Result(Result::Code::RuntimeError, "VK_QUEUE_COMPUTE_BIT is not supported");
   }
 
+  // use a dedicated transfer-only queue family for staging (if any); otherwise uploads go through the graphics queue
+  deviceQueues_.transferQueueFamilyIndex = lvk::findQueueFamilyIndex(vkPhysicalDevice_, VK_QUEUE_TRANSFER_BIT);
+
+  if (deviceQueues_.transferQueueFamilyIndex == deviceQueues_.graphicsQueueFamilyIndex ||
+      deviceQueues_.transferQueueFamilyIndex == deviceQueues_.computeQueueFamilyIndex) {
+    deviceQueues_.transferQueueFamilyIndex = DeviceQueues::INVALID;
+  }
+
   const float queuePriority = 1.0f;
 
-  const VkDeviceQueueCreateInfo ciQueue[2] = {
+  VkDeviceQueueCreateInfo ciQueue[3] = {
       {
           .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
           .queueFamilyIndex = deviceQueues_.graphicsQueueFamilyIndex,
           .queueCount = 1,
           .pQueuePriorities = &queuePriority,
       },
-      {
-          .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-          .queueFamilyIndex = deviceQueues_.computeQueueFamilyIndex,
-          .queueCount = 1,
-          .pQueuePriorities = &queuePriority,
-      },
   };
-  const uint32_t numQueues = ciQueue[0].queueFamilyIndex == ciQueue[1].queueFamilyIndex ? 1 : 2;
+  uint32_t numQueues = 1;
 
-  const char* deviceExtensionNames[] = {
+  for (uint32_t queueFamilyIndex : {deviceQueues_.computeQueueFamilyIndex, deviceQueues_.transferQueueFamilyIndex}) {
+    if (queueFamilyIndex == DeviceQueues::INVALID || queueFamilyIndex == deviceQueues_.graphicsQueueFamilyIndex) {
+      continue;
+    }
+    ciQueue[numQueues++] = {
+        .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+        .queueFamilyIndex = queueFamilyIndex,
+        .queueCount = 1,
+        .pQueuePriorities = &queuePriority,
+    };
+  }
+
+  std::vector<const char*> deviceExtensionNames = {
     VK_KHR_SWAPCHAIN_EXTENSION_NAME,
     VK_KHR_SHADER_NON_SEMANTIC_INFO_EXTENSION_NAME,
 #if defined(LVK_WITH_TRACY)
@@ -539,15 +575,95 @@ lvk::Result VulkanContext::initContext(const HWDeviceDesc& desc) {
       .dynamicRendering = VK_TRUE,
       .maintenance4 = VK_TRUE,
   };
+
+  // optional: VK_EXT_descriptor_buffer
+  VkPhysicalDeviceDescriptorBufferFeaturesEXT descriptorBufferFeatures = {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT,
+  };
+  useDescriptorBuffer_ = false;
+  if (config_.enableDescriptorBuffer) {
+    if (hasExtension(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME, allPhysicalDeviceExtensions)) {
+      VkPhysicalDeviceFeatures2 features = {
+          .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+          .pNext = &descriptorBufferFeatures,
+      };
+      vkGetPhysicalDeviceFeatures2(vkPhysicalDevice_, &features);
+      useDescriptorBuffer_ = descriptorBufferFeatures.descriptorBuffer == VK_TRUE;
+    }
+    if (useDescriptorBuffer_) {
+      deviceExtensionNames.push_back(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME);
+      descriptorBufferFeatures = {
+          .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT,
+          .pNext = &deviceFeatures13,
+          .descriptorBuffer = VK_TRUE,
+      };
+      VkPhysicalDeviceProperties2 props = {
+          .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+          .pNext = &vkDescriptorBufferProperties_,
+      };
+      vkGetPhysicalDeviceProperties2(vkPhysicalDevice_, &props);
+    } else {
+      LLOGW("VK_EXT_descriptor_buffer is not supported. Falling back to descriptor sets.\n");
+    }
+  }
+
+  void* deviceFeatures = useDescriptorBuffer_ ? static_cast<void*>(&descriptorBufferFeatures) : &deviceFeatures13;
+
+  // optional: VK_EXT_host_image_copy
+  VkPhysicalDeviceHostImageCopyFeaturesEXT hostImageCopyFeatures = {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES_EXT,
+  };
+  useHostImageCopy_ = false;
+  if (config_.enableHostImageCopy) {
+    if (hasExtension(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME, allPhysicalDeviceExtensions)) {
+      VkPhysicalDeviceFeatures2 features = {
+          .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+          .pNext = &hostImageCopyFeatures,
+      };
+      vkGetPhysicalDeviceFeatures2(vkPhysicalDevice_, &features);
+      useHostImageCopy_ = hostImageCopyFeatures.hostImageCopy == VK_TRUE;
+    }
+    if (useHostImageCopy_) {
+      deviceExtensionNames.push_back(VK_EXT_HOST_IMAGE_COPY_EXTENSION_NAME);
+      hostImageCopyFeatures = {
+          .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_FEATURES_EXT,
+          .pNext = deviceFeatures,
+          .hostImageCopy = VK_TRUE,
+      };
+      deviceFeatures = &hostImageCopyFeatures;
+      // copy straight into VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL if the implementation allows it
+      VkPhysicalDeviceHostImageCopyPropertiesEXT hostImageCopyProps = {
+          .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_HOST_IMAGE_COPY_PROPERTIES_EXT,
+      };
+      VkPhysicalDeviceProperties2 props = {
+          .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+          .pNext = &hostImageCopyProps,
+      };
+      vkGetPhysicalDeviceProperties2(vkPhysicalDevice_, &props);
+      std::vector<VkImageLayout> copyDstLayouts(hostImageCopyProps.copyDstLayoutCount);
+      hostImageCopyProps.pCopyDstLayouts = copyDstLayouts.data();
+      hostImageCopyProps.copySrcLayoutCount = 0;
+      vkGetPhysicalDeviceProperties2(vkPhysicalDevice_, &props);
+      hostImageCopyDstLayout_ = VK_IMAGE_LAYOUT_GENERAL;
+      for (VkImageLayout layout : copyDstLayouts) {
+        if (layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+          hostImageCopyDstLayout_ = layout;
+        }
+      }
+    } else {
+      LLOGL("VK_EXT_host_image_copy is not supported. Textures are uploaded via the staging buffer.\n");
+    }
+  }
+
   const VkDeviceCreateInfo ci = {
       .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-      .pNext = &deviceFeatures13,
+      .pNext = deviceFeatures,
       .queueCreateInfoCount = numQueues,
       .pQueueCreateInfos = ciQueue,
       .enabledLayerCount = (uint32_t)LVK_ARRAY_NUM_ELEMENTS(kDefaultValidationLayers),
       .ppEnabledLayerNames = kDefaultValidationLayers,
-      .enabledExtensionCount = (uint32_t)LVK_ARRAY_NUM_ELEMENTS(deviceExtensionNames),
-      .ppEnabledExtensionNames = deviceExtensionNames,
+      .enabledExtensionCount = (uint32_t)deviceExtensionNames.size(),
+      .ppEnabledExtensionNames = deviceExtensionNames.data(),
       .pEnabledFeatures = &deviceFeatures10,
   };
 
@@ -734,6 +850,9 @@ lvk::Result VulkanContext::initContext(const HWDeviceDesc& desc) {
       vkDevice_, deviceQueues_.graphicsQueueFamilyIndex, 0, &deviceQueues_.graphicsQueue);
   vkGetDeviceQueue(
       vkDevice_, deviceQueues_.computeQueueFamilyIndex, 0, &deviceQueues_.computeQueue);
+  if (deviceQueues_.transferQueueFamilyIndex != DeviceQueues::INVALID) {
+    vkGetDeviceQueue(vkDevice_, deviceQueues_.transferQueueFamilyIndex, 0, &deviceQueues_.transferQueue);
+  }
 
   VK_ASSERT(ivkSetDebugObjectName(
       vkDevice_, VK_OBJECT_TYPE_DEVICE, (uint64_t)vkDevice_, "Device: VulkanContext::vkDevice_"));
@@ -741,6 +860,17 @@ lvk::Result VulkanContext::initContext(const HWDeviceDesc& desc) {
   immediate_ = std::make_unique<lvk::vulkan::VulkanImmediateCommands>(
       vkDevice_, deviceQueues_.graphicsQueueFamilyIndex, "VulkanContext::immediate_");
 
+  concurrentQueueFamilyIndices_ = {deviceQueues_.graphicsQueueFamilyIndex};
+
+  if (deviceQueues_.computeQueueFamilyIndex != deviceQueues_.graphicsQueueFamilyIndex) {
+    immediateCompute_ = std::make_unique<lvk::vulkan::VulkanImmediateCommands>(
+        vkDevice_, deviceQueues_.computeQueueFamilyIndex, "VulkanContext::immediateCompute_");
+    concurrentQueueFamilyIndices_.push_back(deviceQueues_.computeQueueFamilyIndex);
+  }
+  if (deviceQueues_.transferQueueFamilyIndex != DeviceQueues::INVALID) {
+    concurrentQueueFamilyIndices_.push_back(deviceQueues_.transferQueueFamilyIndex);
+  }
+
   // create Vulkan pipeline cache
   {
     const VkPipelineCacheCreateInfo ci = {
@@ -759,6 +889,7 @@ lvk::Result VulkanContext::initContext(const HWDeviceDesc& desc) {
   }
 
   stagingDevice_ = std::make_unique<lvk::vulkan::VulkanStagingDevice>(*this);
+  pipelineCompiler_ = std::make_unique<lvk::vulkan::VulkanPipelineCompiler>(config_.numPipelineCompilerThreads);
 
   // default texture
   {
@@ -819,88 +950,35 @@ lvk::Result VulkanContext::initContext(const HWDeviceDesc& desc) {
                 nullptr,
                 "Sampler: default");
 
-  if (!IGL_VERIFY(config_.maxSamplers <=
-                  vkPhysicalDeviceVulkan12Properties_.maxDescriptorSetUpdateAfterBindSamplers)) {
-    LLOGW("Max Samplers exceeded %u (max %u)",
-          config_.maxSamplers,
-          vkPhysicalDeviceVulkan12Properties_.maxDescriptorSetUpdateAfterBindSamplers);
+  uint32_t limitTextures = 0;
+  uint32_t limitSamplers = 0;
+  getBindlessLimits(limitTextures, limitSamplers);
+
+  if (!IGL_VERIFY(config_.maxSamplers <= limitSamplers)) {
+    LLOGW("Max Samplers exceeded %u (max %u)", config_.maxSamplers, limitSamplers);
   }
 
-  if (!IGL_VERIFY(
-          config_.maxTextures <=
-          vkPhysicalDeviceVulkan12Properties_.maxDescriptorSetUpdateAfterBindSampledImages)) {
-    LLOGW("Max Textures exceeded: %u (max %u)",
-          config_.maxTextures,
-          vkPhysicalDeviceVulkan12Properties_.maxDescriptorSetUpdateAfterBindSampledImages);
+  if (!IGL_VERIFY(config_.maxTextures <= limitTextures)) {
+    LLOGW("Max Textures exceeded: %u (max %u)", config_.maxTextures, limitTextures);
   }
 
   const VkPhysicalDeviceLimits& limits = getVkPhysicalDeviceProperties().limits;
 
-  {
-    // create default descriptor set layout which is going to be shared by graphics pipelines
-    constexpr uint32_t numBindings = 3;
-    const VkDescriptorSetLayoutBinding bindings[numBindings] = {
-        ivkGetDescriptorSetLayoutBinding(
-            kBinding_Textures, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, config_.maxTextures),
-        ivkGetDescriptorSetLayoutBinding(
-            kBinding_Samplers, VK_DESCRIPTOR_TYPE_SAMPLER, config_.maxSamplers),
-        ivkGetDescriptorSetLayoutBinding(
-            kBinding_StorageImages, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, config_.maxTextures),
-    };
-    const uint32_t flags = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
-                           VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
-                           VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
-    const VkDescriptorBindingFlags bindingFlags[numBindings] = {flags, flags, flags};
-    VK_ASSERT(ivkCreateDescriptorSetLayout(
-        vkDevice_, numBindings, bindings, bindingFlags, &vkDSLBindless_));
-    VK_ASSERT(ivkSetDebugObjectName(vkDevice_,
-                                    VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT,
-                                    (uint64_t)vkDSLBindless_,
-                                    "Descriptor Set Layout: VulkanContext::dslBindless_"));
-
-    // create default descriptor pool and allocate 1 descriptor set
-    const uint32_t numSets = 1;
-    IGL_ASSERT(numSets > 0);
-    const VkDescriptorPoolSize poolSizes[numBindings]{
-        VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, numSets * config_.maxTextures},
-        VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_SAMPLER, numSets * config_.maxSamplers},
-        VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, numSets * config_.maxTextures},
-    };
-    bindlessDSets_.resize(numSets);
-    VK_ASSERT_RETURN(
-        ivkCreateDescriptorPool(vkDevice_, numSets, numBindings, poolSizes, &vkDPBindless_));
-    for (size_t i = 0; i != numSets; i++) {
-      VK_ASSERT_RETURN(ivkAllocateDescriptorSet(
-          vkDevice_, vkDPBindless_, vkDSLBindless_, &bindlessDSets_[i].ds));
-    }
-  }
-
   // maxPushConstantsSize is guaranteed to be at least 128 bytes
   // https://www.khronos.org/registry/vulkan/specs/1.3/html/vkspec.html#features-limits
   // Table 32. Required Limits
-  const uint32_t kPushConstantsSize = 128;
   if (!IGL_VERIFY(kPushConstantsSize <= limits.maxPushConstantsSize)) {
     LLOGW("Push constants size exceeded %u (max %u bytes)",
           kPushConstantsSize,
           limits.maxPushConstantsSize);
   }
 
-  // create pipeline layout
+  // create default descriptor set layout, descriptor sets and pipeline layout
   {
-    const VkPushConstantRange range = {
-        .stageFlags =
-            VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT,
-        .offset = 0,
-        .size = kPushConstantsSize,
-    };
-    const VkPipelineLayoutCreateInfo ci =
-        ivkGetPipelineLayoutCreateInfo(1, &vkDSLBindless_, &range);
-
-    VK_ASSERT(vkCreatePipelineLayout(vkDevice_, &ci, nullptr, &vkPipelineLayout_));
-    VK_ASSERT(ivkSetDebugObjectName(vkDevice_,
-                                    VK_OBJECT_TYPE_PIPELINE_LAYOUT,
-                                    (uint64_t)vkPipelineLayout_,
-                                    "Pipeline Layout: VulkanContext::pipelineLayout_"));
+    const Result result = growBindlessDescriptorSets(config_.maxTextures, config_.maxSamplers);
+    if (!result.isOk()) {
+      return result;
+    }
   }
 
   querySurfaceCapabilities();
@@ -934,6 +1012,11 @@ Result VulkanContext::present() const {
     return Result(Result::Code::ArgumentOutOfRange, "No swapchain available");
   }
 
+  {
+    std::lock_guard<std::mutex> lock(bindlessMutex_);
+    numDescriptorsWrittenLastFrame_ = std::exchange(numDescriptorsWrittenThisFrame_, 0);
+  }
+
   return swapchain_->present(immediate_->acquireLastSubmitSemaphore());
 }
 
@@ -994,37 +1077,280 @@ std::shared_ptr<VulkanImage> VulkanContext::createImage(VkImageType imageType,
                                        debugName);
 }
 
-void VulkanContext::bindDefaultDescriptorSets(VkCommandBuffer cmdBuf,
-                                              VkPipelineBindPoint bindPoint) const {
+lvk::Result VulkanContext::growBindlessDescriptorSets(uint32_t newMaxTextures, uint32_t newMaxSamplers) {
+  IGL_PROFILER_FUNCTION_COLOR(IGL_PROFILER_COLOR_CREATE);
+
+  IGL_ASSERT(newMaxTextures >= currentMaxTextures_);
+  IGL_ASSERT(newMaxSamplers >= currentMaxSamplers_);
+
+  const uint32_t numSets = config_.numBindlessDescriptorSets;
+  if (!IGL_VERIFY(numSets > 0)) {
+    return Result(Result::Code::ArgumentOutOfRange, "At least 1 bindless descriptor set is required");
+  }
+
+  // the old descriptor set layout, pool, and pipeline layout can still be used by the command buffer being recorded now
+  if (vkDSLBindless_ != VK_NULL_HANDLE) {
+    deferredTask(std::packaged_task<void()>(
+                     [this, device = vkDevice_, dsl = vkDSLBindless_, dp = vkDPBindless_, layout = vkPipelineLayout_]() {
+                       vkDestroyDescriptorSetLayout(device, dsl, nullptr);
+                       if (dp != VK_NULL_HANDLE) {
+                         vkDestroyDescriptorPool(device, dp, nullptr);
+                       }
+                       // background pipeline compilation might still be using the layout
+                       destroyPipelineLayout(layout);
+                     }),
+                 immediate_->getNextSubmitHandle());
+    vkDSLBindless_ = VK_NULL_HANDLE;
+    vkDPBindless_ = VK_NULL_HANDLE;
+    vkPipelineLayout_ = VK_NULL_HANDLE;
+  }
+  if (descriptorBuffer_.valid()) {
+    deferredTask(std::packaged_task<void()>([this, buffer = descriptorBuffer_]() { buffersPool_.destroy(buffer); }),
+                 immediate_->getNextSubmitHandle());
+    descriptorBuffer_ = {};
+  }
+
+  currentMaxTextures_ = newMaxTextures;
+  currentMaxSamplers_ = newMaxSamplers;
+
+  // create default descriptor set layout which is going to be shared by graphics pipelines
+  constexpr uint32_t numBindings = kBinding_NumBindins;
+  const VkDescriptorSetLayoutBinding bindings[numBindings] = {
+      ivkGetDescriptorSetLayoutBinding(kBinding_Textures, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, newMaxTextures),
+      ivkGetDescriptorSetLayoutBinding(kBinding_Samplers, VK_DESCRIPTOR_TYPE_SAMPLER, newMaxSamplers),
+      ivkGetDescriptorSetLayoutBinding(kBinding_StorageImages, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, newMaxTextures),
+  };
+  // descriptor buffers can be updated at any time; they do not need (and do not allow) the update-after-bind flags
+  const uint32_t flags = useDescriptorBuffer_ ? VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT
+                                              : VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                                                    VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
+                                                    VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+  const VkDescriptorBindingFlags bindingFlags[numBindings] = {flags, flags, flags};
+  VK_ASSERT_RETURN(ivkCreateDescriptorSetLayout(vkDevice_,
+                                                useDescriptorBuffer_ ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT
+                                                                     : VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+                                                numBindings,
+                                                bindings,
+                                                bindingFlags,
+                                                &vkDSLBindless_));
+  VK_ASSERT(ivkSetDebugObjectName(vkDevice_,
+                                  VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT,
+                                  (uint64_t)vkDSLBindless_,
+                                  "Descriptor Set Layout: VulkanContext::dslBindless_"));
+
+  if (useDescriptorBuffer_) {
+    VkDeviceSize size = 0;
+    vkGetDescriptorSetLayoutSizeEXT(vkDevice_, vkDSLBindless_, &size);
+    // getBindlessLimits() bounds each descriptor type separately; all bindings share one range
+    const VkDeviceSize range =
+        std::min(vkDescriptorBufferProperties_.maxResourceDescriptorBufferRange, vkDescriptorBufferProperties_.maxSamplerDescriptorBufferRange);
+    if (!IGL_VERIFY(size <= range)) {
+      LLOGW("Bindless descriptor buffer exceeds the addressable range: %llu (max %llu)\n", (unsigned long long)size, (unsigned long long)range);
+    }
+    for (uint32_t i = 0; i != numBindings; i++) {
+      vkGetDescriptorSetLayoutBindingOffsetEXT(vkDevice_, vkDSLBindless_, i, &descriptorBufferBindingOffsets_[i]);
+    }
+    Result result;
+    descriptorBuffer_ = createBuffer(size,
+                                     VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT |
+                                         VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                     &result,
+                                     "Buffer: bindless descriptors");
+    if (!IGL_VERIFY(result.isOk())) {
+      return result;
+    }
+    // migrate all existing descriptors: every slot is dirty in the new descriptor buffer
+    for (uint32_t i = 0; i != std::min((uint32_t)texturesPool_.objects_.size(), newMaxTextures); i++) {
+      texturesPool_.dirtySlots_.push_back(i);
+    }
+    for (uint32_t i = 0; i != std::min((uint32_t)samplersPool_.objects_.size(), newMaxSamplers); i++) {
+      samplersPool_.dirtySlots_.push_back(i);
+    }
+  } else {
+    // create default descriptor pool and allocate a ring of descriptor sets
+    const VkDescriptorPoolSize poolSizes[numBindings]{
+        VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, numSets * newMaxTextures},
+        VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_SAMPLER, numSets * newMaxSamplers},
+        VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, numSets * newMaxTextures},
+    };
+    VK_ASSERT_RETURN(ivkCreateDescriptorPool(vkDevice_, numSets, numBindings, poolSizes, &vkDPBindless_));
+
+    // migrate all existing descriptors: every slot is dirty in the new descriptor sets
+    std::vector<uint32_t> allTextures(std::min((uint32_t)texturesPool_.objects_.size(), newMaxTextures));
+    std::vector<uint32_t> allSamplers(std::min((uint32_t)samplersPool_.objects_.size(), newMaxSamplers));
+    std::iota(allTextures.begin(), allTextures.end(), 0u);
+    std::iota(allSamplers.begin(), allSamplers.end(), 0u);
+
+    bindlessDSets_.clear();
+    bindlessDSets_.resize(numSets);
+    currentDSetIndex_ = 0;
+    for (BindlessDescriptorSet& dset : bindlessDSets_) {
+      VK_ASSERT_RETURN(ivkAllocateDescriptorSet(vkDevice_, vkDPBindless_, vkDSLBindless_, &dset.ds));
+      dset.dirtyTextures = allTextures;
+      dset.dirtySamplers = allSamplers;
+    }
+  }
+
+  // create pipeline layout
+  {
+    const VkPushConstantRange range = {
+        .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = kPushConstantsSize,
+    };
+    const VkPipelineLayoutCreateInfo ci = ivkGetPipelineLayoutCreateInfo(1, &vkDSLBindless_, &range);
+
+    VK_ASSERT_RETURN(vkCreatePipelineLayout(vkDevice_, &ci, nullptr, &vkPipelineLayout_));
+    VK_ASSERT(ivkSetDebugObjectName(
+        vkDevice_, VK_OBJECT_TYPE_PIPELINE_LAYOUT, (uint64_t)vkPipelineLayout_, "Pipeline Layout: VulkanContext::pipelineLayout_"));
+  }
+
+  return Result();
+}
+
+VkPipelineLayout VulkanContext::bindDefaultDescriptorSets(const VulkanImmediateCommands& immediate,
+                                                          const VulkanImmediateCommands::CommandBufferWrapper& wrapper,
+                                                          VkPipelineBindPoint bindPoint) const {
   IGL_PROFILER_FUNCTION();
 
+  std::lock_guard<std::mutex> lock(bindlessMutex_);
+
 #if IGL_DEBUG_DESCRIPTOR_SETS
   IGL_LOG_INFO("Binding descriptor set %u\n", currentDSetIndex_);
 #endif // IGL_DEBUG_DESCRIPTOR_SETS
 
-  vkCmdBindDescriptorSets(cmdBuf,
-                          bindPoint,
-                          vkPipelineLayout_,
-                          0,
-                          1,
-                          &bindlessDSets_[currentDSetIndex_].ds,
-                          0,
-                          nullptr);
+  if (useDescriptorBuffer_) {
+    const lvk::vulkan::VulkanBuffer* buf = buffersPool_.get(descriptorBuffer_);
+    const VkDescriptorBufferBindingInfoEXT bi = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT,
+        .address = buf->getVkDeviceAddress(),
+        .usage = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT | VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT,
+    };
+    const uint32_t bufferIndex = 0;
+    const VkDeviceSize offset = 0;
+    vkCmdBindDescriptorBuffersEXT(wrapper.cmdBuf_, 1, &bi);
+    vkCmdSetDescriptorBufferOffsetsEXT(wrapper.cmdBuf_, bindPoint, vkPipelineLayout_, 0, 1, &bufferIndex, &offset);
+    return vkPipelineLayout_;
+  }
+
+  BindlessDescriptorSet& dset = bindlessDSets_[currentDSetIndex_];
+
+  // this descriptor set cannot be updated until this command buffer is processed by the GPU
+  std::vector<SubmitHandle>& handles = &immediate == immediateCompute_.get() ? dset.handlesCompute : dset.handles;
+
+  if (handles.empty() || handles.back().handle() != wrapper.handle_.handle()) {
+    // forget about command buffers which have already retired
+    std::erase_if(handles, [&immediate](SubmitHandle h) { return immediate.isReady(h, true); });
+    handles.push_back(wrapper.handle_);
+  }
+
+  vkCmdBindDescriptorSets(wrapper.cmdBuf_, bindPoint, vkPipelineLayout_, 0, 1, &dset.ds, 0, nullptr);
+
+  return vkPipelineLayout_;
+}
+
+VkPipelineLayout VulkanContext::getVkPipelineLayout() const {
+  std::lock_guard<std::mutex> lock(bindlessMutex_);
+
+  return vkPipelineLayout_;
+}
+
+VkPipelineLayout VulkanContext::acquirePipelineLayout() {
+  std::lock_guard<std::mutex> lock(bindlessMutex_);
+  std::lock_guard<std::mutex> lockLayouts(pipelineLayoutsMutex_);
+
+  pipelineLayoutUsers_[vkPipelineLayout_]++;
+
+  return vkPipelineLayout_;
+}
+
+void VulkanContext::releasePipelineLayout(VkPipelineLayout layout) {
+  std::lock_guard<std::mutex> lock(pipelineLayoutsMutex_);
+
+  auto it = pipelineLayoutUsers_.find(layout);
+
+  if (!IGL_VERIFY(it != pipelineLayoutUsers_.end())) {
+    return;
+  }
+
+  if (--it->second) {
+    return;
+  }
+
+  pipelineLayoutUsers_.erase(it);
+
+  // the last user of a retired layout destroys it
+  auto retired = std::find(retiredPipelineLayouts_.begin(), retiredPipelineLayouts_.end(), layout);
+
+  if (retired != retiredPipelineLayouts_.end()) {
+    retiredPipelineLayouts_.erase(retired);
+    vkDestroyPipelineLayout(vkDevice_, layout, nullptr);
+  }
 }
 
-void VulkanContext::checkAndUpdateDescriptorSets() const {
-  if (awaitingDeletion_) {
-    // Our descriptor set was created with VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT which
-    // indicates that descriptors in this binding that are not dynamically used need not contain
-    // valid descriptors at the time the descriptors are consumed. A descriptor is dynamically used
-    // if any shader invocation executes an instruction that performs any memory access using the
-    // descriptor. If a descriptor is not dynamically used, any resource referenced by the
-    // descriptor is not considered to be referenced during command execution.
-    // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkDescriptorBindingFlagBits.html
-    awaitingDeletion_ = false;
+void VulkanContext::destroyPipelineLayout(VkPipelineLayout layout) {
+  std::lock_guard<std::mutex> lock(pipelineLayoutsMutex_);
+
+  if (pipelineLayoutUsers_.count(layout)) {
+    retiredPipelineLayouts_.push_back(layout);
+    return;
   }
 
-  if (!awaitingCreation_) {
+  vkDestroyPipelineLayout(vkDevice_, layout, nullptr);
+}
+
+bool VulkanContext::isDescriptorSetReady(uint32_t index) const {
+  const BindlessDescriptorSet& dset = bindlessDSets_[index];
+
+  for (SubmitHandle h : dset.handles) {
+    if (!immediate_->isReady(h)) {
+      return false;
+    }
+  }
+  for (SubmitHandle h : dset.handlesCompute) {
+    if (!immediateCompute_->isReady(h)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void VulkanContext::getBindlessLimits(uint32_t& maxTextures, uint32_t& maxSamplers) const {
+  if (!useDescriptorBuffer_) {
+    maxTextures = std::min(vkPhysicalDeviceVulkan12Properties_.maxDescriptorSetUpdateAfterBindSampledImages,
+                           vkPhysicalDeviceVulkan12Properties_.maxDescriptorSetUpdateAfterBindStorageImages);
+    maxSamplers = vkPhysicalDeviceVulkan12Properties_.maxDescriptorSetUpdateAfterBindSamplers;
+    return;
+  }
+
+  // descriptor buffers do not use update-after-bind: the regular per-set limits apply, and every descriptor has to be
+  // addressable from the start of the single descriptor buffer binding
+  const VkPhysicalDeviceLimits& limits = getVkPhysicalDeviceProperties().limits;
+  const VkPhysicalDeviceDescriptorBufferPropertiesEXT& props = vkDescriptorBufferProperties_;
+  const VkDeviceSize range = std::min(props.maxResourceDescriptorBufferRange, props.maxSamplerDescriptorBufferRange);
+  const VkDeviceSize rangeTextures = range / (props.sampledImageDescriptorSize + props.storageImageDescriptorSize);
+  const VkDeviceSize rangeSamplers = range / props.samplerDescriptorSize;
+
+  maxTextures = std::min({limits.maxDescriptorSetSampledImages,
+                          limits.maxDescriptorSetStorageImages,
+                          (uint32_t)std::min(rangeTextures, (VkDeviceSize)UINT32_MAX)});
+  maxSamplers = std::min(limits.maxDescriptorSetSamplers, (uint32_t)std::min(rangeSamplers, (VkDeviceSize)UINT32_MAX));
+}
+
+void VulkanContext::checkAndUpdateDescriptorSets() {
+  // Our descriptor set was created with VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT which
+  // indicates that descriptors in this binding that are not dynamically used need not contain
+  // valid descriptors at the time the descriptors are consumed. A descriptor is dynamically used
+  // if any shader invocation executes an instruction that performs any memory access using the
+  // descriptor. If a descriptor is not dynamically used, any resource referenced by the
+  // descriptor is not considered to be referenced during command execution.
+  // https://registry.khronos.org/vulkan/specs/1.3-extensions/man/html/VkDescriptorBindingFlagBits.html
+  // Still, destroyed slots are pointed to the dummy texture/sampler to keep the table free of dangling handles.
+  std::lock_guard<std::mutex> lock(bindlessMutex_);
+
+  if (!texturesPool_.hasDirtySlots() && !samplersPool_.hasDirtySlots()) {
     // nothing to update here
     return;
   }
@@ -1032,31 +1358,143 @@ void VulkanContext::checkAndUpdateDescriptorSets() const {
   // newly created resources can be used immediately - make sure they are put into descriptor sets
   IGL_PROFILER_FUNCTION();
 
-  // update Vulkan descriptor set here
-
   // make sure the guard values are always there
-  IGL_ASSERT(texturesPool_.numObjects() >= 1); 
+  IGL_ASSERT(texturesPool_.numObjects() >= 1);
   IGL_ASSERT(samplersPool_.numObjects() >= 1);
 
+  // grow the bindless tables geometrically if the pools do not fit anymore
+  const uint32_t requiredTextures = (uint32_t)texturesPool_.objects_.size();
+  const uint32_t requiredSamplers = (uint32_t)samplersPool_.objects_.size();
+
+  if (requiredTextures > currentMaxTextures_ || requiredSamplers > currentMaxSamplers_) {
+    uint32_t limitTextures = 0;
+    uint32_t limitSamplers = 0;
+    getBindlessLimits(limitTextures, limitSamplers);
+
+    uint32_t newMaxTextures = currentMaxTextures_;
+    uint32_t newMaxSamplers = currentMaxSamplers_;
+
+    while (newMaxTextures < requiredTextures) {
+      newMaxTextures = std::max(2 * newMaxTextures, 16u);
+    }
+    while (newMaxSamplers < requiredSamplers) {
+      newMaxSamplers = std::max(2 * newMaxSamplers, 16u);
+    }
+
+    if (!IGL_VERIFY(requiredTextures <= limitTextures)) {
+      LLOGW("Max Textures exceeded: %u (max %u)", requiredTextures, limitTextures);
+    }
+    if (!IGL_VERIFY(requiredSamplers <= limitSamplers)) {
+      LLOGW("Max Samplers exceeded: %u (max %u)", requiredSamplers, limitSamplers);
+    }
+
+    newMaxTextures = std::max(std::min(newMaxTextures, limitTextures), currentMaxTextures_);
+    newMaxSamplers = std::max(std::min(newMaxSamplers, limitSamplers), currentMaxSamplers_);
+
+#if IGL_VULKAN_PRINT_COMMANDS
+    LLOGL("Growing bindless tables: textures %u -> %u, samplers %u -> %u\n",
+          currentMaxTextures_,
+          newMaxTextures,
+          currentMaxSamplers_,
+          newMaxSamplers);
+#endif // IGL_VULKAN_PRINT_COMMANDS
+
+    const Result result = growBindlessDescriptorSets(newMaxTextures, newMaxSamplers);
+    if (!IGL_VERIFY(result.isOk())) {
+      // the old tables are gone and the new ones could not be created: there is nothing to write into
+      LLOGW("Cannot grow bindless tables: %s\n", result.message);
+      return;
+    }
+  }
+
+  // slots which do not fit into the tables are not written; growing the tables later marks every slot dirty again
+  auto consumeDirtySlots = [](auto& pool, uint32_t maxSlots) {
+    std::vector<uint32_t> slots = pool.consumeDirtySlots();
+    std::erase_if(slots, [maxSlots](uint32_t idx) { return idx >= maxSlots; });
+    return slots;
+  };
+
+  if (useDescriptorBuffer_) {
+    // no descriptor sets to rotate: descriptors are written directly into the descriptor buffer
+    updateDescriptorBuffer(consumeDirtySlots(texturesPool_, currentMaxTextures_), consumeDirtySlots(samplersPool_, currentMaxSamplers_));
+    return;
+  }
+
+  // 0. Carry the dirty slots forward into every descriptor set of the ring
+  {
+    const std::vector<uint32_t> dirtyTextures = consumeDirtySlots(texturesPool_, currentMaxTextures_);
+    const std::vector<uint32_t> dirtySamplers = consumeDirtySlots(samplersPool_, currentMaxSamplers_);
+
+    for (BindlessDescriptorSet& dset : bindlessDSets_) {
+      dset.dirtyTextures.insert(dset.dirtyTextures.end(), dirtyTextures.begin(), dirtyTextures.end());
+      dset.dirtySamplers.insert(dset.dirtySamplers.end(), dirtySamplers.begin(), dirtySamplers.end());
+    }
+  }
+
+  // we want to update the next descriptor set which is not used by the GPU anymore
+  const uint32_t numSets = (uint32_t)bindlessDSets_.size();
+  uint32_t nextDSetIndex = (currentDSetIndex_ + 1) % numSets;
+
+  for (uint32_t i = 1; i <= numSets; i++) {
+    const uint32_t idx = (currentDSetIndex_ + i) % numSets;
+    if (idx != currentDSetIndex_ && isDescriptorSetReady(idx)) {
+      nextDSetIndex = idx;
+      break;
+    }
+  }
+
+  BindlessDescriptorSet& dsetToUpdate = bindlessDSets_[nextDSetIndex];
+
+  if (!isDescriptorSetReady(nextDSetIndex)) {
+    // the ring is too small for the number of frames in flight: all submitted command buffers using this descriptor set
+    // have to be completed; the command buffers being recorded now can still use descriptors updated after bind
+    IGL_PROFILER_ZONE("Waiting for bindless descriptor set...", IGL_PROFILER_COLOR_WAIT);
+#if IGL_VULKAN_PRINT_COMMANDS
+    LLOGL("All bindless descriptor sets are in use, consider increasing VulkanContextConfig::numBindlessDescriptorSets\n");
+#endif // IGL_VULKAN_PRINT_COMMANDS
+    for (SubmitHandle h : dsetToUpdate.handles) {
+      if (!immediate_->isEncoding(h)) {
+        immediate_->wait(h);
+      }
+    }
+    for (SubmitHandle h : dsetToUpdate.handlesCompute) {
+      if (!immediateCompute_->isEncoding(h)) {
+        immediateCompute_->wait(h);
+      }
+    }
+    IGL_PROFILER_ZONE_END();
+  }
+
+  // slots could have been modified multiple times since this descriptor set was last updated
+  std::vector<uint32_t> dirtyTextures = std::move(dsetToUpdate.dirtyTextures);
+  std::vector<uint32_t> dirtySamplers = std::move(dsetToUpdate.dirtySamplers);
+  dsetToUpdate.dirtyTextures.clear();
+  dsetToUpdate.dirtySamplers.clear();
+  std::sort(dirtyTextures.begin(), dirtyTextures.end());
+  std::sort(dirtySamplers.begin(), dirtySamplers.end());
+  dirtyTextures.erase(std::unique(dirtyTextures.begin(), dirtyTextures.end()), dirtyTextures.end());
+  dirtySamplers.erase(std::unique(dirtySamplers.begin(), dirtySamplers.end()), dirtySamplers.end());
+
+  // use the dummy texture/sampler to avoid sparse array
+  const VkImageView dummyImageView = texturesPool_.objects_[0].obj_.imageView_->getVkImageView();
+  const VkSampler dummySampler = samplersPool_.objects_[0].obj_;
+
   // 1. Sampled and storage images
   std::vector<VkDescriptorImageInfo> infoSampledImages;
   std::vector<VkDescriptorImageInfo> infoStorageImages;
-  
-  infoSampledImages.reserve(texturesPool_.numObjects());
-  infoStorageImages.reserve(texturesPool_.numObjects());
 
-  // use the dummy texture to avoid sparse array
-  VkImageView dummyImageView = texturesPool_.objects_[0].obj_.imageView_->getVkImageView();
+  infoSampledImages.reserve(dirtyTextures.size());
+  infoStorageImages.reserve(dirtyTextures.size());
 
-  for (const auto& obj : texturesPool_.objects_) {
-    const VulkanTexture& texture = obj.obj_;
+  for (uint32_t idx : dirtyTextures) {
+    const VulkanTexture& texture = texturesPool_.objects_[idx].obj_;
     // multisampled images cannot be directly accessed from shaders
     const bool isTextureAvailable =
-        (texture.image_->samples_ & VK_SAMPLE_COUNT_1_BIT) == VK_SAMPLE_COUNT_1_BIT;
+        texture.image_ && (texture.image_->samples_ & VK_SAMPLE_COUNT_1_BIT) == VK_SAMPLE_COUNT_1_BIT;
     const bool isSampledImage = isTextureAvailable && texture.image_->isSampledImage();
     const bool isStorageImage = isTextureAvailable && texture.image_->isStorageImage();
     infoSampledImages.push_back(
-        {samplersPool_.objects_[0].obj_,
+        {dummySampler,
          isSampledImage ? texture.imageView_->getVkImageView() : dummyImageView,
          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL});
     IGL_ASSERT(infoSampledImages.back().imageView != VK_NULL_HANDLE);
@@ -1068,57 +1506,156 @@ void VulkanContext::checkAndUpdateDescriptorSets() const {
 
   // 2. Samplers
   std::vector<VkDescriptorImageInfo> infoSamplers;
-  infoSamplers.reserve(samplersPool_.objects_.size());
+  infoSamplers.reserve(dirtySamplers.size());
+
+  for (uint32_t idx : dirtySamplers) {
+    const VkSampler sampler = samplersPool_.objects_[idx].obj_;
+    infoSamplers.push_back({sampler ? sampler : dummySampler, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED});
+  }
+
+  // 3. Coalesce consecutive dirty slots into ranges - one VkWriteDescriptorSet per range
+  std::vector<VkWriteDescriptorSet> writes;
+
+  auto addWrites = [&writes, ds = dsetToUpdate.ds](const std::vector<uint32_t>& slots,
+                                                   uint32_t binding,
+                                                   VkDescriptorType type,
+                                                   const std::vector<VkDescriptorImageInfo>& infos) {
+    for (size_t first = 0; first != slots.size();) {
+      size_t last = first + 1;
+      while (last != slots.size() && slots[last] == slots[last - 1] + 1) {
+        last++;
+      }
+      VkWriteDescriptorSet write =
+          ivkGetWriteDescriptorSet_ImageInfo(ds, binding, type, uint32_t(last - first), &infos[first]);
+      write.dstArrayElement = slots[first];
+      writes.push_back(write);
+      first = last;
+    }
+  };
+
+  addWrites(dirtyTextures, kBinding_Textures, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, infoSampledImages);
+  addWrites(dirtySamplers, kBinding_Samplers, VK_DESCRIPTOR_TYPE_SAMPLER, infoSamplers);
+  addWrites(dirtyTextures, kBinding_StorageImages, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, infoStorageImages);
+
+  // do not switch to the next descriptor set if there is nothing to update
+  if (!writes.empty()) {
+#if IGL_VULKAN_PRINT_COMMANDS
+    LLOGL("Updating descriptor set %u (%u writes)\n", nextDSetIndex, (uint32_t)writes.size());
+#endif // IGL_VULKAN_PRINT_COMMANDS
+    currentDSetIndex_ = nextDSetIndex;
+    vkUpdateDescriptorSets(vkDevice_, (uint32_t)writes.size(), writes.data(), 0, nullptr);
+    numDescriptorsWrittenThisFrame_ += uint32_t(2 * infoSampledImages.size() + infoSamplers.size());
+  }
+}
+
+void VulkanContext::updateDescriptorBuffer(const std::vector<uint32_t>& dirtyTextures, const std::vector<uint32_t>& dirtySamplers) {
+  IGL_PROFILER_FUNCTION();
+
+  lvk::vulkan::VulkanBuffer* buf = buffersPool_.get(descriptorBuffer_);
+
+  IGL_ASSERT(buf && buf->isMapped());
+
+  uint8_t* ptr = buf->getMappedPtr();
+
+  const VkImageView dummyImageView = texturesPool_.objects_[0].obj_.imageView_->getVkImageView();
+  const VkSampler dummySampler = samplersPool_.objects_[0].obj_;
+
+  const size_t sampledImageSize = vkDescriptorBufferProperties_.sampledImageDescriptorSize;
+  const size_t storageImageSize = vkDescriptorBufferProperties_.storageImageDescriptorSize;
+  const size_t samplerSize = vkDescriptorBufferProperties_.samplerDescriptorSize;
+
+  // Slots are written in place: dirty slots must not be dynamically used by any pending GPU work, which is the same
+  // contract as VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT in the descriptor sets path.
+  for (uint32_t idx : dirtyTextures) {
+    const VulkanTexture& texture = texturesPool_.objects_[idx].obj_;
+    // multisampled images cannot be directly accessed from shaders
+    const bool isTextureAvailable =
+        texture.image_ && (texture.image_->samples_ & VK_SAMPLE_COUNT_1_BIT) == VK_SAMPLE_COUNT_1_BIT;
+    const bool isSampledImage = isTextureAvailable && texture.image_->isSampledImage();
+    const bool isStorageImage = isTextureAvailable && texture.image_->isStorageImage();
+    const VkDescriptorImageInfo sampledImage = {
+        VK_NULL_HANDLE, isSampledImage ? texture.imageView_->getVkImageView() : dummyImageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    const VkDescriptorImageInfo storageImage = {
+        VK_NULL_HANDLE, isStorageImage ? texture.imageView_->getVkImageView() : dummyImageView, VK_IMAGE_LAYOUT_GENERAL};
+    const VkDescriptorGetInfoEXT sampledInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT,
+        .type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+        .data = {.pSampledImage = &sampledImage},
+    };
+    const VkDescriptorGetInfoEXT storageInfo = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT,
+        .type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+        .data = {.pStorageImage = &storageImage},
+    };
+    vkGetDescriptorEXT(
+        vkDevice_, &sampledInfo, sampledImageSize, ptr + descriptorBufferBindingOffsets_[kBinding_Textures] + idx * sampledImageSize);
+    vkGetDescriptorEXT(vkDevice_,
+                       &storageInfo,
+                       storageImageSize,
+                       ptr + descriptorBufferBindingOffsets_[kBinding_StorageImages] + idx * storageImageSize);
+  }
 
-  for (const auto& sampler : samplersPool_.objects_) {
-    infoSamplers.push_back({sampler.obj_ ? sampler.obj_ : samplersPool_.objects_[0].obj_,
-                            VK_NULL_HANDLE,
-                            VK_IMAGE_LAYOUT_UNDEFINED});
+  for (uint32_t idx : dirtySamplers) {
+    const VkSampler sampler = samplersPool_.objects_[idx].obj_ ? samplersPool_.objects_[idx].obj_ : dummySampler;
+    const VkDescriptorGetInfoEXT info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT,
+        .type = VK_DESCRIPTOR_TYPE_SAMPLER,
+        .data = {.pSampler = &sampler},
+    };
+    vkGetDescriptorEXT(vkDevice_, &info, samplerSize, ptr + descriptorBufferBindingOffsets_[kBinding_Samplers] + idx * samplerSize);
   }
 
-  VkWriteDescriptorSet write[kBinding_NumBindins] = {};
-  uint32_t numBindings = 0;
+  numDescriptorsWrittenThisFrame_ += uint32_t(2 * dirtyTextures.size() + dirtySamplers.size());
+}
 
-  // we want to update the next available descriptor set
-  const uint32_t nextDSetIndex = (currentDSetIndex_ + 1) % bindlessDSets_.size();
-  auto& dsetToUpdate = bindlessDSets_[nextDSetIndex];
+bool VulkanContext::isHostImageCopyOptimal(VkFormat format,
+                                           VkImageType imageType,
+                                           VkImageUsageFlags usageFlags,
+                                           VkImageCreateFlags flags) const {
+  if (!useHostImageCopy_) {
+    return false;
+  }
 
-  if (!infoSampledImages.empty()) {
-    write[numBindings++] = ivkGetWriteDescriptorSet_ImageInfo(dsetToUpdate.ds,
-                                                              kBinding_Textures,
-                                                              VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
-                                                              (uint32_t)infoSampledImages.size(),
-                                                              infoSampledImages.data());
+  const VkPhysicalDeviceImageFormatInfo2 info = {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_IMAGE_FORMAT_INFO_2,
+      .format = format,
+      .type = imageType,
+      .tiling = VK_IMAGE_TILING_OPTIMAL,
+      .usage = usageFlags | VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT,
+      .flags = flags,
+  };
+  VkHostImageCopyDevicePerformanceQueryEXT perfQuery = {
+      .sType = VK_STRUCTURE_TYPE_HOST_IMAGE_COPY_DEVICE_PERFORMANCE_QUERY_EXT,
+  };
+  VkImageFormatProperties2 props = {
+      .sType = VK_STRUCTURE_TYPE_IMAGE_FORMAT_PROPERTIES_2,
+      .pNext = &perfQuery,
   };
 
-  if (!infoSamplers.empty()) {
-    write[numBindings++] = ivkGetWriteDescriptorSet_ImageInfo(dsetToUpdate.ds,
-                                                              kBinding_Samplers,
-                                                              VK_DESCRIPTOR_TYPE_SAMPLER,
-                                                              (uint32_t)infoSamplers.size(),
-                                                              infoSamplers.data());
+  if (vkGetPhysicalDeviceImageFormatProperties2(vkPhysicalDevice_, &info, &props) != VK_SUCCESS) {
+    return false;
   }
 
-  if (!infoStorageImages.empty()) {
-    write[numBindings++] = ivkGetWriteDescriptorSet_ImageInfo(dsetToUpdate.ds,
-                                                              kBinding_StorageImages,
-                                                              VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
-                                                              (uint32_t)infoStorageImages.size(),
-                                                              infoStorageImages.data());
+  // do not trade GPU performance (i.e. lost framebuffer compression) for faster uploads
+  return perfQuery.optimalDeviceAccess == VK_TRUE;
+}
+
+bool VulkanContext::reserveReBarMemory(VkDeviceSize size) {
+  if (!reBarBudget_) {
+    return false;
   }
 
-  // do not switch to the next descriptor set if there is nothing to update
-  if (numBindings) {
-#if IGL_VULKAN_PRINT_COMMANDS
-    LLOGL("Updating descriptor set %u\n", nextDSetIndex);
-#endif // IGL_VULKAN_PRINT_COMMANDS
-    currentDSetIndex_ = nextDSetIndex;
-    immediate_->wait(std::exchange(dsetToUpdate.handle, immediate_->getLastSubmitHandle()));
-    vkUpdateDescriptorSets(vkDevice_, numBindings, write, 0, nullptr);
+  if (reBarUsage_.fetch_add(size) + size > reBarBudget_) {
+    reBarUsage_ -= size;
+    return false;
   }
 
-  awaitingCreation_ = false;
-  awaitingDeletion_ = false;
+  return true;
+}
+
+void VulkanContext::releaseReBarMemory(VkDeviceSize size) {
+  IGL_ASSERT(reBarUsage_ >= size);
+  reBarUsage_ -= size;
 }
 
 SamplerHandle VulkanContext::createSampler(const VkSamplerCreateInfo& ci,
@@ -1131,13 +1668,52 @@ SamplerHandle VulkanContext::createSampler(const VkSamplerCreateInfo& ci,
   VK_ASSERT(vkCreateSampler(vkDevice_, &ci, nullptr, &sampler));
   VK_ASSERT(ivkSetDebugObjectName(vkDevice_, VK_OBJECT_TYPE_SAMPLER, (uint64_t)sampler, debugName));
 
-  SamplerHandle handle = samplersPool_.create(VkSampler(sampler));
+  return samplersPool_.create(VkSampler(sampler));
+}
+
+VkPipeline VulkanContext::getVkPipeline(ComputePipelineHandle handle, VkPipelineLayout layout) {
+  ComputePipelineState* cps = computePipelinesPool_.get(handle);
+
+  if (!cps) {
+    return VK_NULL_HANDLE;
+  }
+
+  std::lock_guard<std::mutex> lock(pipelinesMutex_);
+
+  if (cps->pipelineLayout_ != layout) {
+    // the bindless pipeline layout has been recreated - the old pipeline is not compatible anymore
+    if (cps->pipeline_ != VK_NULL_HANDLE) {
+      deferredTask(std::packaged_task<void()>([device = vkDevice_, pipeline = cps->pipeline_]() { vkDestroyPipeline(device, pipeline, nullptr); }),
+                   immediate_->getNextSubmitHandle());
+    }
+    cps->pipeline_ = VK_NULL_HANDLE;
+    cps->pipelineLayout_ = layout;
+  }
+
+  if (cps->pipeline_ == VK_NULL_HANDLE) {
+    IGL_PROFILER_FUNCTION_COLOR(IGL_PROFILER_COLOR_CREATE);
+
+    const VulkanShaderModule* sm = shaderModulesPool_.get(cps->shaderModule_);
+
+    IGL_ASSERT(sm);
 
-  IGL_ASSERT(samplersPool_.numObjects() <= config_.maxSamplers);
+    if (!sm) {
+      return VK_NULL_HANDLE;
+    }
 
-  awaitingCreation_ = true;
+    const VkComputePipelineCreateInfo ci = {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .flags = useDescriptorBuffer_ ? VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT : VkPipelineCreateFlags(0),
+        .stage = ivkGetPipelineShaderStageCreateInfo(VK_SHADER_STAGE_COMPUTE_BIT, sm->getVkShaderModule(), sm->getEntryPoint()),
+        .layout = layout,
+        .basePipelineHandle = VK_NULL_HANDLE,
+        .basePipelineIndex = -1,
+    };
+    VK_ASSERT(vkCreateComputePipelines(vkDevice_, pipelineCache_, 1, &ci, nullptr, &cps->pipeline_));
+    VK_ASSERT(ivkSetDebugObjectName(vkDevice_, VK_OBJECT_TYPE_PIPELINE, (uint64_t)cps->pipeline_, cps->debugName_));
+  }
 
-  return handle;
+  return cps->pipeline_;
 }
 
 void VulkanContext::querySurfaceCapabilities() {
@@ -1227,7 +1803,19 @@ void VulkanContext::deferredTask(std::packaged_task<void()>&& task, SubmitHandle
   if (handle.empty()) {
     handle = immediate_->getLastSubmitHandle();
   }
-  deferredTasks_.emplace_back(std::move(task), handle);
+
+  // command buffers which are being recorded now (possibly on other threads) might use the resource as well
+  std::vector<SubmitHandle> handles = {handle};
+  std::vector<SubmitHandle> handlesCompute;
+  immediate_->getEncodingHandles(handles);
+  if (immediateCompute_) {
+    handlesCompute.push_back(immediateCompute_->getLastSubmitHandle());
+    immediateCompute_->getEncodingHandles(handlesCompute);
+  }
+
+  std::lock_guard<std::mutex> lock(deferredTasksMutex_);
+
+  deferredTasks_.emplace_back(std::move(task), std::move(handles), std::move(handlesCompute));
 }
 
 bool VulkanContext::areValidationLayersEnabled() const {
@@ -1239,18 +1827,47 @@ void* VulkanContext::getVmaAllocator() const {
 }
 
 void VulkanContext::processDeferredTasks() const {
-  while (!deferredTasks_.empty() && immediate_->isReady(deferredTasks_.front().handle_, true)) {
-    deferredTasks_.front().task_();
-    deferredTasks_.pop_front();
+  auto isTaskReady = [this](const DeferredTask& task) {
+    for (SubmitHandle h : task.handles_) {
+      if (!immediate_->isReady(h, true)) {
+        return false;
+      }
+    }
+    for (SubmitHandle h : task.handlesCompute_) {
+      if (!immediateCompute_->isReady(h)) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  while (true) {
+    std::packaged_task<void()> task;
+    {
+      std::lock_guard<std::mutex> lock(deferredTasksMutex_);
+      if (deferredTasks_.empty() || !isTaskReady(deferredTasks_.front())) {
+        return;
+      }
+      task = std::move(deferredTasks_.front().task_);
+      deferredTasks_.pop_front();
+    }
+    // tasks can schedule other deferred tasks
+    task();
   }
 }
 
 void VulkanContext::waitDeferredTasks() {
-  for (auto& task : deferredTasks_) {
-    immediate_->wait(task.handle_);
-    task.task_();
+  // no command buffers are being recorded at this point
+  immediate_->waitAll();
+  if (immediateCompute_) {
+    immediateCompute_->waitAll();
+  }
+
+  while (!deferredTasks_.empty()) {
+    std::packaged_task<void()> task = std::move(deferredTasks_.front().task_);
+    deferredTasks_.pop_front();
+    task();
   }
-  deferredTasks_.clear();
 }
 
 } // namespace vulkan
@@ -7,9 +7,13 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <deque>
 #include <future>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include <igl/vulkan/Common.h>
@@ -17,9 +21,11 @@
 #include <igl/vulkan/VulkanBuffer.h>
 #include <igl/vulkan/VulkanHelpers.h>
 #include <igl/vulkan/VulkanImmediateCommands.h>
+#include <igl/vulkan/VulkanPipelineCompiler.h>
 #include <igl/vulkan/VulkanShaderModule.h>
 #include <igl/vulkan/VulkanStagingDevice.h>
 #include <igl/vulkan/VulkanTexture.h>
+#include <igl/vulkan/VulkanTransientArena.h>
 #include <lvk/Pool.h>
 #include <lvk/vulkan/VulkanUtils.h>
 
@@ -41,16 +47,36 @@ struct DeviceQueues {
   const static uint32_t INVALID = 0xFFFFFFFF;
   uint32_t graphicsQueueFamilyIndex = INVALID;
   uint32_t computeQueueFamilyIndex = INVALID;
+  // a dedicated transfer-only queue family for staging uploads (INVALID if the device does not have one)
+  uint32_t transferQueueFamilyIndex = INVALID;
 
   VkQueue graphicsQueue = VK_NULL_HANDLE;
   VkQueue computeQueue = VK_NULL_HANDLE;
+  VkQueue transferQueue = VK_NULL_HANDLE;
 
   DeviceQueues() = default;
 };
 
 struct VulkanContextConfig {
-  uint32_t maxTextures = 512;
-  uint32_t maxSamplers = 512;
+  // initial capacity of the bindless tables; they grow on demand when more textures/samplers are created
+  uint32_t maxTextures = 16;
+  uint32_t maxSamplers = 16;
+  // the number of bindless descriptor sets in the ring; should be at least the number of frames in flight
+  uint32_t numBindlessDescriptorSets = 3;
+  // use VK_EXT_descriptor_buffer for bindless descriptors when available (falls back to descriptor sets otherwise)
+  bool enableDescriptorBuffer = false;
+  // upload textures directly from host memory with VK_EXT_host_image_copy when available (no staging buffer)
+  bool enableHostImageCopy = true;
+  // the share of the Resizable BAR heap which BufferAccess_Stream buffers and the transient arena can occupy to be written
+  // by the CPU directly (0 - always use staging)
+  float reBarBudgetFraction = 0.5f;
+  // IDevice::allocateTransient(): the arena is created on the first allocation and holds this many frames in flight
+  uint32_t transientArenaSizePerFrame = 4u * 1024u * 1024u;
+  uint32_t numTransientArenaFrames = 3;
+  // IDevice::prewarmRenderPipeline() compiles pipelines on these threads (0 - on the calling thread)
+  uint32_t numPipelineCompilerThreads = 2;
+  // draws which need a pipeline still being compiled (i.e. by IDevice::prewarmRenderPipeline()) are skipped instead of waiting for it
+  bool skipDrawsWithPendingPipelines = false;
   bool terminateOnValidationError = false; // invoke std::terminate() on any validation error
   bool enableValidation = true;
   lvk::ColorSpace swapChainColorSpace = lvk::ColorSpace_SRGB_LINEAR;
@@ -59,6 +85,14 @@ struct VulkanContextConfig {
   size_t pipelineCacheDataSize = 0;
 };
 
+struct ComputePipelineState {
+  lvk::ShaderModuleHandle shaderModule_ = {};
+  const char* debugName_ = "";
+  VkPipeline pipeline_ = VK_NULL_HANDLE;
+  // the pipeline layout which was used to create pipeline_; the bindless pipeline layout is recreated when tables grow
+  VkPipelineLayout pipelineLayout_ = VK_NULL_HANDLE;
+};
+
 class VulkanContext final {
  public:
   VulkanContext(const VulkanContextConfig& config, void* window, void* display = nullptr);
@@ -86,8 +120,22 @@ class VulkanContext final {
                             VkMemoryPropertyFlags memFlags,
                             lvk::Result* outResult,
                             const char* debugName = nullptr);
+  // true if images with these parameters can use VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT without slowing down device access
+  bool isHostImageCopyOptimal(VkFormat format, VkImageType imageType, VkImageUsageFlags usageFlags, VkImageCreateFlags flags) const;
+  // Resizable BAR: returns false if the buffer does not fit into the budget and should be placed into regular device memory
+  bool reserveReBarMemory(VkDeviceSize size);
+  void releaseReBarMemory(VkDeviceSize size);
   SamplerHandle createSampler(const VkSamplerCreateInfo& ci, lvk::Result* outResult, const char* debugName = nullptr);
 
+  // lazily (re)creates the compute pipeline if the pipeline layout has changed; thread-safe
+  VkPipeline getVkPipeline(ComputePipelineHandle handle, VkPipelineLayout layout);
+  // the latest bindless pipeline layout
+  VkPipelineLayout getVkPipelineLayout() const;
+  // the latest bindless pipeline layout, kept alive until releasePipelineLayout() even if the bindless tables grow
+  // meanwhile (i.e. for background pipeline compilation)
+  VkPipelineLayout acquirePipelineLayout();
+  void releasePipelineLayout(VkPipelineLayout layout);
+
   bool hasSwapchain() const noexcept {
     return swapchain_ != nullptr;
   }
@@ -121,18 +169,34 @@ class VulkanContext final {
 
   using SubmitHandle = VulkanImmediateCommands::SubmitHandle;
 
-  // execute a task some time in the future after the submit handle finished processing
+  // execute a task some time in the future after the submit handle finished processing (and all command buffers
+  // which are being recorded now are processed as well)
   void deferredTask(std::packaged_task<void()>&& task, SubmitHandle handle = SubmitHandle()) const;
 
   bool areValidationLayersEnabled() const;
 
   void* getVmaAllocator() const;
 
+  // the number of bindless descriptors written during the last presented frame
+  uint32_t getNumDescriptorsWrittenLastFrame() const {
+    return numDescriptorsWrittenLastFrame_;
+  }
+
  private:
   void createInstance();
   void createSurface(void* window, void* display);
-  void checkAndUpdateDescriptorSets() const;
-  void bindDefaultDescriptorSets(VkCommandBuffer cmdBuf, VkPipelineBindPoint bindPoint) const;
+  void checkAndUpdateDescriptorSets();
+  void updateDescriptorBuffer(const std::vector<uint32_t>& dirtyTextures, const std::vector<uint32_t>& dirtySamplers);
+  lvk::Result growBindlessDescriptorSets(uint32_t newMaxTextures, uint32_t newMaxSamplers);
+  // destroys a retired pipeline layout now or when its last user releases it
+  void destroyPipelineLayout(VkPipelineLayout layout);
+  // the largest bindless tables supported by the device for the current descriptor model
+  void getBindlessLimits(uint32_t& maxTextures, uint32_t& maxSamplers) const;
+  // returns the pipeline layout the descriptors were bound with
+  VkPipelineLayout bindDefaultDescriptorSets(const VulkanImmediateCommands& immediate,
+                                             const VulkanImmediateCommands::CommandBufferWrapper& wrapper,
+                                             VkPipelineBindPoint bindPoint) const;
+  bool isDescriptorSetReady(uint32_t index) const;
   void querySurfaceCapabilities();
   void processDeferredTasks() const;
   void waitDeferredTasks();
@@ -155,6 +219,10 @@ class VulkanContext final {
                                                     .pNext = &vkFeatures12_};
   VkPhysicalDeviceFeatures2 vkFeatures10_ = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, .pNext = &vkFeatures11_};
 
+  // provided by VK_EXT_descriptor_buffer
+  VkPhysicalDeviceDescriptorBufferPropertiesEXT vkDescriptorBufferProperties_ = {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT};
+
   // provided by Vulkan 1.2
   VkPhysicalDeviceDriverProperties vkPhysicalDeviceDriverProperties_ = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DRIVER_PROPERTIES, nullptr};
   VkPhysicalDeviceVulkan12Properties vkPhysicalDeviceVulkan12Properties_ = {
@@ -175,41 +243,82 @@ class VulkanContext final {
   DeviceQueues deviceQueues_;
   std::unique_ptr<lvk::vulkan::VulkanSwapchain> swapchain_;
   std::unique_ptr<lvk::vulkan::VulkanImmediateCommands> immediate_;
+  // async compute: only if the compute queue family is different from the graphics one (otherwise compute goes via immediate_)
+  std::unique_ptr<lvk::vulkan::VulkanImmediateCommands> immediateCompute_;
+  // queue families which can access buffers, storage images and (with async compute) sampled images
+  // (VK_SHARING_MODE_CONCURRENT if more than one)
+  std::vector<uint32_t> concurrentQueueFamilyIndices_;
   std::unique_ptr<lvk::vulkan::VulkanStagingDevice> stagingDevice_;
+  std::unique_ptr<lvk::vulkan::VulkanTransientArena> transientArena_; // created on demand
+  std::unique_ptr<lvk::vulkan::VulkanPipelineCompiler> pipelineCompiler_;
   VkPipelineLayout vkPipelineLayout_ = VK_NULL_HANDLE;
   VkDescriptorSetLayout vkDSLBindless_ = VK_NULL_HANDLE;
   VkDescriptorPool vkDPBindless_ = VK_NULL_HANDLE;
   struct BindlessDescriptorSet {
     VkDescriptorSet ds = VK_NULL_HANDLE;
-    SubmitHandle handle = SubmitHandle(); // a handle of the last submit this descriptor set was a part of
+    // all command buffers this descriptor set was bound to which might still be in flight (or recorded on other threads)
+    std::vector<SubmitHandle> handles;
+    std::vector<SubmitHandle> handlesCompute; // the same for immediateCompute_
+    // texture/sampler slots modified since this descriptor set was last updated
+    std::vector<uint32_t> dirtyTextures;
+    std::vector<uint32_t> dirtySamplers;
   };
   mutable std::vector<BindlessDescriptorSet> bindlessDSets_;
   mutable uint32_t currentDSetIndex_ = 0;
+  // VK_EXT_descriptor_buffer: bindless descriptors are written directly into a host-visible buffer
+  bool useDescriptorBuffer_ = false;
+  BufferHandle descriptorBuffer_;
+  VkDeviceSize descriptorBufferBindingOffsets_[3] = {}; // per binding in vkDSLBindless_
+  // the current capacity of the bindless tables
+  uint32_t currentMaxTextures_ = 0;
+  uint32_t currentMaxSamplers_ = 0;
   // don't use staging on devices with shared host-visible memory
   bool useStaging_ = true;
+  // Resizable BAR: device-local memory the CPU can write directly, on devices which otherwise use staging
+  VkDeviceSize reBarBudget_ = 0; // 0 - not available
+  std::atomic<VkDeviceSize> reBarUsage_ = 0;
+  // StorageType_Memoryless attachments are backed by lazily allocated memory (tilers); by regular device memory otherwise
+  bool hasLazilyAllocatedMemory_ = false;
+  // VK_EXT_host_image_copy: textures with VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT are written by the CPU directly
+  bool useHostImageCopy_ = false;
+  VkImageLayout hostImageCopyDstLayout_ = VK_IMAGE_LAYOUT_GENERAL;
 
   std::unique_ptr<VulkanContextImpl> pimpl_;
 
   VkPipelineCache pipelineCache_ = VK_NULL_HANDLE;
 
-  // a texture/sampler was created since the last descriptor set update
-  mutable bool awaitingCreation_ = false;
-  // a texture/sampler was deleted since the last descriptor set update
-  mutable bool awaitingDeletion_ = false;
+  // command buffers can be recorded on different threads
+  mutable std::mutex bindlessMutex_; // bindless descriptor sets, descriptor buffer, pipeline layout, and their statistics
+  mutable std::mutex pipelinesMutex_; // lazily created render and compute pipelines
+  mutable std::condition_variable pipelinesCondition_; // render pipelines compiled without pipelinesMutex_ have been installed
+  mutable std::mutex deferredTasksMutex_;
+  // tracked states of images and buffers (VulkanImage::subresourceStates_, VulkanBuffer::stageMask_/accessMask_); the
+  // command buffers which transition the same resource have to be submitted in the order they were recorded in
+  mutable std::recursive_mutex resourceStatesMutex_;
+  // users of pipeline layouts (acquirePipelineLayout()) and the retired layouts waiting for them; locked after bindlessMutex_
+  std::mutex pipelineLayoutsMutex_;
+  std::unordered_map<VkPipelineLayout, uint32_t> pipelineLayoutUsers_;
+  std::vector<VkPipelineLayout> retiredPipelineLayouts_;
+
+  // bindless descriptor writes statistics
+  mutable uint32_t numDescriptorsWrittenThisFrame_ = 0;
+  mutable uint32_t numDescriptorsWrittenLastFrame_ = 0;
 
   VulkanContextConfig config_;
 
   lvk::Pool<lvk::ShaderModule, lvk::vulkan::VulkanShaderModule> shaderModulesPool_;
   lvk::Pool<lvk::RenderPipeline, lvk::vulkan::RenderPipelineState> renderPipelinesPool_;
-  lvk::Pool<lvk::ComputePipeline, VkPipeline> computePipelinesPool_;
+  lvk::Pool<lvk::ComputePipeline, ComputePipelineState> computePipelinesPool_;
   lvk::Pool<lvk::Sampler, VkSampler> samplersPool_;
   lvk::Pool<lvk::Buffer, lvk::vulkan::VulkanBuffer> buffersPool_;
   lvk::Pool<lvk::Texture, lvk::vulkan::VulkanTexture> texturesPool_;
 
   struct DeferredTask {
-    DeferredTask(std::packaged_task<void()>&& task, SubmitHandle handle) : task_(std::move(task)), handle_(handle) {}
+    DeferredTask(std::packaged_task<void()>&& task, std::vector<SubmitHandle>&& handles, std::vector<SubmitHandle>&& handlesCompute) :
+      task_(std::move(task)), handles_(std::move(handles)), handlesCompute_(std::move(handlesCompute)) {}
     std::packaged_task<void()> task_;
-    SubmitHandle handle_;
+    std::vector<SubmitHandle> handles_;
+    std::vector<SubmitHandle> handlesCompute_; // async compute work which might still use the resource
   };
 
   mutable std::deque<DeferredTask> deferredTasks_;
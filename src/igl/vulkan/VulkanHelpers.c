@@ -145,6 +145,25 @@ bool ivkIsHostVisibleSingleHeapMemory(VkPhysicalDevice physDev) {
   return false;
 }
 
+VkDeviceSize ivkGetHostVisibleDeviceLocalHeapSize(VkPhysicalDevice physDev) {
+  VkPhysicalDeviceMemoryProperties memProperties;
+
+  vkGetPhysicalDeviceMemoryProperties(physDev, &memProperties);
+
+  const uint32_t flag = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+  VkDeviceSize heapSize = 0;
+
+  for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+    if ((memProperties.memoryTypes[i].propertyFlags & flag) == flag) {
+      const VkDeviceSize size = memProperties.memoryHeaps[memProperties.memoryTypes[i].heapIndex].size;
+      heapSize = size > heapSize ? size : heapSize;
+    }
+  }
+
+  return heapSize;
+}
+
 uint32_t ivkFindMemoryType(VkPhysicalDevice physDev, uint32_t memoryTypeBits, VkMemoryPropertyFlags flags) {
   VkPhysicalDeviceMemoryProperties memProperties;
   vkGetPhysicalDeviceMemoryProperties(physDev, &memProperties);
@@ -161,6 +180,19 @@ uint32_t ivkFindMemoryType(VkPhysicalDevice physDev, uint32_t memoryTypeBits, Vk
   return 0;
 }
 
+bool ivkHasMemoryType(VkPhysicalDevice physDev, VkMemoryPropertyFlags flags) {
+  VkPhysicalDeviceMemoryProperties memProperties;
+  vkGetPhysicalDeviceMemoryProperties(physDev, &memProperties);
+
+  for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+    if ((memProperties.memoryTypes[i].propertyFlags & flags) == flags) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
 static void ivkAddNext(void* node, const void* next) {
   if (!node || !next) {
     return;
@@ -330,6 +362,7 @@ VkAttachmentReference ivkGetAttachmentReference(uint32_t attachment, VkImageLayo
 }
 
 VkResult ivkCreateDescriptorSetLayout(VkDevice device,
+                                      VkDescriptorSetLayoutCreateFlags flags,
                                       uint32_t numBindings,
                                       const VkDescriptorSetLayoutBinding* bindings,
                                       const VkDescriptorBindingFlags* bindingFlags,
@@ -343,7 +376,7 @@ VkResult ivkCreateDescriptorSetLayout(VkDevice device,
   const VkDescriptorSetLayoutCreateInfo ci = {
       .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
       .pNext = &setLayoutBindingFlagsCI,
-      .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT,
+      .flags = flags,
       .bindingCount = numBindings,
       .pBindings = bindings,
   };
@@ -706,6 +739,31 @@ void ivkImageMemoryBarrier(VkCommandBuffer buffer,
   vkCmdPipelineBarrier(buffer, srcStageMask, dstStageMask, 0, 0, NULL, 0, NULL, 1, &barrier);
 }
 
+void ivkImageOwnershipBarrier(VkCommandBuffer buffer,
+                              VkImage image,
+                              VkAccessFlags srcAccessMask,
+                              VkAccessFlags dstAccessMask,
+                              VkImageLayout oldImageLayout,
+                              VkImageLayout newImageLayout,
+                              VkPipelineStageFlags srcStageMask,
+                              VkPipelineStageFlags dstStageMask,
+                              VkImageSubresourceRange subresourceRange,
+                              uint32_t srcQueueFamilyIndex,
+                              uint32_t dstQueueFamilyIndex) {
+  const VkImageMemoryBarrier barrier = {
+      .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+      .srcAccessMask = srcAccessMask,
+      .dstAccessMask = dstAccessMask,
+      .oldLayout = oldImageLayout,
+      .newLayout = newImageLayout,
+      .srcQueueFamilyIndex = srcQueueFamilyIndex,
+      .dstQueueFamilyIndex = dstQueueFamilyIndex,
+      .image = image,
+      .subresourceRange = subresourceRange,
+  };
+  vkCmdPipelineBarrier(buffer, srcStageMask, dstStageMask, 0, 0, NULL, 0, NULL, 1, &barrier);
+}
+
 void ivkBufferMemoryBarrier(VkCommandBuffer cmdBuffer,
                             VkBuffer buffer,
                             VkAccessFlags srcAccessMask,
@@ -727,6 +785,37 @@ void ivkBufferMemoryBarrier(VkCommandBuffer cmdBuffer,
   vkCmdPipelineBarrier(cmdBuffer, srcStageMask, dstStageMask, 0, 0, NULL, 1, &barrier, 0, NULL);
 }
 
+void ivkMemoryBarrier(VkCommandBuffer cmdBuffer,
+                      VkAccessFlags srcAccessMask,
+                      VkAccessFlags dstAccessMask,
+                      VkPipelineStageFlags srcStageMask,
+                      VkPipelineStageFlags dstStageMask) {
+  const VkMemoryBarrier barrier = {
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+      .srcAccessMask = srcAccessMask,
+      .dstAccessMask = dstAccessMask,
+  };
+  vkCmdPipelineBarrier(cmdBuffer, srcStageMask, dstStageMask, 0, 1, &barrier, 0, NULL, 0, NULL);
+}
+
+void ivkCmdPipelineBarrier2(VkCommandBuffer cmdBuffer,
+                            uint32_t numBufferBarriers,
+                            const VkBufferMemoryBarrier2* bufferBarriers,
+                            uint32_t numImageBarriers,
+                            const VkImageMemoryBarrier2* imageBarriers) {
+  if (!numBufferBarriers && !numImageBarriers) {
+    return;
+  }
+  const VkDependencyInfo dependencyInfo = {
+      .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+      .bufferMemoryBarrierCount = numBufferBarriers,
+      .pBufferMemoryBarriers = bufferBarriers,
+      .imageMemoryBarrierCount = numImageBarriers,
+      .pImageMemoryBarriers = imageBarriers,
+  };
+  vkCmdPipelineBarrier2(cmdBuffer, &dependencyInfo);
+}
+
 void ivkCmdBlitImage(VkCommandBuffer buffer,
                      VkImage srcImage,
                      VkImage dstImage,
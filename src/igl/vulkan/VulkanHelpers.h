@@ -58,9 +58,16 @@ VkResult ivkAllocateMemory(VkPhysicalDevice physDev,
 
 bool ivkIsHostVisibleSingleHeapMemory(VkPhysicalDevice physDev);
 
+/// @brief Returns the size of the largest heap with DEVICE_LOCAL|HOST_VISIBLE|HOST_COHERENT memory (Resizable BAR), or 0
+VkDeviceSize ivkGetHostVisibleDeviceLocalHeapSize(VkPhysicalDevice physDev);
+
 uint32_t ivkFindMemoryType(VkPhysicalDevice physDev, uint32_t memoryTypeBits, VkMemoryPropertyFlags flags);
 
+/// @brief Returns true if the device has a memory type with all the `flags` (i.e. VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+bool ivkHasMemoryType(VkPhysicalDevice physDev, VkMemoryPropertyFlags flags);
+
 VkResult ivkCreateDescriptorSetLayout(VkDevice device,
+                                      VkDescriptorSetLayoutCreateFlags flags,
                                       uint32_t numBindings,
                                       const VkDescriptorSetLayoutBinding* bindings,
                                       const VkDescriptorBindingFlags* bindingFlags,
@@ -185,6 +192,19 @@ void ivkImageMemoryBarrier(VkCommandBuffer buffer,
                            VkPipelineStageFlags dstStageMask,
                            VkImageSubresourceRange subresourceRange);
 
+// queue family ownership transfer: record it on the releasing queue, then with the same parameters on the acquiring queue
+void ivkImageOwnershipBarrier(VkCommandBuffer buffer,
+                              VkImage image,
+                              VkAccessFlags srcAccessMask,
+                              VkAccessFlags dstAccessMask,
+                              VkImageLayout oldImageLayout,
+                              VkImageLayout newImageLayout,
+                              VkPipelineStageFlags srcStageMask,
+                              VkPipelineStageFlags dstStageMask,
+                              VkImageSubresourceRange subresourceRange,
+                              uint32_t srcQueueFamilyIndex,
+                              uint32_t dstQueueFamilyIndex);
+
 void ivkBufferMemoryBarrier(VkCommandBuffer cmdBuffer,
                             VkBuffer buffer,
                             VkAccessFlags srcAccessMask,
@@ -194,6 +214,20 @@ void ivkBufferMemoryBarrier(VkCommandBuffer cmdBuffer,
                             VkPipelineStageFlags srcStageMask,
                             VkPipelineStageFlags dstStageMask);
 
+// a global memory barrier (all resources)
+void ivkMemoryBarrier(VkCommandBuffer cmdBuffer,
+                      VkAccessFlags srcAccessMask,
+                      VkAccessFlags dstAccessMask,
+                      VkPipelineStageFlags srcStageMask,
+                      VkPipelineStageFlags dstStageMask);
+
+// synchronization2: all barriers are recorded with one call; each barrier carries its own stage masks
+void ivkCmdPipelineBarrier2(VkCommandBuffer cmdBuffer,
+                            uint32_t numBufferBarriers,
+                            const VkBufferMemoryBarrier2* bufferBarriers,
+                            uint32_t numImageBarriers,
+                            const VkImageMemoryBarrier2* imageBarriers);
+
 void ivkCmdBlitImage(VkCommandBuffer buffer,
                      VkImage srcImage,
                      VkImage dstImage,
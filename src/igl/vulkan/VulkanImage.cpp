@@ -40,6 +40,18 @@ constexpr auto kHandleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_WIN32_KMT_BIT
 constexpr auto kHandleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_OPAQUE_FD_BIT;
 #endif
 
+constexpr VkAccessFlags2 kWriteAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT |
+                                            VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                                            VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_HOST_WRITE_BIT | VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+bool isCoveredStageMask(VkPipelineStageFlags2 visibleStages, VkPipelineStageFlags2 stages) {
+  return (visibleStages & VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT) || (visibleStages & stages) == stages;
+}
+
+bool isCoveredAccessMask(VkAccessFlags2 visibleAccess, VkAccessFlags2 access) {
+  return (visibleAccess & VK_ACCESS_2_MEMORY_READ_BIT) || (visibleAccess & access) == access;
+}
+
 } // namespace
 
 namespace lvk::vulkan {
@@ -63,6 +75,12 @@ VulkanImage::VulkanImage(const VulkanContext& ctx,
   isDepthFormat_(isDepthFormat(imageFormat)),
   isStencilFormat_(isStencilFormat(imageFormat)) {
   VK_ASSERT(ivkSetDebugObjectName(device_, VK_OBJECT_TYPE_IMAGE, (uint64_t)vkImage_, debugName));
+
+  // the first transition of an acquired image has to be chained with the wait on the acquire semaphore
+  subresourceStates_.push_back({
+      .layout = VK_IMAGE_LAYOUT_UNDEFINED,
+      .stageMask = VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+  });
 }
 
 VulkanImage::VulkanImage(const VulkanContext& ctx,
@@ -100,11 +118,29 @@ VulkanImage::VulkanImage(const VulkanContext& ctx,
   IGL_ASSERT(extent.height > 0);
   IGL_ASSERT(extent.depth > 0);
 
-  const VkImageCreateInfo ci =
-      ivkGetImageCreateInfo(type, imageFormat_, tiling, usageFlags, extent_, levels_, layers_, createFlags, samples);
+  subresourceStates_.resize(size_t(levels_) * layers_);
+
+  VkImageCreateInfo ci = ivkGetImageCreateInfo(type, imageFormat_, tiling, usageFlags, extent_, levels_, layers_, createFlags, samples);
+
+  // storage and sampled images can be accessed by async compute, which does not transfer queue family ownership
+  const std::vector<uint32_t>& queueFamilyIndices = ctx_.concurrentQueueFamilyIndices_;
+  const bool isComputeAccessible =
+      (usageFlags & VK_IMAGE_USAGE_STORAGE_BIT) || ((usageFlags & VK_IMAGE_USAGE_SAMPLED_BIT) && ctx_.immediateCompute_);
+  if (isComputeAccessible && queueFamilyIndices.size() > 1) {
+    ci.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    ci.queueFamilyIndexCount = (uint32_t)queueFamilyIndices.size();
+    ci.pQueueFamilyIndices = queueFamilyIndices.data();
+    isConcurrent_ = true;
+  }
 
   if (IGL_VULKAN_USE_VMA) {
-    vmaAllocInfo_.usage = memFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT ? VMA_MEMORY_USAGE_CPU_TO_GPU : VMA_MEMORY_USAGE_AUTO;
+    if (memFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+      vmaAllocInfo_.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+    } else if (memFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) {
+      vmaAllocInfo_.usage = VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED;
+    } else {
+      vmaAllocInfo_.usage = VMA_MEMORY_USAGE_AUTO;
+    }
     VkResult result = vmaCreateImage((VmaAllocator)ctx_.getVmaAllocator(), &ci, &vmaAllocInfo_, &vkImage_, &vmaAllocation_, nullptr);
 
     if (!IGL_VERIFY(result == VK_SUCCESS)) {
@@ -177,84 +213,146 @@ std::shared_ptr<VulkanImageView> VulkanImage::createImageView(VkImageViewType ty
       ctx_, device_, vkImage_, type, format, aspectMask, baseLevel, numLevels ? numLevels : levels_, baseLayer, numLayers, debugName);
 }
 
-void VulkanImage::transitionLayout(VkCommandBuffer commandBuffer,
+void VulkanImage::transitionLayout(std::vector<VkImageMemoryBarrier2>& barriers,
                                    VkImageLayout newImageLayout,
-                                   VkPipelineStageFlags srcStageMask,
-                                   VkPipelineStageFlags dstStageMask,
-                                   const VkImageSubresourceRange& subresourceRange) const {
+                                   VkPipelineStageFlags2 dstStageMask,
+                                   VkAccessFlags2 dstAccessMask,
+                                   const VkImageSubresourceRange& subresourceRange,
+                                   bool discardContents) const {
   IGL_PROFILER_FUNCTION_COLOR(IGL_PROFILER_COLOR_TRANSITION);
 
-  VkAccessFlags srcAccessMask = 0;
-  VkAccessFlags dstAccessMask = 0;
+  std::lock_guard<std::recursive_mutex> lock(ctx_.resourceStatesMutex_);
 
-  if (imageLayout_ == VK_IMAGE_LAYOUT_UNDEFINED) {
-    // we do not need to wait for any previous operations in this case
-    srcStageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-  }
+  const uint32_t baseLevel = subresourceRange.baseMipLevel;
+  const uint32_t baseLayer = subresourceRange.baseArrayLayer;
+  const uint32_t numLevels =
+      subresourceRange.levelCount == VK_REMAINING_MIP_LEVELS ? levels_ - baseLevel : subresourceRange.levelCount;
+  const uint32_t numLayers =
+      subresourceRange.layerCount == VK_REMAINING_ARRAY_LAYERS ? layers_ - baseLayer : subresourceRange.layerCount;
 
-  switch (srcStageMask) {
-  case VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT:
-  case VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT:
-  case VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT:
-  case VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT:
-  case VK_PIPELINE_STAGE_ALL_COMMANDS_BIT:
-  case VK_PIPELINE_STAGE_TRANSFER_BIT:
-  case VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT:
-    break;
-  default:
-    IGL_ASSERT_MSG(false, "Automatic access mask deduction is not implemented (yet) for this srcStageMask");
-    break;
-  }
+  IGL_ASSERT(baseLevel + numLevels <= levels_);
+  IGL_ASSERT(baseLayer + numLayers <= layers_);
 
-  // once you want to add a new pipeline stage to this block of if's, don't forget to add it to the
-  // switch() statement above
-  if (srcStageMask & VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT) {
-    srcAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-  }
-  if (srcStageMask & VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT) {
-    srcAccessMask |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-  }
-  if (srcStageMask & VK_PIPELINE_STAGE_TRANSFER_BIT) {
-    srcAccessMask |= VK_ACCESS_TRANSFER_WRITE_BIT;
-  }
-  if (srcStageMask & VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT) {
-    srcAccessMask |= VK_ACCESS_SHADER_WRITE_BIT;
-  }
+  const bool isReadOnly = (dstAccessMask & kWriteAccessMask) == 0;
 
-  switch (dstStageMask) {
-  case VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT:
-  case VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT:
-  case VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT:
-  case VK_PIPELINE_STAGE_TRANSFER_BIT:
-  case VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT:
-  case VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT:
-    break;
-  default:
-    IGL_ASSERT_MSG(false, "Automatic access mask deduction is not implemented (yet) for this dstStageMask");
-    break;
-  }
+  // barriers appended by this call can be merged with each other
+  const size_t firstBarrier = barriers.size();
 
-  // once you want to add a new pipeline stage to this block of if's, don't forget to add it to the
-  // switch() statement above
-  if (dstStageMask & VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT) {
-    dstAccessMask |= VK_ACCESS_SHADER_READ_BIT;
-    dstAccessMask |= VK_ACCESS_SHADER_WRITE_BIT;
-  }
-  if (dstStageMask & VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT) {
-    dstAccessMask |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-  }
-  if (dstStageMask & VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT) {
-    dstAccessMask |= VK_ACCESS_SHADER_READ_BIT;
-    dstAccessMask |= VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+  for (uint32_t level = baseLevel; level != baseLevel + numLevels; level++) {
+    for (uint32_t layer = baseLayer; layer != baseLayer + numLayers;) {
+      SubresourceState& state = subresourceStates_[level * layers_ + layer];
+
+      const bool isSameLayout = state.layout == newImageLayout && !discardContents;
+      const bool wasReadOnly = (state.accessMask & kWriteAccessMask) == 0;
+
+      if (isSameLayout && wasReadOnly && isReadOnly && isCoveredStageMask(state.stageMask, dstStageMask) &&
+          isCoveredAccessMask(state.accessMask, dstAccessMask)) {
+        // redundant: no layout change and nothing new to make visible
+        layer++;
+        continue;
+      }
+
+      const SubresourceState oldState = state;
+
+      // a run of layers in the same state is transitioned with one barrier
+      uint32_t numRunLayers = 0;
+      for (; layer + numRunLayers != baseLayer + numLayers; numRunLayers++) {
+        SubresourceState& s = subresourceStates_[level * layers_ + layer + numRunLayers];
+        if (s.layout != oldState.layout || s.stageMask != oldState.stageMask || s.accessMask != oldState.accessMask) {
+          break;
+        }
+        if (isSameLayout && wasReadOnly && isReadOnly) {
+          // read-only accesses in the same layout accumulate: a subsequent write has to wait for all of them
+          s.stageMask |= dstStageMask;
+          s.accessMask |= dstAccessMask;
+        } else {
+          s = {newImageLayout, dstStageMask, dstAccessMask};
+        }
+      }
+
+      const VkImageMemoryBarrier2 barrier = {
+          .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+          .srcStageMask = oldState.stageMask,
+          .srcAccessMask = oldState.accessMask & kWriteAccessMask, // only writes have to be made available
+          .dstStageMask = dstStageMask,
+          .dstAccessMask = dstAccessMask,
+          .oldLayout = discardContents ? VK_IMAGE_LAYOUT_UNDEFINED : oldState.layout,
+          .newLayout = newImageLayout,
+          .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+          .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+          .image = vkImage_,
+          .subresourceRange = VkImageSubresourceRange{subresourceRange.aspectMask, level, 1, layer, numRunLayers},
+      };
+
+      // extend a barrier of the previous mip-level which covers the same layers
+      bool isMerged = false;
+      for (size_t i = firstBarrier; i != barriers.size() && !isMerged; i++) {
+        VkImageMemoryBarrier2& b = barriers[i];
+        const VkImageSubresourceRange& r = b.subresourceRange;
+        if (r.baseMipLevel + r.levelCount == level && r.baseArrayLayer == layer && r.layerCount == numRunLayers &&
+            b.srcStageMask == barrier.srcStageMask && b.srcAccessMask == barrier.srcAccessMask && b.oldLayout == barrier.oldLayout) {
+          b.subresourceRange.levelCount++;
+          isMerged = true;
+        }
+      }
+      if (!isMerged) {
+        barriers.push_back(barrier);
+      }
+
+      layer += numRunLayers;
+    }
   }
-  if (dstStageMask & VK_PIPELINE_STAGE_TRANSFER_BIT) {
-    dstAccessMask |= VK_ACCESS_TRANSFER_READ_BIT;
+}
+
+void VulkanImage::setImageLayout(VkImageLayout layout,
+                                 const VkImageSubresourceRange& subresourceRange,
+                                 VkPipelineStageFlags2 stageMask) const {
+  std::lock_guard<std::recursive_mutex> lock(ctx_.resourceStatesMutex_);
+
+  const uint32_t numLevels =
+      subresourceRange.levelCount == VK_REMAINING_MIP_LEVELS ? levels_ - subresourceRange.baseMipLevel : subresourceRange.levelCount;
+  const uint32_t numLayers =
+      subresourceRange.layerCount == VK_REMAINING_ARRAY_LAYERS ? layers_ - subresourceRange.baseArrayLayer : subresourceRange.layerCount;
+
+  for (uint32_t level = subresourceRange.baseMipLevel; level != subresourceRange.baseMipLevel + numLevels; level++) {
+    for (uint32_t layer = subresourceRange.baseArrayLayer; layer != subresourceRange.baseArrayLayer + numLayers; layer++) {
+      // the barriers which changed the layout made the contents visible
+      subresourceStates_[level * layers_ + layer] = {
+          .layout = layout,
+          .stageMask = stageMask,
+          .accessMask = VK_ACCESS_2_MEMORY_READ_BIT,
+      };
+    }
   }
+}
+
+VkImageLayout VulkanImage::getImageLayout(uint32_t level, uint32_t layer) const {
+  IGL_ASSERT(level < levels_ && layer < layers_);
+
+  std::lock_guard<std::recursive_mutex> lock(ctx_.resourceStatesMutex_);
+
+  return subresourceStates_[level * layers_ + layer].layout;
+}
 
-  ivkImageMemoryBarrier(
-      commandBuffer, vkImage_, srcAccessMask, dstAccessMask, imageLayout_, newImageLayout, srcStageMask, dstStageMask, subresourceRange);
+VkImageLayout VulkanImage::getImageLayout(const VkImageSubresourceRange& subresourceRange) const {
+  const uint32_t numLevels =
+      subresourceRange.levelCount == VK_REMAINING_MIP_LEVELS ? levels_ - subresourceRange.baseMipLevel : subresourceRange.levelCount;
+  const uint32_t numLayers =
+      subresourceRange.layerCount == VK_REMAINING_ARRAY_LAYERS ? layers_ - subresourceRange.baseArrayLayer : subresourceRange.layerCount;
 
-  imageLayout_ = newImageLayout;
+  std::lock_guard<std::recursive_mutex> lock(ctx_.resourceStatesMutex_);
+
+  const VkImageLayout layout = getImageLayout(subresourceRange.baseMipLevel, subresourceRange.baseArrayLayer);
+
+  for (uint32_t level = subresourceRange.baseMipLevel; level != subresourceRange.baseMipLevel + numLevels; level++) {
+    for (uint32_t layer = subresourceRange.baseArrayLayer; layer != subresourceRange.baseArrayLayer + numLayers; layer++) {
+      if (subresourceStates_[level * layers_ + layer].layout != layout) {
+        return VK_IMAGE_LAYOUT_MAX_ENUM;
+      }
+    }
+  }
+
+  return layout;
 }
 
 VkImageAspectFlags VulkanImage::getImageAspectFlags() const {
@@ -298,48 +396,49 @@ void VulkanImage::generateMipmap(VkCommandBuffer commandBuffer) const {
 
   ivkCmdBeginDebugUtilsLabel(commandBuffer, "Generate mipmaps", lvk::Color(1.f, 0.75f, 0.f).toFloatPtr());
 
-  const VkImageLayout originalImageLayout = imageLayout_;
+  const VkImageLayout originalImageLayout = getImageLayout();
 
   IGL_ASSERT(originalImageLayout != VK_IMAGE_LAYOUT_UNDEFINED);
 
+  std::vector<VkImageMemoryBarrier2> barriers;
+
   // 0: Transition the first mip-level - all layers - to VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
-  transitionLayout(commandBuffer,
+  transitionLayout(barriers,
                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                   VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-                   VK_PIPELINE_STAGE_TRANSFER_BIT,
+                   VK_PIPELINE_STAGE_2_BLIT_BIT,
+                   VK_ACCESS_2_TRANSFER_READ_BIT,
                    VkImageSubresourceRange{imageAspectFlags, 0, 1, 0, layers_});
 
-  for (uint32_t layer = 0; layer < layers_; ++layer) {
-    auto mipWidth = (int32_t)extent_.width;
-    auto mipHeight = (int32_t)extent_.height;
-
-    for (uint32_t i = 1; i < levels_; ++i) {
-      // 1: Transition the i-th level to VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
-      //    It will be copied into from the (i-1)-th layer
-      ivkImageMemoryBarrier(commandBuffer,
-                            vkImage_,
-                            0, /* srcAccessMask */
-                            VK_ACCESS_TRANSFER_WRITE_BIT, /* dstAccessMask */
-                            VK_IMAGE_LAYOUT_UNDEFINED, /* oldImageLayout */
-                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, /* newImageLayout */
-                            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, /* srcStageMask */
-                            VK_PIPELINE_STAGE_TRANSFER_BIT, /* dstStageMask */
-                            VkImageSubresourceRange{imageAspectFlags, i, 1, layer, 1});
-
-      const int32_t nextLevelWidth = mipWidth > 1 ? mipWidth / 2 : 1;
-      const int32_t nextLevelHeight = mipHeight > 1 ? mipHeight / 2 : 1;
-
-      const VkOffset3D srcOffsets[2] = {
-          VkOffset3D{0, 0, 0},
-          VkOffset3D{mipWidth, mipHeight, 1},
-      };
-      const VkOffset3D dstOffsets[2] = {
-          VkOffset3D{0, 0, 0},
-          VkOffset3D{nextLevelWidth, nextLevelHeight, 1},
-      };
-
-      // 2: Blit the image from the prev mip-level (i-1) (VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) to
-      // the current mip level (i) (VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+  auto mipWidth = (int32_t)extent_.width;
+  auto mipHeight = (int32_t)extent_.height;
+
+  for (uint32_t i = 1; i < levels_; ++i) {
+    // 1: Transition the i-th level - all layers - to VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+    //    It will be copied into from the (i-1)-th level; batched with the previous level's transition
+    transitionLayout(barriers,
+                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                     VK_PIPELINE_STAGE_2_BLIT_BIT,
+                     VK_ACCESS_2_TRANSFER_WRITE_BIT,
+                     VkImageSubresourceRange{imageAspectFlags, i, 1, 0, layers_},
+                     true);
+    ivkCmdPipelineBarrier2(commandBuffer, 0, nullptr, (uint32_t)barriers.size(), barriers.data());
+    barriers.clear();
+
+    const int32_t nextLevelWidth = mipWidth > 1 ? mipWidth / 2 : 1;
+    const int32_t nextLevelHeight = mipHeight > 1 ? mipHeight / 2 : 1;
+
+    const VkOffset3D srcOffsets[2] = {
+        VkOffset3D{0, 0, 0},
+        VkOffset3D{mipWidth, mipHeight, 1},
+    };
+    const VkOffset3D dstOffsets[2] = {
+        VkOffset3D{0, 0, 0},
+        VkOffset3D{nextLevelWidth, nextLevelHeight, 1},
+    };
+
+    // 2: Blit the image from the prev mip-level (i-1) (VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL) to
+    // the current mip level (i) (VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+    for (uint32_t layer = 0; layer < layers_; ++layer) {
 #if IGL_VULKAN_PRINT_COMMANDS
       LLOGL("%p vkCmdBlitImage()\n", commandBuffer);
 #endif // IGL_VULKAN_PRINT_COMMANDS
@@ -353,38 +452,33 @@ void VulkanImage::generateMipmap(VkCommandBuffer commandBuffer) const {
                       VkImageSubresourceLayers{imageAspectFlags, i - 1, layer, 1},
                       VkImageSubresourceLayers{imageAspectFlags, i, layer, 1},
                       blitFilter);
-
-      // 3: Transition i-th level to VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL as it will be read from in
-      // the next iteration
-      ivkImageMemoryBarrier(commandBuffer,
-                            vkImage_,
-                            VK_ACCESS_TRANSFER_WRITE_BIT, /* srcAccessMask */
-                            VK_ACCESS_TRANSFER_READ_BIT, /* dstAccessMask */
-                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, /* oldImageLayout */
-                            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, /* newImageLayout */
-                            VK_PIPELINE_STAGE_TRANSFER_BIT, /* srcStageMask */
-                            VK_PIPELINE_STAGE_TRANSFER_BIT /* dstStageMask */,
-                            VkImageSubresourceRange{imageAspectFlags, i, 1, layer, 1});
-
-      // Compute the size of the next mip level
-      mipWidth = nextLevelWidth;
-      mipHeight = nextLevelHeight;
     }
+
+    // 3: Transition i-th level to VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL as it will be read from in
+    // the next iteration
+    transitionLayout(barriers,
+                     VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                     VK_PIPELINE_STAGE_2_BLIT_BIT,
+                     VK_ACCESS_2_TRANSFER_READ_BIT,
+                     VkImageSubresourceRange{imageAspectFlags, i, 1, 0, layers_});
+
+    // Compute the size of the next mip level
+    mipWidth = nextLevelWidth;
+    mipHeight = nextLevelHeight;
   }
 
+  ivkCmdPipelineBarrier2(commandBuffer, 0, nullptr, (uint32_t)barriers.size(), barriers.data());
+  barriers.clear();
+
   // 4: Transition all levels and layers/faces to their final layout
-  ivkImageMemoryBarrier(commandBuffer,
-                        vkImage_,
-                        VK_ACCESS_TRANSFER_WRITE_BIT, // srcAccessMask
-                        0, // dstAccessMask
-                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, // oldImageLayout
-                        originalImageLayout, // newImageLayout
-                        VK_PIPELINE_STAGE_TRANSFER_BIT, // srcStageMask
-                        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, // dstStageMask
-                        VkImageSubresourceRange{imageAspectFlags, 0, levels_, 0, layers_});
-  ivkCmdEndDebugUtilsLabel(commandBuffer);
+  transitionLayout(barriers,
+                   originalImageLayout,
+                   VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+                   VK_ACCESS_2_MEMORY_READ_BIT,
+                   VkImageSubresourceRange{imageAspectFlags, 0, levels_, 0, layers_});
+  ivkCmdPipelineBarrier2(commandBuffer, 0, nullptr, (uint32_t)barriers.size(), barriers.data());
 
-  imageLayout_ = originalImageLayout;
+  ivkCmdEndDebugUtilsLabel(commandBuffer);
 }
 
 bool VulkanImage::isDepthFormat(VkFormat format) {
@@ -8,9 +8,11 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include <igl/vulkan/Common.h>
 #include <igl/vulkan/VulkanHelpers.h>
+#include <igl/vulkan/VulkanImmediateCommands.h>
 #include <lvk/vulkan/VulkanUtils.h>
 
 namespace lvk {
@@ -70,6 +72,11 @@ class VulkanImage final {
     return (usageFlags_ & VK_IMAGE_USAGE_STORAGE_BIT) > 0;
   }
 
+  // memoryless: the contents exist only while rendering and cannot be loaded, stored, sampled or copied
+  bool isTransientAttachment() const {
+    return (usageFlags_ & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) > 0;
+  }
+
   /**
    * @brief Creates a `VkImageView` object from the `VkImage` stored in the object.
    *
@@ -88,18 +95,31 @@ class VulkanImage final {
   void generateMipmap(VkCommandBuffer commandBuffer) const;
 
   /**
-   * @brief Transitions the `VkImage`'s layout from the current layout (stored in the object) to the
-   * `newImageLayout` by recording an Image Memory Barrier into the commandBuffer.
+   * @brief Appends image memory barriers which transition the subresources in `subresourceRange` into
+   * `newImageLayout` for the accesses described by `dstStageMask` and `dstAccessMask`.
    *
-   * The source and destination access masks for the transition are automatically deduced based on
-   * the `srcStageMask` and the `dstStageMask` parameters. Not not all `VkPipelineStageFlags` are
-   * supported.
+   * The source stages and accesses are taken from the tracked state of every mip-level and layer. Subresources
+   * which are already in `newImageLayout` and were made visible to these read-only accesses are skipped.
+   * Set `discardContents` if the previous contents of the subresources are not needed.
    */
-  void transitionLayout(VkCommandBuffer commandBuffer,
+  void transitionLayout(std::vector<VkImageMemoryBarrier2>& barriers,
                         VkImageLayout newImageLayout,
-                        VkPipelineStageFlags srcStageMask,
-                        VkPipelineStageFlags dstStageMask,
-                        const VkImageSubresourceRange& subresourceRange) const;
+                        VkPipelineStageFlags2 dstStageMask,
+                        VkAccessFlags2 dstAccessMask,
+                        const VkImageSubresourceRange& subresourceRange,
+                        bool discardContents = false) const;
+
+  /**
+   * @brief Updates the tracked layout of `subresourceRange` after it was changed by barriers recorded elsewhere (i.e.
+   * uploads). Subsequent transitions wait for `stageMask`.
+   */
+  void setImageLayout(VkImageLayout layout,
+                      const VkImageSubresourceRange& subresourceRange,
+                      VkPipelineStageFlags2 stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT) const;
+
+  VkImageLayout getImageLayout(uint32_t level = 0, uint32_t layer = 0) const;
+  // returns VK_IMAGE_LAYOUT_MAX_ENUM if the subresources are in different layouts
+  VkImageLayout getImageLayout(const VkImageSubresourceRange& subresourceRange) const;
 
   VkImageAspectFlags getImageAspectFlags() const;
 
@@ -126,7 +146,19 @@ class VulkanImage final {
   VkSampleCountFlagBits samples_ = VK_SAMPLE_COUNT_1_BIT;
   bool isDepthFormat_ = false;
   bool isStencilFormat_ = false;
-  mutable VkImageLayout imageLayout_ = VK_IMAGE_LAYOUT_UNDEFINED; // current image layout
+  bool isConcurrent_ = false; // VK_SHARING_MODE_CONCURRENT: no queue family ownership transfers
+
+  // the last known state of every subresource; all aspects of a subresource are tracked together
+  struct SubresourceState {
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags2 stageMask = VK_PIPELINE_STAGE_2_NONE; // subsequent barriers wait for these stages...
+    VkAccessFlags2 accessMask = VK_ACCESS_2_NONE; // ...and these accesses (writes are made available)
+  };
+  // guarded by VulkanContext::resourceStatesMutex_: command buffers recorded on different threads can transition the image
+  mutable std::vector<SubresourceState> subresourceStates_; // [level * layers_ + layer]
+  // the last command buffer which transitioned the image; Device::submit() checks the submission order against it
+  mutable const VulkanImmediateCommands* lastRecorderQueue_ = nullptr;
+  mutable VulkanImmediateCommands::SubmitHandle lastRecorder_ = {};
 };
 
 } // namespace vulkan
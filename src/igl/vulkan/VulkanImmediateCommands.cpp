@@ -10,6 +10,8 @@
 #include <igl/vulkan/Common.h>
 #include <lvk/vulkan/VulkanUtils.h>
 
+#include <algorithm>
+#include <thread>
 #include <utility>
 
 namespace lvk {
@@ -21,31 +23,39 @@ VulkanImmediateCommands::VulkanImmediateCommands(VkDevice device, uint32_t queue
 
   vkGetDeviceQueue(device, queueFamilyIndex, 0, &queue_);
 
+  {
+    char timelineName[256] = {0};
+    if (debugName) {
+      snprintf(timelineName, sizeof(timelineName) - 1, "Semaphore: %s (timeline)", debugName);
+    }
+    timelineSemaphore_ = lvk::createSemaphoreTimeline(device, 0, timelineName);
+  }
+
+  // every command buffer has its own command pool: command buffers can be recorded on different threads while
+  // the submitting thread recycles other ones, and a VkCommandPool must be externally synchronized
   const VkCommandPoolCreateInfo ci = {
       .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-      .flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+      .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
       .queueFamilyIndex = queueFamilyIndex,
   };
-  VK_ASSERT(vkCreateCommandPool(device, &ci, nullptr, &commandPool_));
-  ivkSetDebugObjectName(device, VK_OBJECT_TYPE_COMMAND_POOL, (uint64_t)commandPool_, debugName);
-
-  const VkCommandBufferAllocateInfo ai = {
-      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
-      .commandPool = commandPool_,
-      .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
-      .commandBufferCount = 1,
-  };
 
   for (uint32_t i = 0; i != kMaxCommandBuffers; i++) {
     auto& buf = buffers_[i];
-    char fenceName[256] = {0};
     char semaphoreName[256] = {0};
+    char poolName[256] = {0};
     if (debugName) {
-      snprintf(fenceName, sizeof(fenceName) - 1, "Fence: %s (cmdbuf %u)", debugName, i);
       snprintf(semaphoreName, sizeof(semaphoreName) - 1, "Semaphore: %s (cmdbuf %u)", debugName, i);
+      snprintf(poolName, sizeof(poolName) - 1, "Command Pool: %s (cmdbuf %u)", debugName, i);
     }
     buf.semaphore_ = lvk::createSemaphore(device, semaphoreName);
-    buf.fence_ = lvk::createFence(device, fenceName);
+    VK_ASSERT(vkCreateCommandPool(device, &ci, nullptr, &buf.commandPool_));
+    ivkSetDebugObjectName(device, VK_OBJECT_TYPE_COMMAND_POOL, (uint64_t)buf.commandPool_, poolName);
+    const VkCommandBufferAllocateInfo ai = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        .commandPool = buf.commandPool_,
+        .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+        .commandBufferCount = 1,
+    };
     VK_ASSERT(vkAllocateCommandBuffers(device, &ai, &buf.cmdBufAllocated_));
     buffers_[i].handle_.bufferIndex_ = i;
   }
@@ -56,42 +66,52 @@ VulkanImmediateCommands::~VulkanImmediateCommands() {
 
   waitAll();
 
+  // lifetimes of all VkSemaphore objects are managed explicitly
+  // we do not use deferredTask() for them
   for (auto& buf : buffers_) {
-    // lifetimes of all VkFence objects are managed explicitly
-    // we do not use deferredTask() for them
-    vkDestroyFence(device_, buf.fence_, nullptr);
     vkDestroySemaphore(device_, buf.semaphore_, nullptr);
+    vkDestroyCommandPool(device_, buf.commandPool_, nullptr);
   }
-
-  vkDestroyCommandPool(device_, commandPool_, nullptr);
+  vkDestroySemaphore(device_, timelineSemaphore_, nullptr);
 }
 
 void VulkanImmediateCommands::purge() {
   IGL_PROFILER_FUNCTION();
 
+  VK_ASSERT(vkGetSemaphoreCounterValue(device_, timelineSemaphore_, &lastCompletedValue_));
+
   for (auto& buf : buffers_) {
     if (buf.cmdBuf_ == VK_NULL_HANDLE || buf.isEncoding_) {
       continue;
     }
 
-    const VkResult result = vkWaitForFences(device_, 1, &buf.fence_, VK_TRUE, 0);
-
-    if (result == VK_SUCCESS) {
-      VK_ASSERT(vkResetCommandBuffer(buf.cmdBuf_, VkCommandBufferResetFlags{0}));
-      VK_ASSERT(vkResetFences(device_, 1, &buf.fence_));
+    if (buf.timelineValue_ <= lastCompletedValue_) {
+      VK_ASSERT(vkResetCommandPool(device_, buf.commandPool_, VkCommandPoolResetFlags{0}));
       buf.cmdBuf_ = VK_NULL_HANDLE;
       numAvailableCommandBuffers_++;
-    } else {
-      if (result != VK_TIMEOUT) {
-        VK_ASSERT(result);
-      }
     }
   }
+
+  std::erase_if(submittedValues_, [completed = lastCompletedValue_](const auto& p) { return p.second <= completed; });
+}
+
+void VulkanImmediateCommands::waitTimelineValue(uint64_t value) {
+  IGL_PROFILER_FUNCTION_COLOR(IGL_PROFILER_COLOR_WAIT);
+
+  const VkSemaphoreWaitInfo waitInfo = {
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+      .semaphoreCount = 1,
+      .pSemaphores = &timelineSemaphore_,
+      .pValues = &value,
+  };
+  VK_ASSERT(vkWaitSemaphores(device_, &waitInfo, UINT64_MAX));
 }
 
 const VulkanImmediateCommands::CommandBufferWrapper& VulkanImmediateCommands::acquire() {
   IGL_PROFILER_FUNCTION();
 
+  std::unique_lock<std::mutex> lock(mutex_);
+
   if (!numAvailableCommandBuffers_) {
     purge();
   }
@@ -99,6 +119,10 @@ const VulkanImmediateCommands::CommandBufferWrapper& VulkanImmediateCommands::ac
   while (!numAvailableCommandBuffers_) {
     LLOGL("Waiting for command buffers...\n");
     IGL_PROFILER_ZONE("Waiting for command buffers...", IGL_PROFILER_COLOR_WAIT);
+    // let other threads submit their command buffers
+    lock.unlock();
+    std::this_thread::yield();
+    lock.lock();
     purge();
     IGL_PROFILER_ZONE_END();
   }
@@ -122,6 +146,7 @@ const VulkanImmediateCommands::CommandBufferWrapper& VulkanImmediateCommands::ac
 
   current->handle_.submitId_ = submitCounter_;
   numAvailableCommandBuffers_--;
+  nextSubmitHandle_ = current->handle_;
 
   current->cmdBuf_ = current->cmdBufAllocated_;
   current->isEncoding_ = true;
@@ -135,17 +160,24 @@ const VulkanImmediateCommands::CommandBufferWrapper& VulkanImmediateCommands::ac
 }
 
 void VulkanImmediateCommands::wait(const SubmitHandle handle) {
-  if (isReady(handle)) {
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  if (isReadyImpl(handle, false)) {
     return;
   }
 
-  if (!IGL_VERIFY(!buffers_[handle.bufferIndex_].isEncoding_)) {
+  uint64_t value = 0;
+
+  if (!IGL_VERIFY(getTimelineValue(handle, value))) {
     // we are waiting for a buffer which has not been submitted - this is probably a logic error
     // somewhere in the calling code
     return;
   }
 
-  VK_ASSERT(vkWaitForFences(device_, 1, &buffers_[handle.bufferIndex_].fence_, VK_TRUE, UINT64_MAX));
+  // do not block other threads while waiting on the GPU
+  lock.unlock();
+  waitTimelineValue(value);
+  lock.lock();
 
   purge();
 }
@@ -153,91 +185,178 @@ void VulkanImmediateCommands::wait(const SubmitHandle handle) {
 void VulkanImmediateCommands::waitAll() {
   IGL_PROFILER_FUNCTION_COLOR(IGL_PROFILER_COLOR_WAIT);
 
-  // @lint-ignore CLANGTIDY
-  VkFence fences[kMaxCommandBuffers];
-
-  uint32_t numFences = 0;
+  std::unique_lock<std::mutex> lock(mutex_);
 
-  for (const auto& buf : buffers_) {
-    if (buf.cmdBuf_ != VK_NULL_HANDLE && !buf.isEncoding_) {
-      fences[numFences++] = buf.fence_;
-    }
-  }
+  // all submitted command buffers signal values up to lastSignaledValue_
+  const uint64_t value = lastSignaledValue_;
 
-  if (numFences) {
-    VK_ASSERT(vkWaitForFences(device_, numFences, fences, VK_TRUE, UINT64_MAX));
+  if (value) {
+    lock.unlock();
+    waitTimelineValue(value);
+    lock.lock();
   }
 
   purge();
 }
 
 bool VulkanImmediateCommands::isReady(const SubmitHandle handle, bool fastCheckNoVulkan) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  return isReadyImpl(handle, fastCheckNoVulkan);
+}
+
+bool VulkanImmediateCommands::isEncoding(const SubmitHandle handle) const {
   IGL_ASSERT(handle.bufferIndex_ < kMaxCommandBuffers);
 
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  const CommandBufferWrapper& buf = buffers_[handle.bufferIndex_];
+
+  return !handle.empty() && buf.isEncoding_ && buf.handle_.submitId_ == handle.submitId_;
+}
+
+void VulkanImmediateCommands::getEncodingHandles(std::vector<SubmitHandle>& handles) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  for (const auto& buf : buffers_) {
+    if (buf.isEncoding_) {
+      handles.push_back(buf.handle_);
+    }
+  }
+}
+
+bool VulkanImmediateCommands::getTimelineValue(const SubmitHandle handle, uint64_t& value) const {
+  IGL_ASSERT(handle.bufferIndex_ < kMaxCommandBuffers);
+
+  const CommandBufferWrapper& buf = buffers_[handle.bufferIndex_];
+
+  // a command buffer slot cannot be reused while it is being recorded
+  if (buf.isEncoding_ && buf.handle_.submitId_ == handle.submitId_) {
+    return false;
+  }
+
+  const auto it = submittedValues_.find(handle.submitId_);
+
+  value = it != submittedValues_.end() ? it->second : 0;
+
+  return true;
+}
+
+bool VulkanImmediateCommands::isReadyImpl(const SubmitHandle handle, bool fastCheckNoVulkan) const {
   if (handle.empty()) {
     // a null handle
     return true;
   }
 
-  const CommandBufferWrapper& buf = buffers_[handle.bufferIndex_];
+  uint64_t value = 0;
 
-  if (buf.cmdBuf_ == VK_NULL_HANDLE) {
-    // already recycled and not yet reused
-    return true;
+  if (!getTimelineValue(handle, value)) {
+    // not submitted yet
+    return false;
   }
 
-  if (buf.handle_.submitId_ != handle.submitId_) {
-    // already recycled and reused by another command buffer
+  if (value <= lastCompletedValue_) {
     return true;
   }
 
   if (fastCheckNoVulkan) {
-    // do not ask the Vulkan API about it, just let it retire naturally (when submitId for this
-    // bufferIndex gets incremented)
+    // do not ask the Vulkan API about it, just let it retire naturally (when purge() observes a newer timeline value)
     return false;
   }
 
-  return vkWaitForFences(device_, 1, &buf.fence_, VK_TRUE, 0) == VK_SUCCESS;
+  uint64_t completedValue = 0;
+  VK_ASSERT(vkGetSemaphoreCounterValue(device_, timelineSemaphore_, &completedValue));
+
+  return value <= completedValue;
+}
+
+VulkanImmediateCommands::SubmitHandle VulkanImmediateCommands::submit(const CommandBufferWrapper& wrapper, bool signalSemaphore) {
+  const CommandBufferWrapper* wrappers[] = {&wrapper};
+
+  return submit(wrappers, 1u, signalSemaphore);
 }
 
-VulkanImmediateCommands::SubmitHandle VulkanImmediateCommands::submit(const CommandBufferWrapper& wrapper) {
+VulkanImmediateCommands::SubmitHandle VulkanImmediateCommands::submit(const CommandBufferWrapper* const* wrappers,
+                                                                      uint32_t numWrappers,
+                                                                      bool signalSemaphore) {
   IGL_PROFILER_FUNCTION_COLOR(IGL_PROFILER_COLOR_SUBMIT);
-  IGL_ASSERT(wrapper.isEncoding_);
-  VK_ASSERT(vkEndCommandBuffer(wrapper.cmdBuf_));
-
-  const VkPipelineStageFlags waitStageMasks[] = {VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT};
-  VkSemaphore waitSemaphores[] = {VK_NULL_HANDLE, VK_NULL_HANDLE};
-  uint32_t numWaitSemaphores = 0;
-  if (waitSemaphore_) {
-    waitSemaphores[numWaitSemaphores++] = waitSemaphore_;
-  }
-  if (lastSubmitSemaphore_) {
-    waitSemaphores[numWaitSemaphores++] = lastSubmitSemaphore_;
+  IGL_ASSERT(numWrappers > 0 && numWrappers <= kMaxCommandBuffers);
+
+  VkCommandBufferSubmitInfo cmdBufInfos[kMaxCommandBuffers];
+
+  for (uint32_t i = 0; i != numWrappers; i++) {
+    IGL_ASSERT(wrappers[i]->isEncoding_);
+    VK_ASSERT(vkEndCommandBuffer(wrappers[i]->cmdBuf_));
+    cmdBufInfos[i] = {
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO,
+        .commandBuffer = wrappers[i]->cmdBuf_,
+    };
   }
 
-  IGL_PROFILER_ZONE("vkQueueSubmit()", IGL_PROFILER_COLOR_SUBMIT);
+  // vkQueueSubmit2() requires external synchronization of the queue
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // the whole batch completes at once
+  const uint64_t timelineValue = ++lastSignaledValue_;
+
+  const CommandBufferWrapper& last = *wrappers[numWrappers - 1];
+
+  const VkSemaphoreSubmitInfo signalSemaphores[] = {
+      {
+          .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+          .semaphore = timelineSemaphore_,
+          .value = timelineValue,
+          .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+      },
+      {
+          .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+          .semaphore = last.semaphore_,
+          .stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+      },
+  };
+
+  IGL_PROFILER_ZONE("vkQueueSubmit2()", IGL_PROFILER_COLOR_SUBMIT);
 #if IGL_VULKAN_PRINT_COMMANDS
-  LLOGL("%p vkQueueSubmit()\n\n", wrapper.cmdBuf_);
+  for (uint32_t i = 0; i != numWrappers; i++) {
+    LLOGL("%p vkQueueSubmit2()\n\n", wrappers[i]->cmdBuf_);
+  }
 #endif // IGL_VULKAN_PRINT_COMMANDS
-  const VkSubmitInfo si = {
-      .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-      .waitSemaphoreCount = numWaitSemaphores,
-      .pWaitSemaphores = waitSemaphores,
-      .pWaitDstStageMask = waitStageMasks,
-      .commandBufferCount = 1u,
-      .pCommandBuffers = &wrapper.cmdBuf_,
-      .signalSemaphoreCount = 1u,
-      .pSignalSemaphores = &wrapper.semaphore_,
+  const VkSubmitInfo2 si = {
+      .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2,
+      .waitSemaphoreInfoCount = (uint32_t)waitSemaphores_.size(),
+      .pWaitSemaphoreInfos = waitSemaphores_.data(),
+      .commandBufferInfoCount = numWrappers,
+      .pCommandBufferInfos = cmdBufInfos,
+      .signalSemaphoreInfoCount = signalSemaphore ? 2u : 1u,
+      .pSignalSemaphoreInfos = signalSemaphores,
   };
-  VK_ASSERT(vkQueueSubmit(queue_, 1u, &si, wrapper.fence_));
+  VK_ASSERT(vkQueueSubmit2(queue_, 1u, &si, VK_NULL_HANDLE));
   IGL_PROFILER_ZONE_END();
 
-  lastSubmitSemaphore_ = wrapper.semaphore_;
-  lastSubmitHandle_ = wrapper.handle_;
-  waitSemaphore_ = VK_NULL_HANDLE;
+  lastSubmitSemaphore_ = signalSemaphore ? last.semaphore_ : VK_NULL_HANDLE;
+  lastSubmitHandle_ = last.handle_;
+  waitSemaphores_.clear();
+
+  bool isNextSubmitHandleSubmitted = false;
 
-  // reset
-  const_cast<CommandBufferWrapper&>(wrapper).isEncoding_ = false;
+  for (uint32_t i = 0; i != numWrappers; i++) {
+    CommandBufferWrapper& buf = const_cast<CommandBufferWrapper&>(*wrappers[i]);
+    buf.timelineValue_ = timelineValue;
+    submittedValues_[buf.handle_.submitId_] = timelineValue;
+    // reset
+    buf.isEncoding_ = false;
+    isNextSubmitHandleSubmitted |= nextSubmitHandle_.handle() == buf.handle_.handle();
+  }
+
+  if (isNextSubmitHandleSubmitted) {
+    // another command buffer might still be encoding (i.e. a helper submit while a frame is being recorded)
+    nextSubmitHandle_ = SubmitHandle();
+    for (const auto& b : buffers_) {
+      if (b.isEncoding_) {
+        nextSubmitHandle_ = b.handle_;
+      }
+    }
+  }
   submitCounter_++;
 
   if (!submitCounter_) {
@@ -248,19 +367,67 @@ VulkanImmediateCommands::SubmitHandle VulkanImmediateCommands::submit(const Comm
   return lastSubmitHandle_;
 }
 
-void VulkanImmediateCommands::waitSemaphore(VkSemaphore semaphore) {
-  IGL_ASSERT(waitSemaphore_ == VK_NULL_HANDLE);
+void VulkanImmediateCommands::waitSemaphore(VkSemaphore semaphore, VkPipelineStageFlags2 stageMask) {
+  IGL_ASSERT(semaphore != VK_NULL_HANDLE);
+
+  std::lock_guard<std::mutex> lock(mutex_);
 
-  waitSemaphore_ = semaphore;
+  waitSemaphores_.push_back({
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+      .semaphore = semaphore,
+      .stageMask = stageMask,
+  });
+}
+
+void VulkanImmediateCommands::waitTimelineSemaphore(VkSemaphore semaphore, uint64_t value, VkPipelineStageFlags2 stageMask) {
+  IGL_ASSERT(semaphore != VK_NULL_HANDLE);
+
+  if (!value) {
+    // nothing has been signaled yet
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  for (VkSemaphoreSubmitInfo& info : waitSemaphores_) {
+    if (info.semaphore == semaphore) {
+      info.value = std::max(info.value, value);
+      info.stageMask |= stageMask;
+      return;
+    }
+  }
+
+  waitSemaphores_.push_back({
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO,
+      .semaphore = semaphore,
+      .value = value,
+      .stageMask = stageMask,
+  });
+}
+
+uint64_t VulkanImmediateCommands::getLastSignaledValue() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  return lastSignaledValue_;
 }
 
 VkSemaphore VulkanImmediateCommands::acquireLastSubmitSemaphore() {
+  std::lock_guard<std::mutex> lock(mutex_);
+
   return std::exchange(lastSubmitSemaphore_, VK_NULL_HANDLE);
 }
 
 VulkanImmediateCommands::SubmitHandle VulkanImmediateCommands::getLastSubmitHandle() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
   return lastSubmitHandle_;
 }
 
+VulkanImmediateCommands::SubmitHandle VulkanImmediateCommands::getNextSubmitHandle() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  return nextSubmitHandle_.empty() ? lastSubmitHandle_ : nextSubmitHandle_;
+}
+
 } // namespace vulkan
 } // namespace lvk
@@ -7,12 +7,17 @@
 
 #pragma once
 
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 #include <igl/vulkan/Common.h>
 #include <igl/vulkan/VulkanHelpers.h>
 
 namespace lvk {
 namespace vulkan {
 
+// thread-safe: command buffers can be acquired and recorded on different threads; each one has its own VkCommandPool
 class VulkanImmediateCommands final {
  public:
   // the maximum number of command buffers which can similtaneously exist in the system; when we run
@@ -24,6 +29,8 @@ class VulkanImmediateCommands final {
   VulkanImmediateCommands(const VulkanImmediateCommands&) = delete;
   VulkanImmediateCommands& operator=(const VulkanImmediateCommands&) = delete;
 
+  // `submitId_` identifies the submit uniquely; once submitted, it is resolved to the timeline value the submit signals, so
+  // the completion of a handle does not depend on whether its command buffer slot has been reused
   struct SubmitHandle {
     uint32_t bufferIndex_ = 0;
     uint32_t submitId_ = 0;
@@ -44,35 +51,66 @@ class VulkanImmediateCommands final {
   struct CommandBufferWrapper {
     VkCommandBuffer cmdBuf_ = VK_NULL_HANDLE;
     VkCommandBuffer cmdBufAllocated_ = VK_NULL_HANDLE;
+    VkCommandPool commandPool_ = VK_NULL_HANDLE; // owns cmdBufAllocated_ only
     SubmitHandle handle_ = {};
-    VkFence fence_ = VK_NULL_HANDLE;
+    uint64_t timelineValue_ = 0; // the value timelineSemaphore_ reaches when this command buffer has finished executing
     VkSemaphore semaphore_ = VK_NULL_HANDLE;
     bool isEncoding_ = false;
   };
 
   // returns the current command buffer (creates one if it does not exist)
   const CommandBufferWrapper& acquire();
-  SubmitHandle submit(const CommandBufferWrapper& wrapper);
-  void waitSemaphore(VkSemaphore semaphore);
+  // submits are not chained with semaphores: command buffers on the same queue are ordered by their pipeline barriers;
+  // `signalSemaphore` signals a binary semaphore which can be retrieved with acquireLastSubmitSemaphore() (i.e. for present)
+  SubmitHandle submit(const CommandBufferWrapper& wrapper, bool signalSemaphore = false);
+  // submits an ordered batch of command buffers with a single vkQueueSubmit2() call; returns the handle of the last one
+  SubmitHandle submit(const CommandBufferWrapper* const* wrappers, uint32_t numWrappers, bool signalSemaphore = false);
+  // the next submit waits for the binary semaphore in the specified stages
+  void waitSemaphore(VkSemaphore semaphore, VkPipelineStageFlags2 stageMask);
+  // the next submit waits until the timeline semaphore (i.e. of another queue) reaches the value
+  void waitTimelineSemaphore(VkSemaphore semaphore, uint64_t value, VkPipelineStageFlags2 stageMask);
+  VkSemaphore getTimelineSemaphore() const {
+    return timelineSemaphore_;
+  }
+  uint64_t getLastSignaledValue() const;
   VkSemaphore acquireLastSubmitSemaphore();
   SubmitHandle getLastSubmitHandle() const;
+  // the handle of the most recently acquired command buffer (which is going to be submitted last)
+  SubmitHandle getNextSubmitHandle() const;
   bool isReady(SubmitHandle handle, bool fastCheckNoVulkan = false) const;
+  // true if the command buffer has been acquired but not yet submitted
+  bool isEncoding(SubmitHandle handle) const;
+  // appends the handles of all command buffers which are currently being recorded (possibly on other threads)
+  void getEncodingHandles(std::vector<SubmitHandle>& handles) const;
   void wait(SubmitHandle handle);
   void waitAll();
 
  private:
+  // these require mutex_ to be locked
   void purge();
+  bool isReadyImpl(SubmitHandle handle, bool fastCheckNoVulkan) const;
+  // returns false if the handle has not been submitted yet; 0 means the submit has completed and was forgotten by purge()
+  bool getTimelineValue(SubmitHandle handle, uint64_t& value) const;
+  // does not require the lock
+  void waitTimelineValue(uint64_t value);
 
  private:
   VkDevice device_ = VK_NULL_HANDLE;
   VkQueue queue_ = VK_NULL_HANDLE;
-  VkCommandPool commandPool_ = VK_NULL_HANDLE;
+  mutable std::mutex mutex_;
   uint32_t queueFamilyIndex_ = 0;
   const char* debugName_ = "";
   CommandBufferWrapper buffers_[kMaxCommandBuffers];
+  // signaled by every submit with a monotonically increasing value; replaces per-command-buffer fences
+  VkSemaphore timelineSemaphore_ = VK_NULL_HANDLE;
+  uint64_t lastSignaledValue_ = 0;
+  uint64_t lastCompletedValue_ = 0; // cached by purge()
+  // submitId -> timeline value signaled by that submit; completed submits are removed by purge()
+  std::unordered_map<uint32_t, uint64_t> submittedValues_;
   SubmitHandle lastSubmitHandle_ = SubmitHandle();
-  VkSemaphore lastSubmitSemaphore_ = VK_NULL_HANDLE;
-  VkSemaphore waitSemaphore_ = VK_NULL_HANDLE;
+  SubmitHandle nextSubmitHandle_ = SubmitHandle();
+  VkSemaphore lastSubmitSemaphore_ = VK_NULL_HANDLE; // signaled only if requested by submit()
+  std::vector<VkSemaphoreSubmitInfo> waitSemaphores_; // consumed by the next submit
   uint32_t numAvailableCommandBuffers_ = kMaxCommandBuffers;
   uint32_t submitCounter_ = 1;
 };
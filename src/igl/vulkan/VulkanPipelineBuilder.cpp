@@ -10,7 +10,7 @@
 namespace lvk {
 namespace vulkan {
 
-uint32_t VulkanPipelineBuilder::numPipelinesCreated_ = 0;
+std::atomic<uint32_t> VulkanPipelineBuilder::numPipelinesCreated_ = 0;
 
 VulkanPipelineBuilder::VulkanPipelineBuilder() :
   vertexInputState_(ivkGetPipelineVertexInputStateCreateInfo_Empty()),
@@ -95,6 +95,11 @@ VulkanPipelineBuilder& VulkanPipelineBuilder::stencilAttachmentFormat(VkFormat f
   return *this;
 }
 
+VulkanPipelineBuilder& VulkanPipelineBuilder::createFlags(VkPipelineCreateFlags flags) {
+  createFlags_ = flags;
+  return *this;
+}
+
 VulkanPipelineBuilder& VulkanPipelineBuilder::shaderStage(VkPipelineShaderStageCreateInfo stage) {
   shaderStages_.push_back(stage);
   return *this;
@@ -127,21 +132,16 @@ VulkanPipelineBuilder& VulkanPipelineBuilder::stencilStateOps(VkStencilFaceFlags
   return *this;
 }
 
-VkResult VulkanPipelineBuilder::build(VkDevice device,
-                                      VkPipelineCache pipelineCache,
-                                      VkPipelineLayout pipelineLayout,
-                                      VkPipeline* outPipeline,
-                                      const char* debugName) noexcept {
-  const VkPipelineDynamicStateCreateInfo dynamicState =
-      ivkGetPipelineDynamicStateCreateInfo((uint32_t)dynamicStates_.size(), dynamicStates_.data());
+void VulkanPipelineBuilder::fillCreateInfo(CreateInfo& info, VkPipelineLayout pipelineLayout) const {
+  info.dynamicState = ivkGetPipelineDynamicStateCreateInfo((uint32_t)dynamicStates_.size(), dynamicStates_.data());
   // viewport and scissor are always dynamic
-  const VkPipelineViewportStateCreateInfo viewportState = ivkGetPipelineViewportStateCreateInfo(nullptr, nullptr);
-  const VkPipelineColorBlendStateCreateInfo colorBlendState =
+  info.viewportState = ivkGetPipelineViewportStateCreateInfo(nullptr, nullptr);
+  info.colorBlendState =
       ivkGetPipelineColorBlendStateCreateInfo(uint32_t(colorBlendAttachmentStates_.size()), colorBlendAttachmentStates_.data());
 
   IGL_ASSERT(colorAttachmentFormats_.size() == colorBlendAttachmentStates_.size());
 
-  const VkPipelineRenderingCreateInfo renderingInfo = {
+  info.renderingInfo = {
       .sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR,
       .pNext = nullptr,
       .colorAttachmentCount = (uint32_t)colorAttachmentFormats_.size(),
@@ -150,38 +150,66 @@ VkResult VulkanPipelineBuilder::build(VkDevice device,
       .stencilAttachmentFormat = stencilAttachmentFormat_,
   };
 
-  const VkGraphicsPipelineCreateInfo ci = {
+  info.ci = {
       .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-      .pNext = &renderingInfo,
-      .flags = 0,
+      .pNext = &info.renderingInfo,
+      .flags = createFlags_,
       .stageCount = (uint32_t)shaderStages_.size(),
       .pStages = shaderStages_.data(),
       .pVertexInputState = &vertexInputState_,
       .pInputAssemblyState = &inputAssembly_,
       .pTessellationState = nullptr,
-      .pViewportState = &viewportState,
+      .pViewportState = &info.viewportState,
       .pRasterizationState = &rasterizationState_,
       .pMultisampleState = &multisampleState_,
       .pDepthStencilState = &depthStencilState_,
-      .pColorBlendState = &colorBlendState,
-      .pDynamicState = &dynamicState,
+      .pColorBlendState = &info.colorBlendState,
+      .pDynamicState = &info.dynamicState,
       .layout = pipelineLayout,
       .renderPass = VK_NULL_HANDLE,
       .subpass = 0,
       .basePipelineHandle = VK_NULL_HANDLE,
       .basePipelineIndex = -1,
   };
+}
+
+VkResult VulkanPipelineBuilder::build(VkDevice device,
+                                      VkPipelineCache pipelineCache,
+                                      VkPipelineLayout pipelineLayout,
+                                      VkPipeline* outPipeline,
+                                      const char* debugName) noexcept {
+  return build(device, pipelineCache, pipelineLayout, this, 1, outPipeline, debugName);
+}
+
+VkResult VulkanPipelineBuilder::build(VkDevice device,
+                                      VkPipelineCache pipelineCache,
+                                      VkPipelineLayout pipelineLayout,
+                                      const VulkanPipelineBuilder* builders,
+                                      uint32_t numBuilders,
+                                      VkPipeline* outPipelines,
+                                      const char* debugName) noexcept {
+  IGL_ASSERT(builders && numBuilders);
+
+  std::vector<CreateInfo> infos(numBuilders);
+  std::vector<VkGraphicsPipelineCreateInfo> cis(numBuilders);
+
+  for (uint32_t i = 0; i != numBuilders; i++) {
+    builders[i].fillCreateInfo(infos[i], pipelineLayout);
+    cis[i] = infos[i].ci;
+  }
 
-  const auto result = vkCreateGraphicsPipelines(device, pipelineCache, 1, &ci, nullptr, outPipeline);
+  const auto result = vkCreateGraphicsPipelines(device, pipelineCache, numBuilders, cis.data(), nullptr, outPipelines);
 
-  if (!IGL_VERIFY(result == VK_SUCCESS)) {
-    return result;
+  for (uint32_t i = 0; i != numBuilders; i++) {
+    if (outPipelines[i] != VK_NULL_HANDLE) {
+      numPipelinesCreated_++;
+      VK_ASSERT(ivkSetDebugObjectName(device, VK_OBJECT_TYPE_PIPELINE, (uint64_t)outPipelines[i], debugName));
+    }
   }
 
-  numPipelinesCreated_++;
+  IGL_VERIFY(result == VK_SUCCESS);
 
-  // set debug name
-  return ivkSetDebugObjectName(device, VK_OBJECT_TYPE_PIPELINE, (uint64_t)*outPipeline, debugName);
+  return result;
 }
 
 } // namespace vulkan
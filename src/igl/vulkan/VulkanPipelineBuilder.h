@@ -9,6 +9,7 @@
 
 #include <igl/vulkan/Common.h>
 #include <igl/vulkan/VulkanHelpers.h>
+#include <atomic>
 #include <vector>
 
 namespace lvk::vulkan {
@@ -40,17 +41,37 @@ class VulkanPipelineBuilder final {
   VulkanPipelineBuilder& colorAttachmentFormats(std::vector<VkFormat>& formats);
   VulkanPipelineBuilder& depthAttachmentFormat(VkFormat format);
   VulkanPipelineBuilder& stencilAttachmentFormat(VkFormat format);
+  VulkanPipelineBuilder& createFlags(VkPipelineCreateFlags flags);
 
   VkResult build(VkDevice device,
                  VkPipelineCache pipelineCache,
                  VkPipelineLayout pipelineLayout,
                  VkPipeline* outPipeline,
                  const char* debugName = nullptr) noexcept;
+  // creates all pipelines with one vkCreateGraphicsPipelines() call; the pipelines which failed are VK_NULL_HANDLE
+  static VkResult build(VkDevice device,
+                        VkPipelineCache pipelineCache,
+                        VkPipelineLayout pipelineLayout,
+                        const VulkanPipelineBuilder* builders,
+                        uint32_t numBuilders,
+                        VkPipeline* outPipelines,
+                        const char* debugName = nullptr) noexcept;
 
   static uint32_t getNumPipelinesCreated() {
     return numPipelinesCreated_;
   }
 
+ private:
+  // the Vulkan structures VkGraphicsPipelineCreateInfo points to which are not stored in the builder
+  struct CreateInfo {
+    VkPipelineDynamicStateCreateInfo dynamicState;
+    VkPipelineViewportStateCreateInfo viewportState;
+    VkPipelineColorBlendStateCreateInfo colorBlendState;
+    VkPipelineRenderingCreateInfo renderingInfo;
+    VkGraphicsPipelineCreateInfo ci;
+  };
+  void fillCreateInfo(CreateInfo& info, VkPipelineLayout pipelineLayout) const;
+
  private:
   std::vector<VkDynamicState> dynamicStates_;
   std::vector<VkPipelineShaderStageCreateInfo> shaderStages_;
@@ -64,7 +85,8 @@ class VulkanPipelineBuilder final {
   std::vector<VkFormat> colorAttachmentFormats_;
   VkFormat depthAttachmentFormat_ = VK_FORMAT_UNDEFINED;
   VkFormat stencilAttachmentFormat_ = VK_FORMAT_UNDEFINED;
-  static uint32_t numPipelinesCreated_;
+  VkPipelineCreateFlags createFlags_ = 0;
+  static std::atomic<uint32_t> numPipelinesCreated_; // pipelines can be created on several threads
 };
 
 } // namespace lvk::vulkan
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <igl/vulkan/VulkanPipelineCompiler.h>
+
+#include <igl/vulkan/Common.h>
+
+namespace lvk {
+namespace vulkan {
+
+VulkanPipelineCompiler::VulkanPipelineCompiler(uint32_t numThreads) {
+  threads_.reserve(numThreads);
+
+  for (uint32_t i = 0; i != numThreads; i++) {
+    threads_.emplace_back([this]() { run(); });
+  }
+}
+
+VulkanPipelineCompiler::~VulkanPipelineCompiler() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    isStopping_ = true;
+  }
+
+  condition_.notify_all();
+
+  for (std::thread& t : threads_) {
+    t.join();
+  }
+
+  IGL_ASSERT(jobs_.empty());
+}
+
+void VulkanPipelineCompiler::enqueue(std::function<void()>&& job) {
+  if (threads_.empty()) {
+    job();
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.emplace_back(std::move(job));
+  }
+
+  condition_.notify_one();
+}
+
+void VulkanPipelineCompiler::run() {
+  IGL_PROFILER_THREAD("PipelineCompiler");
+
+  for (;;) {
+    std::function<void()> job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.wait(lock, [this]() { return isStopping_ || !jobs_.empty(); });
+      // the queue is drained before stopping: the jobs own pipelines which have to be installed or destroyed
+      if (jobs_.empty()) {
+        return;
+      }
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+    }
+    IGL_PROFILER_ZONE("VulkanPipelineCompiler::run()", IGL_PROFILER_COLOR_CREATE);
+    job();
+    IGL_PROFILER_ZONE_END();
+  }
+}
+
+} // namespace vulkan
+} // namespace lvk
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lvk {
+namespace vulkan {
+
+// worker threads which compile pipelines in the background (IDevice::prewarmRenderPipeline())
+// without threads, the jobs are run right away on the thread calling enqueue()
+class VulkanPipelineCompiler final {
+ public:
+  explicit VulkanPipelineCompiler(uint32_t numThreads);
+  // finishes all enqueued jobs
+  ~VulkanPipelineCompiler();
+  VulkanPipelineCompiler(const VulkanPipelineCompiler&) = delete;
+  VulkanPipelineCompiler& operator=(const VulkanPipelineCompiler&) = delete;
+
+  void enqueue(std::function<void()>&& job);
+
+ private:
+  void run();
+
+ private:
+  std::vector<std::thread> threads_;
+  std::deque<std::function<void()>> jobs_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool isStopping_ = false;
+};
+
+} // namespace vulkan
+} // namespace lvk
@@ -15,11 +15,10 @@
 
 #include <string.h>
 #include <algorithm>
+#include <functional>
 
 #define IGL_VULKAN_DEBUG_STAGING_DEVICE 0
 
-using SubmitHandle = lvk::vulkan::VulkanImmediateCommands::SubmitHandle;
-
 namespace {
 
 /// Vulkan textures are up-side down compared to OGL textures. IGL follows
@@ -36,103 +35,269 @@ namespace lvk {
 
 namespace vulkan {
 
+// partial regions should not degenerate into tiny chunks at the end of the ring
+constexpr uint32_t kMinPartialSize = 64u * 1024u;
+
+// readback tokens are tagged: they belong to readbacks_.immediate (the upper bits hold the submit id)
+constexpr uint64_t kReadbackTokenBit = 1ull << 31;
+
+// shadows lvk::SubmitHandle: the public token is always spelled out as lvk::SubmitHandle here
+using SubmitHandle = VulkanImmediateCommands::SubmitHandle;
+
 VulkanStagingDevice::VulkanStagingDevice(VulkanContext& ctx) : ctx_(ctx) {
   IGL_PROFILER_FUNCTION();
 
   const auto& limits = ctx_.getVkPhysicalDeviceProperties().limits;
 
   // Use default value of 256 MB, and clamp it to the max limits
-  stagingBufferSize_ = std::min(limits.maxStorageBufferRange, 256u * 1024u * 1024u);
+  uploads_.size = std::min(limits.maxStorageBufferRange, 256u * 1024u * 1024u);
 
-  bufferCapacity_ = stagingBufferSize_;
+  uploads_.buffer = ctx_.createBuffer(uploads_.size,
+                                      VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+                                      nullptr,
+                                      "Buffer: staging buffer");
+  IGL_ASSERT(!uploads_.buffer.empty());
 
-  stagingBuffer_ = ctx_.createBuffer(stagingBufferSize_,
-                                     VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                                     VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
-                                     nullptr,
-                                     "Buffer: staging buffer");
-  IGL_ASSERT(!stagingBuffer_.empty());
+  useTransferQueue_ = ctx_.deviceQueues_.transferQueueFamilyIndex != DeviceQueues::INVALID;
 
   immediate_ = std::make_unique<lvk::vulkan::VulkanImmediateCommands>(
-      ctx_.getVkDevice(), ctx_.deviceQueues_.graphicsQueueFamilyIndex, "VulkanStagingDevice::immediate_");
+      ctx_.getVkDevice(),
+      useTransferQueue_ ? ctx_.deviceQueues_.transferQueueFamilyIndex : ctx_.deviceQueues_.graphicsQueueFamilyIndex,
+      "VulkanStagingDevice::immediate_");
+
+  uploads_.immediate = immediate_.get();
+  // resources are owned by the graphics queue: read them back there
+  readbacks_.immediate = useTransferQueue_ ? ctx_.immediate_.get() : immediate_.get();
 }
 
 VulkanStagingDevice::~VulkanStagingDevice() {
-  ctx_.buffersPool_.destroy(stagingBuffer_);
+  submitPendingUploads();
+
+  ctx_.buffersPool_.destroy(uploads_.buffer);
+
+  if (!readbacks_.buffer.empty()) {
+    ctx_.buffersPool_.destroy(readbacks_.buffer);
+  }
 }
 
-void VulkanStagingDevice::bufferSubData(VulkanBuffer& buffer, size_t dstOffset, size_t size, const void* data) {
+lvk::SubmitHandle VulkanStagingDevice::bufferSubData(VulkanBuffer& buffer, size_t dstOffset, size_t size, const void* data) {
   IGL_PROFILER_FUNCTION();
   if (buffer.isMapped()) {
     buffer.bufferSubData(dstOffset, size, data);
-    return;
+    return {};
+  }
+
+  const VkBuffer dstBuffer = buffer.getVkBuffer();
+
+  // regions of one vkCmdCopyBuffer() must not overlap: the previous data goes first
+  for (const PendingBufferCopy& p : pendingBufferCopies_) {
+    if (p.buffer == dstBuffer && dstOffset < p.region.dstOffset + p.region.size && p.region.dstOffset < dstOffset + size) {
+      submitPendingUploads();
+      break;
+    }
   }
 
   size_t chunkDstOffset = dstOffset;
   void* copyData = const_cast<void*>(data);
 
-  lvk::vulkan::VulkanBuffer* stagingBuffer = ctx_.buffersPool_.get(stagingBuffer_);
+  lvk::vulkan::VulkanBuffer* stagingBuffer = ctx_.buffersPool_.get(uploads_.buffer);
 
   while (size) {
-    // get next staging buffer free offset
-    const MemoryRegionDesc desc = getNextFreeOffset((uint32_t)size);
-    const uint32_t chunkSize = std::min((uint32_t)size, desc.alignedSize_);
+    // get next staging buffer free region
+    StagingRegion& region = allocate(uploads_, (uint32_t)std::min(size, (size_t)uploads_.size), kMinPartialSize);
+    const uint32_t chunkSize = std::min((uint32_t)size, region.size_);
 
     // copy data into staging buffer
-    stagingBuffer->bufferSubData(desc.srcOffset_, chunkSize, copyData);
-
-    // do the transfer
-    const VkBufferCopy copy = {desc.srcOffset_, chunkDstOffset, chunkSize};
+    stagingBuffer->bufferSubData(region.offset_, chunkSize, copyData);
 
-    auto& wrapper = immediate_->acquire();
-    vkCmdCopyBuffer(wrapper.cmdBuf_, stagingBuffer->getVkBuffer(), buffer.getVkBuffer(), 1, &copy);
-    const SubmitHandle fenceId = immediate_->submit(wrapper);
-    outstandingFences_[fenceId.handle()] = desc;
+    // the transfer is recorded now and submitted later together with all other pending uploads
+    if (!pendingUploads_) {
+      pendingUploads_ = &immediate_->acquire();
+    }
+    pendingBufferCopies_.push_back({dstBuffer, VkBufferCopy{region.offset_, chunkDstOffset, chunkSize}});
+    region.handle_ = pendingUploads_->handle_;
 
     size -= chunkSize;
     copyData = (uint8_t*)copyData + chunkSize;
     chunkDstOffset += chunkSize;
   }
+
+  return lvk::SubmitHandle{pendingUploads_->handle_.handle()};
 }
 
-void VulkanStagingDevice::getBufferSubData(VulkanBuffer& buffer, size_t srcOffset, size_t size, void* data) {
+void VulkanStagingDevice::submitPendingUploads() {
+  if (!pendingUploads_) {
+    return;
+  }
+
+  IGL_PROFILER_FUNCTION();
+
+  const VkCommandBuffer cmdBuf = pendingUploads_->cmdBuf_;
+  const VkBuffer stagingBuffer = ctx_.buffersPool_.get(uploads_.buffer)->getVkBuffer();
+
+  if (useTransferQueue_ && !pendingBufferCopies_.empty()) {
+    // buffers are shared with the other queues: work submitted there might still read the old contents
+    waitForOtherQueues();
+  }
+
+  // submits are not chained: wait for all previous accesses on this queue (including previous uploads)...
+  ivkMemoryBarrier(cmdBuf,
+                   VK_ACCESS_MEMORY_WRITE_BIT,
+                   VK_ACCESS_TRANSFER_WRITE_BIT,
+                   VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                   VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+  // one vkCmdCopyBuffer() per destination buffer
+  std::stable_sort(pendingBufferCopies_.begin(), pendingBufferCopies_.end(), [](const PendingBufferCopy& a, const PendingBufferCopy& b) {
+    return std::less<VkBuffer>()(a.buffer, b.buffer);
+  });
+
+  for (size_t i = 0; i != pendingBufferCopies_.size();) {
+    const VkBuffer dstBuffer = pendingBufferCopies_[i].buffer;
+    copyRegions_.clear();
+    for (; i != pendingBufferCopies_.size() && pendingBufferCopies_[i].buffer == dstBuffer; i++) {
+      copyRegions_.push_back(pendingBufferCopies_[i].region);
+    }
+    vkCmdCopyBuffer(cmdBuf, stagingBuffer, dstBuffer, (uint32_t)copyRegions_.size(), copyRegions_.data());
+  }
+
+  if (!useTransferQueue_) {
+    // ...and make the new data visible to all subsequent commands (the graphics queue waits for the transfer queue otherwise)
+    ivkMemoryBarrier(cmdBuf,
+                     VK_ACCESS_TRANSFER_WRITE_BIT,
+                     VK_ACCESS_MEMORY_READ_BIT,
+                     VK_PIPELINE_STAGE_TRANSFER_BIT,
+                     VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+  }
+
+  immediate_->submit(*pendingUploads_);
+
+  pendingUploads_ = nullptr;
+  pendingBufferCopies_.clear();
+  hasPendingUploads_ = true;
+}
+
+void VulkanStagingDevice::waitForOtherQueues() {
+  IGL_ASSERT(useTransferQueue_);
+
+  VulkanImmediateCommands& graphics = *ctx_.immediate_;
+  immediate_->waitTimelineSemaphore(graphics.getTimelineSemaphore(), graphics.getLastSignaledValue(), VK_PIPELINE_STAGE_2_TRANSFER_BIT);
+  if (ctx_.immediateCompute_) {
+    VulkanImmediateCommands& compute = *ctx_.immediateCompute_;
+    immediate_->waitTimelineSemaphore(compute.getTimelineSemaphore(), compute.getLastSignaledValue(), VK_PIPELINE_STAGE_2_TRANSFER_BIT);
+  }
+}
+
+bool VulkanStagingDevice::isReady(lvk::SubmitHandle handle) {
+  if (handle.empty()) {
+    return true;
+  }
+
+  if (handle.handle & kReadbackTokenBit) {
+    const bool isReady = readbacks_.immediate->isReady(SubmitHandle(handle.handle & ~kReadbackTokenBit));
+    // downloads complete in submission order: this one is copied out now if it was ready
+    processDownloads();
+    return isReady;
+  }
+
+  return immediate_->isReady(SubmitHandle(handle.handle));
+}
+
+void VulkanStagingDevice::wait(lvk::SubmitHandle handle) {
+  if (handle.empty()) {
+    return;
+  }
+
+  if (handle.handle & kReadbackTokenBit) {
+    readbacks_.immediate->wait(SubmitHandle(handle.handle & ~kReadbackTokenBit));
+    processDownloads();
+    return;
+  }
+
+  const SubmitHandle h(handle.handle);
+
+  if (immediate_->isEncoding(h)) {
+    submitPendingUploads();
+  }
+
+  immediate_->wait(h);
+}
+
+lvk::SubmitHandle VulkanStagingDevice::getBufferSubData(VulkanBuffer& buffer,
+                                                        size_t srcOffset,
+                                                        size_t size,
+                                                        void* data,
+                                                        std::function<void()>&& completionHandler) {
   IGL_PROFILER_FUNCTION();
   if (buffer.isMapped()) {
     buffer.getBufferSubData(srcOffset, size, data);
-    return;
+    if (completionHandler) {
+      completionHandler();
+    }
+    return {};
   }
 
+  createReadbackRing();
+
   size_t chunkSrcOffset = srcOffset;
   auto* dstData = static_cast<uint8_t*>(data);
 
-  lvk::vulkan::VulkanBuffer* stagingBuffer = ctx_.buffersPool_.get(stagingBuffer_);
-
-  while (size) {
-    // get next staging buffer free offset
-    const MemoryRegionDesc desc = getNextFreeOffset((uint32_t)size);
-    const uint32_t chunkSize = std::min((uint32_t)size, desc.alignedSize_);
+  const VkBuffer readbackBuffer = ctx_.buffersPool_.get(readbacks_.buffer)->getVkBuffer();
 
-    // do the transfer
-    const VkBufferCopy copy = {chunkSrcOffset, desc.srcOffset_, chunkSize};
+  VulkanImmediateCommands& readback = getReadbackCommands();
 
-    auto& wrapper = immediate_->acquire();
+  SubmitHandle handle;
 
-    vkCmdCopyBuffer(wrapper.cmdBuf_, buffer.getVkBuffer(), stagingBuffer->getVkBuffer(), 1, &copy);
+  while (size) {
+    // get next readback buffer free region
+    StagingRegion& region = allocate(readbacks_, (uint32_t)std::min(size, (size_t)readbacks_.size), kMinPartialSize);
+    const uint32_t chunkSize = std::min((uint32_t)size, region.size_);
 
-    SubmitHandle fenceId = immediate_->submit(wrapper);
-    outstandingFences_[fenceId.handle()] = desc;
+    // do the transfer
+    const VkBufferCopy copy = {chunkSrcOffset, region.offset_, chunkSize};
+
+    auto& wrapper = readback.acquire();
+
+    // submits are not chained: make all previous writes to this range visible to the copy
+    ivkBufferMemoryBarrier(wrapper.cmdBuf_,
+                           buffer.getVkBuffer(),
+                           VK_ACCESS_MEMORY_WRITE_BIT,
+                           VK_ACCESS_TRANSFER_READ_BIT,
+                           chunkSrcOffset,
+                           chunkSize,
+                           VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT);
+    vkCmdCopyBuffer(wrapper.cmdBuf_, buffer.getVkBuffer(), readbackBuffer, 1, &copy);
+    ivkBufferMemoryBarrier(wrapper.cmdBuf_,
+                           readbackBuffer,
+                           VK_ACCESS_TRANSFER_WRITE_BIT,
+                           VK_ACCESS_HOST_READ_BIT,
+                           region.offset_,
+                           chunkSize,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT,
+                           VK_PIPELINE_STAGE_HOST_BIT);
+
+    region.handle_ = wrapper.handle_;
+    region.isHostReadPending_ = true;
+
+    handle = readback.submit(wrapper);
 
-    // Wait for command to finish
-    flushOutstandingFences();
+    size -= chunkSize;
 
-    // copy data into data
-    const uint8_t* src = stagingBuffer->getMappedPtr() + desc.srcOffset_;
-    memcpy(dstData, src, chunkSize);
+    pendingDownloads_.push_back({
+        .handle = handle,
+        .region = &region,
+        .data = dstData,
+        .size = chunkSize,
+        .completionHandler = size ? std::function<void()>() : std::move(completionHandler),
+    });
 
-    size -= chunkSize;
-    dstData = (uint8_t*)dstData + chunkSize;
+    dstData += chunkSize;
     chunkSrcOffset += chunkSize;
   }
+
+  return handle.empty() ? lvk::SubmitHandle{} : lvk::SubmitHandle{handle.handle() | kReadbackTokenBit};
 }
 
 void VulkanStagingDevice::imageData2D(VulkanImage& image,
@@ -145,330 +310,649 @@ void VulkanStagingDevice::imageData2D(VulkanImage& image,
                                       const void* data[]) {
   IGL_PROFILER_FUNCTION();
 
-  // cache the dimensions of each mip level for later
-  uint32_t mipSizes[32];
-
-  IGL_ASSERT(numMipLevels <= 32);
+  IGL_ASSERT(baseMipLevel + numMipLevels <= image.levels_);
 
   // divide the width and height by 2 until we get to the size of level 'baseMipLevel'
-  auto width = image.extent_.width >> baseMipLevel;
-  auto height = image.extent_.height >> baseMipLevel;
+  const uint32_t width = std::max(1u, image.extent_.width >> baseMipLevel);
+  const uint32_t height = std::max(1u, image.extent_.height >> baseMipLevel);
 
   const Format texFormat(vkFormatToTextureFormat(format));
 
-  IGL_ASSERT_MSG(imageRegion.offset.x == 0 && imageRegion.offset.y == 0 && imageRegion.extent.width == width &&
-                     imageRegion.extent.height == height,
+  IGL_ASSERT_MSG(imageRegion.offset.x >= 0 && imageRegion.offset.y >= 0 && imageRegion.offset.x + imageRegion.extent.width <= width &&
+                     imageRegion.offset.y + imageRegion.extent.height <= height,
+                 "The image region exceeds the base mip level");
+  // the extent can end at the edge of the mip level in the middle of a block
+  const uint32_t blockWidth = lvk::getTextureBlockWidth(texFormat);
+  const uint32_t blockHeight = lvk::getTextureBlockHeight(texFormat);
+  IGL_ASSERT_MSG(imageRegion.offset.x % blockWidth == 0 && imageRegion.offset.y % blockHeight == 0 &&
+                     (imageRegion.extent.width % blockWidth == 0 || imageRegion.offset.x + imageRegion.extent.width == width) &&
+                     (imageRegion.extent.height % blockHeight == 0 || imageRegion.offset.y + imageRegion.extent.height == height),
+                 "The image region should be block-aligned");
+
+  // a sub-rectangle update keeps the surrounding texels
+  const bool isFullSize = imageRegion.offset.x == 0 && imageRegion.offset.y == 0 && imageRegion.extent.width == width &&
+                          imageRegion.extent.height == height;
+
+  const VkImageSubresourceRange range = {VK_IMAGE_ASPECT_COLOR_BIT, baseMipLevel, numMipLevels, layer, numLayers};
+
+  if (canCopyMemoryToImage(image, range)) {
+    hostImageCopies_.clear();
+    for (uint32_t l = 0; l != numLayers; l++) {
+      const uint8_t* mipData = static_cast<const uint8_t*>(data[l]);
+
+      for (uint32_t mipLevel = 0; mipLevel != numMipLevels; mipLevel++) {
+        hostImageCopies_.push_back({
+            .sType = VK_STRUCTURE_TYPE_MEMORY_TO_IMAGE_COPY_EXT,
+            .pHostPointer = mipData,
+            .imageSubresource = VkImageSubresourceLayers{VK_IMAGE_ASPECT_COLOR_BIT, baseMipLevel + mipLevel, layer + l, 1},
+            .imageOffset = {imageRegion.offset.x >> mipLevel, imageRegion.offset.y >> mipLevel, 0},
+            .imageExtent = {std::max(1u, imageRegion.extent.width >> mipLevel), std::max(1u, imageRegion.extent.height >> mipLevel), 1u},
+        });
+
+        mipData += lvk::getTextureBytesPerLayer(imageRegion.extent.width, imageRegion.extent.height, texFormat, mipLevel);
+      }
+    }
+    copyMemoryToImage(image, range);
+    return;
+  }
+
+  // 1. Transition the image into TRANSFER_DST_OPTIMAL
+  transitionToTransferDst(image, range, isFullSize);
 
-                 "Uploading mip levels with an image region that is smaller than the base mip level is "
-                 "not supported");
+  // 2. Copy the pixel data through the staging buffer into the image; data[] contains per-layer mip-stacks
+  for (uint32_t l = 0; l != numLayers; l++) {
+    const uint8_t* mipData = static_cast<const uint8_t*>(data[l]);
 
-  // find the storage size for all mip-levels being uploaded
-  uint32_t layarStorageSize = 0;
-  for (uint32_t i = 0; i < numMipLevels; ++i) {
-    const uint32_t mipSize = lvk::getTextureBytesPerLayer(image.extent_.width, image.extent_.height, texFormat, i);
+    for (uint32_t mipLevel = 0; mipLevel != numMipLevels; mipLevel++) {
+      const VkOffset3D offset = {imageRegion.offset.x >> mipLevel, imageRegion.offset.y >> mipLevel, 0};
+      const VkExtent3D extent = {
+          std::max(1u, imageRegion.extent.width >> mipLevel), std::max(1u, imageRegion.extent.height >> mipLevel), 1u};
 
-    layarStorageSize += mipSize;
-    mipSizes[i] = mipSize;
-    width = width <= 1 ? 1 : width >> 1; // divide the width by 2
-    height = height <= 1 ? 1 : height >> 1; // divide the height by 2
+      imageBoxData(image, baseMipLevel + mipLevel, layer + l, offset, extent, texFormat, mipData);
+
+      mipData += lvk::getTextureBytesPerLayer(imageRegion.extent.width, imageRegion.extent.height, texFormat, mipLevel);
+    }
   }
-  const uint32_t storageSize = layarStorageSize * numLayers;
 
-  IGL_ASSERT(storageSize <= stagingBufferSize_);
+  // 3. Transition TRANSFER_DST_OPTIMAL into SHADER_READ_ONLY_OPTIMAL
+  transitionToShaderReadOnly(acquireImageUploads().cmdBuf_, image, range);
+
+  image.setImageLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, range);
+
+  submitImageUploads();
+}
+
+void VulkanStagingDevice::imageData3D(VulkanImage& image,
+                                      const VkOffset3D& offset,
+                                      const VkExtent3D& extent,
+                                      VkFormat format,
+                                      const void* data) {
+  IGL_PROFILER_FUNCTION();
+  IGL_ASSERT_MSG(image.levels_ == 1, "Can handle only 3D images with exactly 1 mip-level");
 
-  // get next staging buffer free offset
-  MemoryRegionDesc desc = getNextFreeOffset(layarStorageSize);
-  // currently, no support for copying image in multiple smaller chunk sizes.
-  // If we get smaller buffer size than storageSize, we will wait for GPU idle and get bigger chunk.
-  if (desc.alignedSize_ < storageSize) {
-    flushOutstandingFences();
-    desc = getNextFreeOffset(storageSize);
+  // a sub-box update keeps the surrounding texels
+  const bool isFullSize = offset.x == 0 && offset.y == 0 && offset.z == 0 && extent.width == image.extent_.width &&
+                          extent.height == image.extent_.height && extent.depth == image.extent_.depth;
+
+  const VkImageSubresourceRange range = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+  if (canCopyMemoryToImage(image, range)) {
+    hostImageCopies_.clear();
+    hostImageCopies_.push_back({
+        .sType = VK_STRUCTURE_TYPE_MEMORY_TO_IMAGE_COPY_EXT,
+        .pHostPointer = data,
+        .imageSubresource = VkImageSubresourceLayers{VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1},
+        .imageOffset = offset,
+        .imageExtent = extent,
+    });
+    copyMemoryToImage(image, range);
+    return;
   }
-  IGL_ASSERT(desc.alignedSize_ >= storageSize);
 
-  auto& wrapper = immediate_->acquire();
+  // 1. Transition the image into TRANSFER_DST_OPTIMAL
+  transitionToTransferDst(image, range, isFullSize);
+
+  // 2. Copy the pixel data through the staging buffer into the image
+  imageBoxData(image, 0, 0, offset, extent, vkFormatToTextureFormat(format), static_cast<const uint8_t*>(data));
+
+  // 3. Transition TRANSFER_DST_OPTIMAL into SHADER_READ_ONLY_OPTIMAL
+  transitionToShaderReadOnly(acquireImageUploads().cmdBuf_, image, range);
+
+  image.setImageLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, range);
+
+  submitImageUploads();
+}
 
-  lvk::vulkan::VulkanBuffer* stagingBuffer = ctx_.buffersPool_.get(stagingBuffer_);
+void VulkanStagingDevice::imageBoxData(VulkanImage& image,
+                                       uint32_t mipLevel,
+                                       uint32_t layer,
+                                       const VkOffset3D& offset,
+                                       const VkExtent3D& extent,
+                                       lvk::Format format,
+                                       const uint8_t* data) {
+  IGL_PROFILER_FUNCTION();
 
-  for (uint32_t layer = 0; layer != numLayers; layer++) {
-    // copy the pixel data into the host visible staging buffer
-    stagingBuffer->bufferSubData(desc.srcOffset_ + layer * layarStorageSize, layarStorageSize, data[layer]);
+  // rows of blocks are the smallest units which can be copied separately
+  const uint32_t blockHeight = lvk::getTextureBlockHeight(format);
+  const uint32_t rowSize = lvk::getTextureBytesPerLayer(extent.width, 1, format, 0);
+  const uint32_t numRows = (extent.height + blockHeight - 1) / blockHeight;
+  const uint64_t sliceSize = uint64_t(rowSize) * numRows;
 
-    uint32_t mipLevelOffset = 0;
+  IGL_ASSERT(getAlignedSize(rowSize) <= uploads_.size);
 
-    for (uint32_t mipLevel = 0; mipLevel < numMipLevels; ++mipLevel) {
-      const auto currentMipLevel = baseMipLevel + mipLevel;
+  lvk::vulkan::VulkanBuffer* stagingBuffer = ctx_.buffersPool_.get(uploads_.buffer);
 
-      IGL_ASSERT(currentMipLevel < image.levels_);
-      IGL_ASSERT(mipLevel < image.levels_);
+  uint32_t z = 0;
+  uint32_t row = 0;
 
-      // 1. Transition initial image layout into TRANSFER_DST_OPTIMAL
-      ivkImageMemoryBarrier(wrapper.cmdBuf_,
-                            image.getVkImage(),
-                            0,
-                            VK_ACCESS_TRANSFER_WRITE_BIT,
-                            VK_IMAGE_LAYOUT_UNDEFINED,
-                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                            VK_PIPELINE_STAGE_TRANSFER_BIT,
-                            VkImageSubresourceRange{VK_IMAGE_ASPECT_COLOR_BIT, currentMipLevel, 1, layer, 1});
+  while (z < extent.depth) {
+    // whole slices if they fit, otherwise bands of rows of the current slice
+    const uint64_t remainingSize = row ? uint64_t(rowSize) * (numRows - row) : sliceSize * (extent.depth - z);
 
+    StagingRegion& region = allocate(uploads_, (uint32_t)std::min(remainingSize, (uint64_t)uploads_.size), rowSize);
+
+    const uint32_t numSlices = row ? 0 : (uint32_t)std::min(region.size_ / sliceSize, uint64_t(extent.depth - z));
+    const uint32_t numBandRows = numSlices ? numRows : std::min(region.size_ / rowSize, numRows - row);
+    const uint32_t bandSize = numSlices ? uint32_t(numSlices * sliceSize) : numBandRows * rowSize;
+
+    stagingBuffer->bufferSubData(region.offset_, bandSize, data + z * sliceSize + uint64_t(row) * rowSize);
+    shrinkLastRegion(uploads_, region, bandSize);
+
+    const VulkanImmediateCommands::CommandBufferWrapper& wrapper = acquireImageUploads();
+
+    region.handle_ = wrapper.handle_;
+
+    const uint32_t y = row * blockHeight;
+    const VkBufferImageCopy copy =
+        ivkGetBufferImageCopy3D(region.offset_,
+                                VkOffset3D{offset.x, offset.y + (int32_t)y, offset.z + (int32_t)z},
+                                VkExtent3D{extent.width,
+                                           numSlices ? extent.height : std::min(numBandRows * blockHeight, extent.height - y),
+                                           numSlices ? numSlices : 1u},
+                                VkImageSubresourceLayers{VK_IMAGE_ASPECT_COLOR_BIT, mipLevel, layer, 1});
 #if IGL_VULKAN_PRINT_COMMANDS
-      LLOGL("%p vkCmdCopyBufferToImage()\n", wrapper.cmdBuf_);
+    LLOGL("%p vkCmdCopyBufferToImage()\n", wrapper.cmdBuf_);
 #endif // IGL_VULKAN_PRINT_COMMANDS
-      // 2. Copy the pixel data from the staging buffer into the image
-      const VkRect2D region = ivkGetRect2D(imageRegion.offset.x >> mipLevel,
-                                           imageRegion.offset.y >> mipLevel,
-                                           std::max(1u, imageRegion.extent.width >> mipLevel),
-                                           std::max(1u, imageRegion.extent.height >> mipLevel));
-
-      const VkBufferImageCopy copy = ivkGetBufferImageCopy2D(
-          // the offset for this level is at the start of all mip-levels plus the size of all previous
-          // mip-levels being uploaded
-          desc.srcOffset_ + layer * layarStorageSize + mipLevelOffset,
-          region,
-          VkImageSubresourceLayers{VK_IMAGE_ASPECT_COLOR_BIT, currentMipLevel, layer, 1});
-      vkCmdCopyBufferToImage(
-          wrapper.cmdBuf_, stagingBuffer->getVkBuffer(), image.getVkImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
-
-      // 3. Transition TRANSFER_DST_OPTIMAL into SHADER_READ_ONLY_OPTIMAL
-      ivkImageMemoryBarrier(wrapper.cmdBuf_,
-                            image.getVkImage(),
-                            VK_ACCESS_TRANSFER_READ_BIT, // VK_ACCESS_TRANSFER_WRITE_BIT,
-                            VK_ACCESS_SHADER_READ_BIT,
-                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                            VK_PIPELINE_STAGE_TRANSFER_BIT,
-                            VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-                            VkImageSubresourceRange{VK_IMAGE_ASPECT_COLOR_BIT, currentMipLevel, 1, layer, 1});
-
-      // Compute the offset for the next level
-      mipLevelOffset += mipSizes[mipLevel];
+    vkCmdCopyBufferToImage(
+        wrapper.cmdBuf_, stagingBuffer->getVkBuffer(), image.getVkImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+
+    if (numSlices) {
+      z += numSlices;
+    } else if ((row += numBandRows) == numRows) {
+      row = 0;
+      z++;
     }
   }
+}
 
-  image.imageLayout_ = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-  SubmitHandle fenceId = immediate_->submit(wrapper);
-  outstandingFences_[fenceId.handle()] = desc;
+bool VulkanStagingDevice::canCopyMemoryToImage(const VulkanImage& image, const VkImageSubresourceRange& range) const {
+  // the host cannot synchronize with the GPU: only subresources which have never been written can be copied into
+  return ctx_.useHostImageCopy_ && (image.getVkImageUsageFlags() & VK_IMAGE_USAGE_HOST_TRANSFER_BIT_EXT) &&
+         image.getImageLayout(range) == VK_IMAGE_LAYOUT_UNDEFINED;
 }
 
-void VulkanStagingDevice::imageData3D(VulkanImage& image,
-                                      const VkOffset3D& offset,
-                                      const VkExtent3D& extent,
-                                      VkFormat format,
-                                      const void* data) {
+void VulkanStagingDevice::copyMemoryToImage(VulkanImage& image, const VkImageSubresourceRange& range) {
   IGL_PROFILER_FUNCTION();
-  IGL_ASSERT_MSG(image.levels_ == 1, "Can handle only 3D images with exactly 1 mip-level");
-  IGL_ASSERT_MSG((offset.x == 0) && (offset.y == 0) && (offset.z == 0), "Can upload only full-size 3D images");
-  const uint32_t storageSize = extent.width * extent.height * extent.depth * getBytesPerPixel(format);
-
-  IGL_ASSERT(storageSize <= stagingBufferSize_);
 
-  // get next staging buffer free offset
-  MemoryRegionDesc desc = getNextFreeOffset(storageSize);
-
-  // currently, no support for copying image in multiple smaller chunk sizes.
-  // If we get smaller buffer size than storageSize, we will wait for gpu idle and get bigger chunk.
-  if (desc.alignedSize_ < storageSize) {
-    flushOutstandingFences();
-    desc = getNextFreeOffset(storageSize);
+  const VkDevice device = ctx_.getVkDevice();
+  const VkImageLayout copyLayout = ctx_.hostImageCopyDstLayout_;
+
+  const VkHostImageLayoutTransitionInfoEXT toCopyLayout = {
+      .sType = VK_STRUCTURE_TYPE_HOST_IMAGE_LAYOUT_TRANSITION_INFO_EXT,
+      .image = image.getVkImage(),
+      .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+      .newLayout = copyLayout,
+      .subresourceRange = range,
+  };
+  VK_ASSERT(vkTransitionImageLayoutEXT(device, 1, &toCopyLayout));
+
+  // texels are tightly packed: memoryRowLength and memoryImageHeight are 0
+  const VkCopyMemoryToImageInfoEXT copyInfo = {
+      .sType = VK_STRUCTURE_TYPE_COPY_MEMORY_TO_IMAGE_INFO_EXT,
+      .dstImage = image.getVkImage(),
+      .dstImageLayout = copyLayout,
+      .regionCount = (uint32_t)hostImageCopies_.size(),
+      .pRegions = hostImageCopies_.data(),
+  };
+#if IGL_VULKAN_PRINT_COMMANDS
+  LLOGL("vkCopyMemoryToImageEXT()\n");
+#endif // IGL_VULKAN_PRINT_COMMANDS
+  VK_ASSERT(vkCopyMemoryToImageEXT(device, &copyInfo));
+
+  if (copyLayout != VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
+    const VkHostImageLayoutTransitionInfoEXT toShaderReadOnly = {
+        .sType = VK_STRUCTURE_TYPE_HOST_IMAGE_LAYOUT_TRANSITION_INFO_EXT,
+        .image = image.getVkImage(),
+        .oldLayout = copyLayout,
+        .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        .subresourceRange = range,
+    };
+    VK_ASSERT(vkTransitionImageLayoutEXT(device, 1, &toShaderReadOnly));
   }
 
-  IGL_ASSERT(desc.alignedSize_ >= storageSize);
+  // host writes are made visible to the device by the next queue submission; no queue owns the image yet
+  image.setImageLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, range, VK_PIPELINE_STAGE_2_NONE);
+}
 
-  lvk::vulkan::VulkanBuffer* stagingBuffer = ctx_.buffersPool_.get(stagingBuffer_);
+const VulkanImmediateCommands::CommandBufferWrapper& VulkanStagingDevice::acquireImageUploads() {
+  if (!imageUploads_) {
+    imageUploads_ = &immediate_->acquire();
+  }
 
-  // 1. Copy the pixel data into the host visible staging buffer
-  stagingBuffer->bufferSubData(desc.srcOffset_, storageSize, data);
+  return *imageUploads_;
+}
 
-  auto& wrapper = immediate_->acquire();
+void VulkanStagingDevice::submitImageUploads() {
+  if (!imageUploads_) {
+    return;
+  }
 
-  // 1. Transition initial image layout into TRANSFER_DST_OPTIMAL
-  ivkImageMemoryBarrier(wrapper.cmdBuf_,
-                        image.getVkImage(),
-                        0,
-                        VK_ACCESS_TRANSFER_WRITE_BIT,
-                        VK_IMAGE_LAYOUT_UNDEFINED,
-                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                        VK_PIPELINE_STAGE_TRANSFER_BIT,
-                        VkImageSubresourceRange{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1});
-
-  // 2. Copy the pixel data from the staging buffer into the image
-  const VkBufferImageCopy copy =
-      ivkGetBufferImageCopy3D(desc.srcOffset_, offset, extent, VkImageSubresourceLayers{VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1});
-  vkCmdCopyBufferToImage(wrapper.cmdBuf_, stagingBuffer->getVkBuffer(), image.getVkImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+  // the image stays in VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL between command buffers of one upload
+  immediate_->submit(*imageUploads_);
 
-  // 3. Transition TRANSFER_DST_OPTIMAL into SHADER_READ_ONLY_OPTIMAL
-  ivkImageMemoryBarrier(wrapper.cmdBuf_,
-                        image.getVkImage(),
-                        VK_ACCESS_TRANSFER_READ_BIT, // VK_ACCESS_TRANSFER_WRITE_BIT,
-                        VK_ACCESS_SHADER_READ_BIT,
-                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                        VK_PIPELINE_STAGE_TRANSFER_BIT,
-                        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-                        VkImageSubresourceRange{VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1});
-
-  image.imageLayout_ = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-  SubmitHandle fenceId = immediate_->submit(wrapper);
-  outstandingFences_[fenceId.handle()] = desc;
+  imageUploads_ = nullptr;
+  hasPendingUploads_ = true;
 }
 
-void VulkanStagingDevice::getImageData2D(VkImage srcImage,
-                                         const uint32_t level,
-                                         const uint32_t layer,
-                                         const VkRect2D& imageRegion,
-                                         VkFormat format,
-                                         VkImageLayout layout,
-                                         void* data,
-                                         uint32_t dataBytesPerRow,
-                                         bool flipImageVertical) {
+lvk::SubmitHandle VulkanStagingDevice::getImageData2D(VkImage srcImage,
+                                                      const uint32_t level,
+                                                      const uint32_t layer,
+                                                      const VkRect2D& imageRegion,
+                                                      VkFormat format,
+                                                      VkImageLayout layout,
+                                                      void* data,
+                                                      bool flipImageVertical,
+                                                      std::function<void()>&& completionHandler) {
   IGL_PROFILER_FUNCTION();
   IGL_ASSERT(layout != VK_IMAGE_LAYOUT_UNDEFINED);
 
-  const uint32_t storageSize = imageRegion.extent.width * imageRegion.extent.height * getBytesPerPixel(format);
-  IGL_ASSERT(storageSize <= stagingBufferSize_);
+  createReadbackRing();
 
-  // get next staging buffer free offset
-  MemoryRegionDesc desc = getNextFreeOffset(storageSize);
+  const uint64_t storageSize64 = uint64_t(imageRegion.extent.width) * imageRegion.extent.height * getBytesPerPixel(format);
 
-  // If we get smaller buffer size than storageSize, we will wait for gpu idle
-  // and get bigger chunk.
-  if (desc.alignedSize_ < storageSize) {
-    flushOutstandingFences();
-    desc = getNextFreeOffset(storageSize);
+  // the region is read back in one piece: it has to fit into the ring
+  if (!IGL_VERIFY(storageSize64 <= readbacks_.size)) {
+    return {};
   }
 
-  IGL_ASSERT(desc.alignedSize_ >= storageSize);
+  const uint32_t storageSize = (uint32_t)storageSize64;
+
+  StagingRegion& region = allocate(readbacks_, storageSize);
 
-  auto& wrapper1 = immediate_->acquire();
+  VulkanImmediateCommands& readback = getReadbackCommands();
 
-  lvk::vulkan::VulkanBuffer* stagingBuffer = ctx_.buffersPool_.get(stagingBuffer_);
+  auto& wrapper = readback.acquire();
+
+  const VkBuffer readbackBuffer = ctx_.buffersPool_.get(readbacks_.buffer)->getVkBuffer();
 
   // 1. Transition to VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
-  ivkImageMemoryBarrier(wrapper1.cmdBuf_,
+  ivkImageMemoryBarrier(wrapper.cmdBuf_,
                         srcImage,
-                        0, // srcAccessMask
+                        VK_ACCESS_MEMORY_WRITE_BIT, // srcAccessMask
                         VK_ACCESS_TRANSFER_READ_BIT, // dstAccessMask
                         layout,
                         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, // wait for any previous operation
+                        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, // wait for any previous operation
                         VK_PIPELINE_STAGE_TRANSFER_BIT, // dstStageMask
                         VkImageSubresourceRange{VK_IMAGE_ASPECT_COLOR_BIT, level, 1, layer, 1});
 
-  // 2.  Copy the pixel data from the image into the staging buffer
+  // 2.  Copy the pixel data from the image into the readback buffer
   const VkBufferImageCopy copy =
-      ivkGetBufferImageCopy2D(desc.srcOffset_, imageRegion, VkImageSubresourceLayers{VK_IMAGE_ASPECT_COLOR_BIT, level, layer, 1});
-  vkCmdCopyImageToBuffer(wrapper1.cmdBuf_, srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, stagingBuffer->getVkBuffer(), 1, &copy);
+      ivkGetBufferImageCopy2D(region.offset_, imageRegion, VkImageSubresourceLayers{VK_IMAGE_ASPECT_COLOR_BIT, level, layer, 1});
+  vkCmdCopyImageToBuffer(wrapper.cmdBuf_, srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, readbackBuffer, 1, &copy);
+  ivkBufferMemoryBarrier(wrapper.cmdBuf_,
+                         readbackBuffer,
+                         VK_ACCESS_TRANSFER_WRITE_BIT,
+                         VK_ACCESS_HOST_READ_BIT,
+                         region.offset_,
+                         storageSize,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_HOST_BIT);
+
+  // 3. Transition back to the initial image layout
+  ivkImageMemoryBarrier(wrapper.cmdBuf_,
+                        srcImage,
+                        VK_ACCESS_TRANSFER_READ_BIT, // srcAccessMask
+                        0, // dstAccessMask
+                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                        layout,
+                        VK_PIPELINE_STAGE_TRANSFER_BIT, // srcStageMask
+                        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, // dstStageMask
+                        VkImageSubresourceRange{VK_IMAGE_ASPECT_COLOR_BIT, level, 1, layer, 1});
+
+  region.handle_ = wrapper.handle_;
+  region.isHostReadPending_ = true;
+
+  const SubmitHandle handle = readback.submit(wrapper);
+
+  // 4. The pixel data is copied out of the readback buffer by processDownloads()
+  pendingDownloads_.push_back({
+      .handle = handle,
+      .region = &region,
+      .data = static_cast<uint8_t*>(data),
+      .size = storageSize,
+      .flipRowSize = flipImageVertical ? imageRegion.extent.width * getBytesPerPixel(format) : 0u,
+      .completionHandler = std::move(completionHandler),
+  });
+
+  return lvk::SubmitHandle{handle.handle() | kReadbackTokenBit};
+}
+
+void VulkanStagingDevice::processDownloads() {
+  if (pendingDownloads_.empty()) {
+    return;
+  }
+
+  IGL_PROFILER_FUNCTION();
+
+  const VulkanBuffer* readbackBuffer = ctx_.buffersPool_.get(readbacks_.buffer);
 
-  SubmitHandle fenceId = immediate_->submit(wrapper1);
-  outstandingFences_[fenceId.handle()] = desc;
+  // downloads complete in submission order
+  while (!pendingDownloads_.empty() && readbacks_.immediate->isReady(pendingDownloads_.front().handle)) {
+    PendingDownload download = std::move(pendingDownloads_.front());
+    pendingDownloads_.pop_front();
 
-  flushOutstandingFences();
+    readbackBuffer->invalidateMappedMemory(download.region->offset_, download.size);
 
-  // 3. Copy data from staging buffer into data
-  if (!IGL_VERIFY(stagingBuffer->getMappedPtr())) {
+    const uint8_t* src = readbackBuffer->getMappedPtr() + download.region->offset_;
+
+    if (download.flipRowSize) {
+      flipBMP(download.data, src, download.size / download.flipRowSize, download.flipRowSize);
+    } else {
+      memcpy(download.data, src, download.size);
+    }
+
+    download.region->isHostReadPending_ = false;
+
+    if (download.completionHandler) {
+      download.completionHandler();
+    }
+  }
+
+  retireRegions(readbacks_);
+}
+
+uint32_t VulkanStagingDevice::getMaxImageReadbackSize() const {
+  const auto& limits = ctx_.getVkPhysicalDeviceProperties().limits;
+
+  return std::min(limits.maxStorageBufferRange, 64u * 1024u * 1024u);
+}
+
+void VulkanStagingDevice::createReadbackRing() {
+  if (!readbacks_.buffer.empty()) {
     return;
   }
 
-  const uint8_t* src = stagingBuffer->getMappedPtr() + desc.srcOffset_;
-  uint8_t* dst = static_cast<uint8_t*>(data);
+  readbacks_.size = getMaxImageReadbackSize();
+
+  // host-cached memory makes reading on the CPU fast
+  readbacks_.buffer = ctx_.createBuffer(readbacks_.size,
+                                        VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+                                        nullptr,
+                                        "Buffer: readback buffer");
+  IGL_ASSERT(!readbacks_.buffer.empty());
+}
 
-  if (flipImageVertical) {
-    flipBMP(dst, src, imageRegion.extent.height, imageRegion.extent.width * getBytesPerPixel(format));
-  } else {
-    memcpy(dst, src, storageSize);
+void VulkanStagingDevice::transitionToTransferDst(const VulkanImage& image, const VkImageSubresourceRange& range, bool discardContents) {
+  const VkImageLayout oldLayout = discardContents ? VK_IMAGE_LAYOUT_UNDEFINED : image.getImageLayout(range);
+
+  if (!useTransferQueue_ || image.isConcurrent_ || oldLayout == VK_IMAGE_LAYOUT_UNDEFINED) {
+    // the source stages come from the tracked state of every subresource
+    std::vector<VkImageMemoryBarrier2> barriers;
+    image.transitionLayout(
+        barriers, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, range, discardContents);
+    if (useTransferQueue_) {
+      // in-flight frames might still sample the image: pending buffer uploads go first so that the image upload
+      // is the next submit of immediate_ and consumes the waits
+      submitPendingUploads();
+      waitForOtherQueues();
+      // the tracked stages belong to the other queues and do not exist on the transfer queue
+      for (VkImageMemoryBarrier2& b : barriers) {
+        b.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        b.srcAccessMask = VK_ACCESS_2_NONE;
+      }
+    }
+    ivkCmdPipelineBarrier2(acquireImageUploads().cmdBuf_, 0, nullptr, (uint32_t)barriers.size(), barriers.data());
+    return;
   }
 
-  // 4. Transition back to the initial image layout
-  auto& wrapper2 = immediate_->acquire();
+  IGL_ASSERT_MSG(oldLayout != VK_IMAGE_LAYOUT_MAX_ENUM, "All subresources of an ownership transfer should be in the same layout");
+
+  // the existing contents belong to the graphics queue: hand off any previous uploads of this image to it...
+  acquirePendingOwnership();
+
+  // ...and release the image to the transfer queue
+  VulkanImmediateCommands& graphics = *ctx_.immediate_;
+
+  const auto& wrapper = graphics.acquire();
+  ivkImageOwnershipBarrier(wrapper.cmdBuf_,
+                           image.getVkImage(),
+                           VK_ACCESS_MEMORY_WRITE_BIT,
+                           0,
+                           oldLayout,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                           VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                           range,
+                           ctx_.deviceQueues_.graphicsQueueFamilyIndex,
+                           ctx_.deviceQueues_.transferQueueFamilyIndex);
+  graphics.submit(wrapper);
+
+  // all pending buffer uploads were submitted above: the next submit of immediate_ is this image upload
+  waitForOtherQueues();
+
+  ivkImageOwnershipBarrier(acquireImageUploads().cmdBuf_,
+                           image.getVkImage(),
+                           0,
+                           VK_ACCESS_TRANSFER_WRITE_BIT,
+                           oldLayout,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, // chained with the timeline semaphore wait
+                           VK_PIPELINE_STAGE_TRANSFER_BIT,
+                           range,
+                           ctx_.deviceQueues_.graphicsQueueFamilyIndex,
+                           ctx_.deviceQueues_.transferQueueFamilyIndex);
+}
 
-  ivkImageMemoryBarrier(wrapper2.cmdBuf_,
-                        srcImage,
-                        VK_ACCESS_TRANSFER_READ_BIT, // srcAccessMask
-                        0, // dstAccessMask
-                        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-                        layout,
-                        VK_PIPELINE_STAGE_TRANSFER_BIT, // srcStageMask
-                        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, // dstStageMask
-                        VkImageSubresourceRange{VK_IMAGE_ASPECT_COLOR_BIT, level, 1, layer, 1});
+void VulkanStagingDevice::transitionToShaderReadOnly(VkCommandBuffer cmdBuf, const VulkanImage& image, const VkImageSubresourceRange& range) {
+  if (!useTransferQueue_ || image.isConcurrent_) {
+    ivkImageMemoryBarrier(cmdBuf,
+                          image.getVkImage(),
+                          VK_ACCESS_TRANSFER_READ_BIT, // VK_ACCESS_TRANSFER_WRITE_BIT,
+                          VK_ACCESS_SHADER_READ_BIT,
+                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                          VK_PIPELINE_STAGE_TRANSFER_BIT,
+                          VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                          range);
+    return;
+  }
 
-  fenceId = immediate_->submit(wrapper2);
-  outstandingFences_[fenceId.handle()] = desc;
+  // release the image from the transfer queue; the matching acquire barrier is recorded in acquirePendingOwnership()
+  ivkImageOwnershipBarrier(cmdBuf,
+                           image.getVkImage(),
+                           VK_ACCESS_TRANSFER_WRITE_BIT,
+                           0,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                           VK_PIPELINE_STAGE_TRANSFER_BIT,
+                           VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                           range,
+                           ctx_.deviceQueues_.transferQueueFamilyIndex,
+                           ctx_.deviceQueues_.graphicsQueueFamilyIndex);
+
+  pendingImageAcquires_.push_back({image.getVkImage(), range});
+}
+
+void VulkanStagingDevice::acquirePendingOwnership() {
+  submitPendingUploads();
+
+  if (!useTransferQueue_ || !hasPendingUploads_) {
+    return;
+  }
+
+  IGL_PROFILER_FUNCTION();
+
+  VulkanImmediateCommands& graphics = *ctx_.immediate_;
+
+  // the transfer timeline covers all outstanding uploads; uploaded data can be consumed by any stage
+  graphics.waitTimelineSemaphore(immediate_->getTimelineSemaphore(), immediate_->getLastSignaledValue(), VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT);
+
+  auto& wrapper = graphics.acquire();
+
+  for (const PendingImageAcquire& p : pendingImageAcquires_) {
+    ivkImageOwnershipBarrier(wrapper.cmdBuf_,
+                             p.image,
+                             0,
+                             VK_ACCESS_SHADER_READ_BIT,
+                             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, // chained with the timeline semaphore wait
+                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                             p.range,
+                             ctx_.deviceQueues_.transferQueueFamilyIndex,
+                             ctx_.deviceQueues_.graphicsQueueFamilyIndex);
+  }
+
+  graphics.submit(wrapper);
+
+  pendingImageAcquires_.clear();
+  hasPendingUploads_ = false;
+}
+
+VulkanImmediateCommands& VulkanStagingDevice::getReadbackCommands() {
+  if (!useTransferQueue_) {
+    submitPendingUploads();
+    return *immediate_;
+  }
+
+  // resources are owned by the graphics queue: read them back there after all pending uploads
+  acquirePendingOwnership();
+
+  return *ctx_.immediate_;
 }
 
 uint32_t VulkanStagingDevice::getAlignedSize(uint32_t size) const {
   return (size + stagingBufferAlignment_ - 1) & ~(stagingBufferAlignment_ - 1);
 }
 
-VulkanStagingDevice::MemoryRegionDesc VulkanStagingDevice::getNextFreeOffset(uint32_t size) {
+VulkanStagingDevice::StagingRegion& VulkanStagingDevice::allocate(StagingRing& ring, uint32_t size, uint32_t minSize) {
   IGL_PROFILER_FUNCTION();
-  uint32_t alignedSize = getAlignedSize(size);
 
-  // track maximum previously used region
-  MemoryRegionDesc maxRegionDesc;
-  SubmitHandle maxRegionFence = SubmitHandle();
+  const uint32_t alignedSize = getAlignedSize(size);
 
-  // check if we can reuse any of previously used memory region
-  for (auto [handle, desc] : outstandingFences_) {
-    if (immediate_->isReady(SubmitHandle(handle))) {
-      if (desc.alignedSize_ >= alignedSize) {
-        outstandingFences_.erase(handle);
-#if IGL_VULKAN_DEBUG_STAGING_DEVICE
-        LLOGL("Reusing memory region %u bytes\n", desc.alignedSize_);
-#endif
-        return desc;
-      }
+  IGL_ASSERT(alignedSize <= ring.size);
 
-      if (maxRegionDesc.alignedSize_ < desc.alignedSize_) {
-        maxRegionDesc = desc;
-        maxRegionFence = SubmitHandle(handle);
-      }
-    }
-  }
+  minSize = std::min(alignedSize, getAlignedSize(minSize));
 
-  if (!maxRegionFence.empty() && bufferCapacity_ < maxRegionDesc.alignedSize_) {
-    outstandingFences_.erase(maxRegionFence.handle());
+  retireRegions(ring);
+
+  uint32_t offset = 0;
+  uint32_t allocatedSize = 0;
+
+  while (!(allocatedSize = tryAllocate(ring, alignedSize, minSize, offset))) {
+    // not enough contiguous space: wait only for the oldest region to retire, never for everything
+    ring.stats.numStalls++;
 #if IGL_VULKAN_DEBUG_STAGING_DEVICE
-    LLOGL("Reusing memory region %u bytes\n", maxRegionDesc.alignedSize_);
+    LLOGL("StagingDevice - waiting for %u bytes (%u bytes in flight)\n", alignedSize, ring.stats.bytesInFlight);
 #endif
-    return maxRegionDesc;
+    waitOldestRegion(ring);
+  }
+
+  ring.head = offset + allocatedSize;
+  ring.stats.bytesInFlight += allocatedSize;
+
+  ring.regions.push_back({offset, allocatedSize});
+
+  return ring.regions.back();
+}
+
+void VulkanStagingDevice::shrinkLastRegion(StagingRing& ring, StagingRegion& region, uint32_t size) {
+  IGL_ASSERT(&region == &ring.regions.back());
+
+  const uint32_t alignedSize = getAlignedSize(size);
+
+  IGL_ASSERT(alignedSize <= region.size_);
+
+  ring.stats.bytesInFlight -= region.size_ - alignedSize;
+  region.size_ = alignedSize;
+  ring.head = region.offset_ + alignedSize;
+}
+
+uint32_t VulkanStagingDevice::tryAllocate(StagingRing& ring, uint32_t size, uint32_t minSize, uint32_t& outOffset) {
+  if (ring.regions.empty()) {
+    ring.head = 0;
+    outOffset = 0;
+    return size;
   }
 
-  if (bufferCapacity_ == 0) {
-    // no more space available in the staging buffer
-    flushOutstandingFences();
+  const uint32_t tail = ring.regions.front().offset_;
+
+  if (ring.head > tail) {
+    // used: [tail, head), free: [head, end) and [0, tail)
+    const uint32_t endSize = ring.size - ring.head;
+
+    if (endSize >= minSize) {
+      outOffset = ring.head;
+      return std::min(size, endSize);
+    }
+
+    if (std::min(size, tail) < minSize) {
+      return 0;
+    }
+
+    // wrap around: the tail space retires together with the last region
+    ring.regions.back().size_ += endSize;
+    ring.stats.bytesInFlight += endSize;
+    ring.stats.wastedTailBytes += endSize;
+
+    outOffset = 0;
+    return std::min(size, tail);
   }
 
-  // allocate from free staging memory
-  alignedSize = (alignedSize <= bufferCapacity_) ? alignedSize : bufferCapacity_;
-  const uint32_t srcOffset = stagingBufferFrontOffset_;
-  stagingBufferFrontOffset_ = (stagingBufferFrontOffset_ + alignedSize) % stagingBufferSize_;
-  bufferCapacity_ -= alignedSize;
+  // wrapped around, used: [tail, end) and [0, head), free: [head, tail)
+  const uint32_t freeSize = tail - ring.head;
 
-#if IGL_VULKAN_DEBUG_STAGING_DEVICE
-  LLOGL("Allocating new memory region: %u bytes\n", alignedSize);
-#endif
+  if (freeSize < minSize) {
+    return 0;
+  }
+
+  outOffset = ring.head;
+  return std::min(size, freeSize);
+}
 
-  return {srcOffset, alignedSize};
+void VulkanStagingDevice::retireRegions(StagingRing& ring) {
+  // regions retire in allocation order: only the oldest ones can be reused
+  while (!ring.regions.empty() && !ring.regions.front().isHostReadPending_ && ring.immediate->isReady(ring.regions.front().handle_)) {
+    ring.stats.bytesInFlight -= ring.regions.front().size_;
+    ring.regions.pop_front();
+  }
 }
 
-void VulkanStagingDevice::flushOutstandingFences() {
+void VulkanStagingDevice::waitOldestRegion(StagingRing& ring) {
   IGL_PROFILER_FUNCTION_COLOR(IGL_PROFILER_COLOR_WAIT);
+  IGL_ASSERT(!ring.regions.empty());
 
-#if IGL_VULKAN_DEBUG_STAGING_DEVICE
-  LLOGL("StagingDevice - Wait for Idle\n");
-#endif
-  std::for_each(outstandingFences_.begin(), outstandingFences_.end(), [this](std::pair<uint64_t, MemoryRegionDesc> const& pair) {
-    immediate_->wait(SubmitHandle(pair.first));
-  });
+  const SubmitHandle handle = ring.regions.front().handle_;
+
+  if (ring.immediate->isEncoding(handle)) {
+    // the oldest region is used by commands which have not been submitted yet
+    if (pendingUploads_ && pendingUploads_->handle_.handle() == handle.handle()) {
+      submitPendingUploads();
+    }
+    if (imageUploads_ && imageUploads_->handle_.handle() == handle.handle()) {
+      submitImageUploads();
+    }
+  }
+
+  ring.immediate->wait(handle);
+
+  if (&ring == &readbacks_) {
+    processDownloads();
+  }
 
-  outstandingFences_.clear();
-  stagingBufferFrontOffset_ = 0;
-  bufferCapacity_ = stagingBufferSize_;
+  retireRegions(ring);
 }
 
 } // namespace vulkan
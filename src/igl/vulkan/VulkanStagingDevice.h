@@ -7,11 +7,14 @@
 
 #pragma once
 
+#include <deque>
+#include <functional>
 #include <memory>
-#include <unordered_map>
+#include <vector>
 
 #include <igl/vulkan/Common.h>
 #include <igl/vulkan/VulkanHelpers.h>
+#include <igl/vulkan/VulkanImmediateCommands.h>
 
 namespace lvk {
 namespace vulkan {
@@ -19,7 +22,6 @@ namespace vulkan {
 class VulkanBuffer;
 class VulkanContext;
 class VulkanImage;
-class VulkanImmediateCommands;
 
 class VulkanStagingDevice final {
  public:
@@ -29,8 +31,8 @@ class VulkanStagingDevice final {
   VulkanStagingDevice(const VulkanStagingDevice&) = delete;
   VulkanStagingDevice& operator=(const VulkanStagingDevice&) = delete;
 
-  void bufferSubData(VulkanBuffer& buffer, size_t dstOffset, size_t size, const void* data);
-  void getBufferSubData(VulkanBuffer& buffer, size_t srcOffset, size_t size, void* data);
+  // non-blocking: copies are coalesced into one command buffer which is submitted by submitPendingUploads()
+  lvk::SubmitHandle bufferSubData(VulkanBuffer& buffer, size_t dstOffset, size_t size, const void* data);
   void imageData2D(VulkanImage& image,
                    const VkRect2D& imageRegion,
                    uint32_t baseMipLevel,
@@ -40,35 +42,131 @@ class VulkanStagingDevice final {
                    VkFormat format,
                    const void* data[]);
   void imageData3D(VulkanImage& image, const VkOffset3D& offset, const VkExtent3D& extent, VkFormat format, const void* data);
-  void getImageData2D(VkImage srcImage,
-                      const uint32_t level,
-                      const uint32_t layer,
-                      const VkRect2D& imageRegion,
-                      VkFormat format,
-                      VkImageLayout layout,
-                      void* data,
-                      uint32_t dataBytesPerRow,
-                      bool flipImageVertical);
+
+  // non-blocking readbacks into a host-cached ring: `data` is written once the GPU has finished, when processDownloads()
+  // observes it (isReady(), wait() and every Device::submit() call it); the completion handler is invoked right after that
+  lvk::SubmitHandle getBufferSubData(VulkanBuffer& buffer,
+                                     size_t srcOffset,
+                                     size_t size,
+                                     void* data,
+                                     std::function<void()>&& completionHandler = nullptr);
+  lvk::SubmitHandle getImageData2D(VkImage srcImage,
+                                   const uint32_t level,
+                                   const uint32_t layer,
+                                   const VkRect2D& imageRegion,
+                                   VkFormat format,
+                                   VkImageLayout layout,
+                                   void* data,
+                                   bool flipImageVertical,
+                                   std::function<void()>&& completionHandler = nullptr);
+  // the largest image region getImageData2D() can read back (the size of the readback ring)
+  uint32_t getMaxImageReadbackSize() const;
+  void processDownloads();
+
+  struct Stats {
+    uint32_t bytesInFlight = 0; // allocated staging memory which has not been retired yet (including wasted tail space)
+    uint32_t numStalls = 0; // allocations which had to wait for the GPU
+    uint64_t wastedTailBytes = 0; // total bytes skipped at the end of the ring on wrap-around
+  };
+
+  Stats getStats() const {
+    return uploads_.stats;
+  }
+  Stats getReadbackStats() const {
+    return readbacks_.stats;
+  }
+
+  bool isReady(lvk::SubmitHandle handle);
+  void wait(lvk::SubmitHandle handle);
+
+  // submits pending buffer uploads; dedicated transfer queue: make the graphics queue wait for all submitted uploads and
+  // acquire ownership of uploaded images
+  void acquirePendingOwnership();
 
  private:
-  struct MemoryRegionDesc {
-    uint32_t srcOffset_ = 0;
-    uint32_t alignedSize_ = 0;
+  // staging memory is a ring buffer: regions are allocated at the head and retired from the tail in allocation order
+  struct StagingRegion {
+    uint32_t offset_ = 0;
+    uint32_t size_ = 0;
+    VulkanImmediateCommands::SubmitHandle handle_ = {}; // the command buffer using this region (empty - no longer used by the GPU)
+    bool isHostReadPending_ = false; // readbacks: the data has not been copied out yet
+  };
+
+  struct StagingRing {
+    BufferHandle buffer;
+    uint32_t size = 0;
+    VulkanImmediateCommands* immediate = nullptr; // submits the command buffers which use the regions
+    std::deque<StagingRegion> regions; // in flight, in allocation order
+    uint32_t head = 0; // the next free byte
+    Stats stats;
   };
 
   uint32_t getAlignedSize(uint32_t size) const;
-  MemoryRegionDesc getNextFreeOffset(uint32_t size);
-  void flushOutstandingFences();
+  // stalls only until the oldest regions retire if there is not enough space
+  // a smaller region (at least `minSize`) can be returned if `minSize` is less than `size`
+  StagingRegion& allocate(StagingRing& ring, uint32_t size, uint32_t minSize);
+  StagingRegion& allocate(StagingRing& ring, uint32_t size) {
+    return allocate(ring, size, size);
+  }
+  void shrinkLastRegion(StagingRing& ring, StagingRegion& region, uint32_t size);
+  uint32_t tryAllocate(StagingRing& ring, uint32_t size, uint32_t minSize, uint32_t& outOffset);
+  void retireRegions(StagingRing& ring);
+  void waitOldestRegion(StagingRing& ring);
+  void createReadbackRing();
+  void submitPendingUploads();
+  // the next submit of immediate_ waits for all work submitted to the graphics and compute queues
+  void waitForOtherQueues();
+  // streams a tightly packed box of texels of one mip level and layer through the staging ring in bands of rows or slices
+  void imageBoxData(VulkanImage& image,
+                    uint32_t mipLevel,
+                    uint32_t layer,
+                    const VkOffset3D& offset,
+                    const VkExtent3D& extent,
+                    lvk::Format format,
+                    const uint8_t* data);
+  // VK_EXT_host_image_copy: the CPU writes texels directly, no staging memory and no command buffers
+  bool canCopyMemoryToImage(const VulkanImage& image, const VkImageSubresourceRange& range) const;
+  void copyMemoryToImage(VulkanImage& image, const VkImageSubresourceRange& range); // copies hostImageCopies_
+  const VulkanImmediateCommands::CommandBufferWrapper& acquireImageUploads();
+  void submitImageUploads();
+  // keeps the existing contents unless `discardContents` is set
+  void transitionToTransferDst(const VulkanImage& image, const VkImageSubresourceRange& range, bool discardContents);
+  void transitionToShaderReadOnly(VkCommandBuffer cmdBuf, const VulkanImage& image, const VkImageSubresourceRange& range);
+  VulkanImmediateCommands& getReadbackCommands();
 
  private:
   VulkanContext& ctx_;
-  BufferHandle stagingBuffer_;
-  std::unique_ptr<VulkanImmediateCommands> immediate_;
-  uint32_t stagingBufferFrontOffset_ = 0;
+  std::unique_ptr<VulkanImmediateCommands> immediate_; // uploads (on the dedicated transfer queue if available)
+  bool useTransferQueue_ = false;
+  bool hasPendingUploads_ = false; // uploads the graphics queue has not yet waited for
+  struct PendingImageAcquire {
+    VkImage image = VK_NULL_HANDLE;
+    VkImageSubresourceRange range = {};
+  };
+  std::vector<PendingImageAcquire> pendingImageAcquires_;
+  // buffer uploads recorded by bufferSubData() but not yet submitted
+  struct PendingBufferCopy {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkBufferCopy region = {};
+  };
+  const VulkanImmediateCommands::CommandBufferWrapper* pendingUploads_ = nullptr;
+  std::vector<PendingBufferCopy> pendingBufferCopies_;
+  std::vector<VkBufferCopy> copyRegions_; // scratch
+  // an image upload can be split across several command buffers if it does not fit into the staging buffer
+  const VulkanImmediateCommands::CommandBufferWrapper* imageUploads_ = nullptr;
+  std::vector<VkMemoryToImageCopyEXT> hostImageCopies_; // scratch
   uint32_t stagingBufferAlignment_ = 16; // updated to support BC7 compressed image
-  uint32_t stagingBufferSize_;
-  uint32_t bufferCapacity_;
-  std::unordered_map<uint64_t, MemoryRegionDesc> outstandingFences_;
+  StagingRing uploads_;
+  StagingRing readbacks_; // created on the first readback
+  struct PendingDownload {
+    VulkanImmediateCommands::SubmitHandle handle;
+    StagingRegion* region = nullptr;
+    uint8_t* data = nullptr;
+    uint32_t size = 0;
+    uint32_t flipRowSize = 0; // flip rows of this size vertically (0 - no flip)
+    std::function<void()> completionHandler; // only the last chunk of a download has one
+  };
+  std::deque<PendingDownload> pendingDownloads_; // in submission order
 };
 
 } // namespace vulkan
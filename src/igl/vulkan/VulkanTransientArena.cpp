@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <igl/vulkan/VulkanTransientArena.h>
+
+#include <igl/vulkan/VulkanBuffer.h>
+#include <igl/vulkan/VulkanContext.h>
+
+namespace lvk {
+namespace vulkan {
+
+VulkanTransientArena::VulkanTransientArena(VulkanContext& ctx, uint32_t sizePerFrame, uint32_t numFrames) :
+  ctx_(ctx), sizePerFrame_(sizePerFrame), frameHandles_(numFrames), frameHandlesCompute_(numFrames) {
+  IGL_PROFILER_FUNCTION();
+
+  IGL_ASSERT(sizePerFrame_ && numFrames);
+
+  const VkDeviceSize size = VkDeviceSize(sizePerFrame_) * numFrames;
+
+  // the CPU writes every byte once per frame: video memory via Resizable BAR if it has room, otherwise write-combined host memory
+  const bool isReBar = ctx_.reserveReBarMemory(size);
+
+  const VkMemoryPropertyFlags memFlags =
+      isReBar ? VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+              : VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+
+  Result result;
+  buffer_ = ctx_.createBuffer(size,
+                              VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                                  VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                              memFlags,
+                              &result,
+                              "Buffer: transient arena");
+  if (!IGL_VERIFY(result.isOk())) {
+    if (isReBar) {
+      ctx_.releaseReBarMemory(size);
+    }
+    return;
+  }
+
+  const VulkanBuffer* buf = ctx_.buffersPool_.get(buffer_);
+
+  mappedPtr_ = buf->getMappedPtr();
+  gpuAddress_ = buf->getVkDeviceAddress();
+
+  IGL_ASSERT(mappedPtr_ && gpuAddress_);
+}
+
+VulkanTransientArena::~VulkanTransientArena() {
+  if (!buffer_.empty()) {
+    ctx_.buffersPool_.destroy(buffer_);
+  }
+}
+
+lvk::TransientAllocation VulkanTransientArena::allocate(size_t size, size_t alignment) {
+  IGL_ASSERT_MSG(alignment && (alignment & (alignment - 1)) == 0, "The alignment should be a power of 2");
+
+  if (!mappedPtr_) {
+    return {};
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // the first allocation in this frame: the region might still be used by the GPU (normally the swapchain throttles us)
+  VulkanImmediateCommands::SubmitHandle& handle = frameHandles_[currentFrame_];
+  if (!handle.empty()) {
+    ctx_.immediate_->wait(handle);
+    handle = {};
+  }
+  VulkanImmediateCommands::SubmitHandle& handleCompute = frameHandlesCompute_[currentFrame_];
+  if (!handleCompute.empty()) {
+    ctx_.immediateCompute_->wait(handleCompute);
+    handleCompute = {};
+  }
+
+  const size_t offset = (currentOffset_ + alignment - 1) & ~(alignment - 1);
+
+  if (offset + size > sizePerFrame_) {
+    IGL_ASSERT_MSG(false, "The transient arena is exhausted: increase VulkanContextConfig::transientArenaSizePerFrame");
+    return {};
+  }
+
+  currentOffset_ = uint32_t(offset + size);
+
+  const size_t bufferOffset = size_t(currentFrame_) * sizePerFrame_ + offset;
+
+  return {
+      .ptr = mappedPtr_ + bufferOffset,
+      .gpuAddress = gpuAddress_ + bufferOffset,
+      .buffer = buffer_,
+      .offset = bufferOffset,
+  };
+}
+
+void VulkanTransientArena::flush() {
+  if (!mappedPtr_) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  const VulkanBuffer* buf = ctx_.buffersPool_.get(buffer_);
+
+  if (!buf->isCoherentMemory() && currentOffset_ > flushedOffset_) {
+    buf->flushMappedMemory(VkDeviceSize(currentFrame_) * sizePerFrame_ + flushedOffset_, currentOffset_ - flushedOffset_);
+  }
+
+  flushedOffset_ = currentOffset_;
+}
+
+void VulkanTransientArena::endFrame(VulkanImmediateCommands::SubmitHandle handle, VulkanImmediateCommands::SubmitHandle handleCompute) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (currentOffset_) {
+    frameHandles_[currentFrame_] = handle;
+    frameHandlesCompute_[currentFrame_] = handleCompute;
+  }
+
+  currentFrame_ = (currentFrame_ + 1) % (uint32_t)frameHandles_.size();
+  currentOffset_ = 0;
+  flushedOffset_ = 0;
+}
+
+} // namespace vulkan
+} // namespace lvk
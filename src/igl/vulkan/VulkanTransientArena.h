@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include <igl/vulkan/Common.h>
+#include <igl/vulkan/VulkanImmediateCommands.h>
+
+namespace lvk {
+namespace vulkan {
+
+class VulkanContext;
+
+// frame-scoped linear allocator for per-frame data (i.e. uniforms): one persistently mapped buffer split into per-frame
+// regions; a region is recycled when the GPU has finished the frame which used it
+// thread-safe: allocations can be made while recording command buffers on different threads
+class VulkanTransientArena final {
+ public:
+  VulkanTransientArena(VulkanContext& ctx, uint32_t sizePerFrame, uint32_t numFrames);
+  ~VulkanTransientArena();
+  VulkanTransientArena(const VulkanTransientArena&) = delete;
+  VulkanTransientArena& operator=(const VulkanTransientArena&) = delete;
+
+  // returns an empty allocation if the current frame's region is exhausted
+  lvk::TransientAllocation allocate(size_t size, size_t alignment);
+  // makes the CPU writes of the current frame visible to the GPU (non-coherent memory only)
+  void flush();
+  // the current frame has been submitted: its region is reused after `handle` (and `handleCompute`) have retired
+  void endFrame(VulkanImmediateCommands::SubmitHandle handle, VulkanImmediateCommands::SubmitHandle handleCompute = {});
+
+ private:
+  VulkanContext& ctx_;
+  BufferHandle buffer_;
+  uint8_t* mappedPtr_ = nullptr;
+  uint64_t gpuAddress_ = 0;
+  uint32_t sizePerFrame_ = 0;
+  std::vector<VulkanImmediateCommands::SubmitHandle> frameHandles_; // the last submit which used each region
+  std::vector<VulkanImmediateCommands::SubmitHandle> frameHandlesCompute_; // the same for VulkanContext::immediateCompute_
+  uint32_t currentFrame_ = 0;
+  uint32_t currentOffset_ = 0; // within the current region
+  uint32_t flushedOffset_ = 0;
+  std::mutex mutex_;
+};
+
+} // namespace vulkan
+} // namespace lvk